@@ -0,0 +1,98 @@
+// throughput of the shared CSV reader and writer on synthetic task rows.
+// usage: csv_bench [megabytes] [rounds]
+#include "csv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// rows shaped like data/tasks.csv, every 8th one with an escaped quote and
+// every 16th with a comma, so both reader paths are exercised
+static char* make_input(size_t target, size_t* size, long* rows) {
+    char* buf = malloc(target + 256);
+    if (!buf) return NULL;
+    size_t len = (size_t)sprintf(buf, "head_name,description,completed\n");
+    long n = 0;
+    while (len < target) {
+        const char* extra = (n % 8 == 0) ? " \"\"urgent\"\"" : (n % 16 == 1) ? ", later" : "";
+        len += (size_t)sprintf(buf + len, "\"head %ld\",\"task number %ld%s\",%ld\n", n % 50, n, extra, n % 2);
+        n++;
+    }
+    *size = len;
+    *rows = n;
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 64;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    if (megabytes == 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [megabytes] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    size_t size;
+    long rows;
+    char* input = make_input(megabytes << 20, &size, &rows);
+    char* work = malloc(size);
+    if (!input || !work) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    double mb = size / (1024.0 * 1024.0);
+
+    // reading unescapes in place, so every round parses a fresh copy
+    double best_read = 0;
+    long checksum = 0;
+    for (int r = 0; r < rounds; r++) {
+        memcpy(work, input, size);
+        CsvReader csv;
+        csv_from_buffer(&csv, work, size);
+        double start = now_sec();
+        int fields;
+        while ((fields = csv_next(&csv)) >= 0) {
+            if (fields > 2) checksum += csv_field_long(csv.fields[2]) + (long)csv.fields[1].len;
+        }
+        double elapsed = now_sec() - start;
+        if (best_read == 0 || elapsed < best_read) best_read = elapsed;
+    }
+
+    // writes the same rows back out byte for byte, quoting included
+    FILE* sink = fopen("/dev/null", "w");
+    if (!sink) return 1;
+    double best_write = 0;
+    for (int r = 0; r < rounds; r++) {
+        CsvWriter w;
+        csv_writer_init(&w, sink);
+        char head[32], text[64];
+        double start = now_sec();
+        fputs("head_name,description,completed\n", sink);
+        for (long i = 0; i < rows; i++) {
+            const char* extra = (i % 8 == 0) ? " \"urgent\"" : (i % 16 == 1) ? ", later" : "";
+            snprintf(head, sizeof(head), "head %ld", i % 50);
+            snprintf(text, sizeof(text), "task number %ld%s", i, extra);
+            csv_write_text(&w, head);
+            csv_write_text(&w, text);
+            csv_write_long(&w, i % 2);
+            csv_end_record(&w);
+        }
+        fflush(sink);
+        double elapsed = now_sec() - start;
+        if (best_write == 0 || elapsed < best_write) best_write = elapsed;
+    }
+    fclose(sink);
+
+    printf("input: %.1f MB, %ld rows, best of %d rounds (checksum %ld)\n", mb, rows, rounds, checksum);
+    printf("read:  %8.1f MB/s  %8.1f Mrows/s\n", mb / best_read, rows / best_read / 1e6);
+    printf("write: %8.1f MB/s  %8.1f Mrows/s\n", mb / best_write, rows / best_write / 1e6);
+
+    free(work);
+    free(input);
+    return 0;
+}
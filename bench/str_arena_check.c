@@ -0,0 +1,31 @@
+// interns the first string into an empty StrArena at every length up to 64
+// (7, 15, 31 and 63 fill a capacity step exactly once the "" at offset 0
+// is counted) and checks each one fits and reads back. exits 1 on a miss;
+// build with -fsanitize=address to catch any write past the buffer.
+// usage: str_arena_check
+#include "str_arena.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool check_first(int len) {
+    char text[65];
+    memset(text, 'a' + len % 26, (size_t)len);
+    text[len] = '\0';
+
+    Arena arena = {0};
+    StrArena sa;
+    str_arena_init(&sa, &arena);
+    StrRef ref = str_intern(&sa, text);
+    bool ok = ref.length == (uint32_t)len && sa.used <= sa.capacity &&
+              strcmp(str_get(&sa, ref), text) == 0 && str_get(&sa, (StrRef){0, 0})[0] == '\0';
+    arena_reset(&arena);
+    if (!ok) fprintf(stderr, "str_arena_check: first string of length %d\n", len);
+    return ok;
+}
+
+int main(void) {
+    int failed = 0;
+    for (int len = 1; len <= 64; len++) failed += !check_first(len);
+    printf("str_arena_check: %s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
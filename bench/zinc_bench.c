@@ -0,0 +1,311 @@
+// end to end timings on synthetic data: loading (CSV and cache), saving,
+// keypress navigation and full frames against the headless terminal, for
+// datasets of 10, 100, ... up to max_rows rows, plus the bytes and cells
+// each navigation frame sends. results go out as JSON with percentiles so
+// runs can be compared; a summary goes to stderr.
+// usage: zinc_bench [max_rows] [out.json]
+#include "habit_manager.h"
+#include "headless.h"
+#include "imodule.h"
+#include "minimal_tui.h"
+#include "task_manager.h"
+#include <ncurses.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_RESULTS 128
+#define NAV_KEYS 2000
+#define RENDER_FRAMES 100
+
+typedef struct {
+    char name[32];
+    const char* unit; // "ns", "bytes" or "cells"
+    long rows;
+    int samples;
+    uint64_t min, p50, p90, p99, max;
+    double mean;
+} BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static int result_count;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// nearest rank on sorted samples
+static uint64_t percentile(const uint64_t* sorted, int n, int pct) {
+    int rank = (pct * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void record_unit(const char* name, const char* unit, long rows, uint64_t* samples, int n) {
+    if (result_count == MAX_RESULTS || n == 0) return;
+    qsort(samples, n, sizeof(uint64_t), compare_u64);
+    BenchResult* r = &results[result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->unit = unit;
+    r->rows = rows;
+    r->samples = n;
+    r->min = samples[0];
+    r->p50 = percentile(samples, n, 50);
+    r->p90 = percentile(samples, n, 90);
+    r->p99 = percentile(samples, n, 99);
+    r->max = samples[n - 1];
+    double total = 0;
+    for (int i = 0; i < n; i++) total += (double)samples[i];
+    r->mean = total / n;
+    if (strcmp(unit, "ns") == 0) {
+        fprintf(stderr, "%-20s %8ld rows  p50 %12.3f us  p99 %12.3f us  (%d samples)\n",
+                name, rows, r->p50 / 1e3, r->p99 / 1e3, n);
+    } else {
+        fprintf(stderr, "%-20s %8ld rows  p50 %10llu %-5s p99 %10llu %-5s (%d samples)\n",
+                name, rows, (unsigned long long)r->p50, unit, (unsigned long long)r->p99, unit, n);
+    }
+}
+
+static void record(const char* name, long rows, uint64_t* samples, int n) {
+    record_unit(name, "ns", rows, samples, n);
+}
+
+// --- Synthetic data ---
+// 50 items per head; every 8th text has a quote or a comma to escape
+
+static void write_tasks(long rows) {
+    FILE* f = fopen("data/tasks.csv", "w");
+    if (!f) return;
+    fprintf(f, "head_name,description,completed\n");
+    for (long i = 0; i < rows; i++) {
+        const char* extra = (i % 8 == 0) ? " \"\"urgent\"\"" : (i % 8 == 4) ? ", later" : "";
+        fprintf(f, "\"project %ld\",\"task number %ld%s\",%ld\n", i / 50, i, extra, i % 3 == 0 ? 1L : 0L);
+    }
+    fclose(f);
+}
+
+// a few weeks of history per habit, broken up so the ranges vary
+static void write_habits(long rows) {
+    FILE* f = fopen("data/habits.csv", "w");
+    if (!f) return;
+    fprintf(f, "head_name,task_name,streak,done_today,history\n");
+    for (long i = 0; i < rows; i++) {
+        int gap = (int)(i % 5) + 1;
+        fprintf(f, "\"area %ld\",\"habit number %ld\",0,0,\"2025-01-01..2025-01-%02d 2025-02-%02d..2025-03-01\"\n",
+                i / 50, i, 10 + gap, 10 + gap * 3);
+    }
+    fclose(f);
+}
+
+static int sample_count(long rows) {
+    long n = 2000000 / (rows > 0 ? rows : 1);
+    return n < 3 ? 3 : n > 50 ? 50 : (int)n;
+}
+
+// --- Benchmarks ---
+
+static void bench_load_save(long rows) {
+    int n = sample_count(rows);
+    uint64_t* samples = malloc((size_t)n * sizeof(uint64_t));
+    if (!samples) return;
+
+    // parsing the CSV includes writing the cache for the next start
+    for (int i = 0; i < n; i++) {
+        unlink("data/tasks.cache");
+        uint64_t start = now_ns();
+        tasks_load("data/tasks.csv");
+        samples[i] = now_ns() - start;
+        tasks_close();
+    }
+    record("tasks_load_csv", rows, samples, n);
+    for (int i = 0; i < n; i++) {
+        uint64_t start = now_ns();
+        tasks_load("data/tasks.csv");
+        samples[i] = now_ns() - start;
+        tasks_close();
+    }
+    record("tasks_load_cache", rows, samples, n);
+
+    for (int i = 0; i < n; i++) {
+        unlink("data/habits.cache");
+        uint64_t start = now_ns();
+        habits_load("data/habits.csv");
+        samples[i] = now_ns() - start;
+        habits_close();
+    }
+    record("habits_load_csv", rows, samples, n);
+    for (int i = 0; i < n; i++) {
+        uint64_t start = now_ns();
+        habits_load("data/habits.csv");
+        samples[i] = now_ns() - start;
+        habits_close();
+    }
+    record("habits_load_cache", rows, samples, n);
+
+    // the loaded file, so a save also resets the journal and rewrites the cache
+    tasks_load("data/tasks.csv");
+    habits_load("data/habits.csv");
+    for (int i = 0; i < n; i++) {
+        uint64_t start = now_ns();
+        tasks_save("data/tasks.csv");
+        samples[i] = now_ns() - start;
+    }
+    record("tasks_save", rows, samples, n);
+    for (int i = 0; i < n; i++) {
+        uint64_t start = now_ns();
+        habits_save("data/habits.csv");
+        samples[i] = now_ns() - start;
+    }
+    record("habits_save", rows, samples, n);
+    free(samples);
+}
+
+// expects both modules loaded
+static void bench_ui(long rows) {
+    MinimalTui tui;
+    minimal_tui_init(&tui);
+    uint64_t* samples = malloc(NAV_KEYS * sizeof(uint64_t));
+    uint64_t* bytes = malloc(NAV_KEYS * sizeof(uint64_t));
+    uint64_t* cells = malloc(NAV_KEYS * sizeof(uint64_t));
+    if (!samples || !bytes || !cells) return;
+
+    // the Tasks entry, as it sits on the panel
+    int tasks_index = 1;
+    IModule* tasks = tui.modules[tasks_index];
+    minimal_tui_open_module(&tui, tasks_index);
+    minimal_tui_render(&tui);
+
+    // keypresses alone, then each followed by the frame it causes and what
+    // that frame puts on the wire (nothing when the frame was skipped)
+    for (int i = 0; i < NAV_KEYS; i++) {
+        int key = (i / 500) % 2 == 0 ? KEY_DOWN : KEY_UP;
+        InputAction action = key == KEY_DOWN ? ACTION_DOWN : ACTION_UP;
+        uint64_t start = now_ns();
+        tasks->handle_input(tasks, action, key, &tui);
+        samples[i] = now_ns() - start;
+    }
+    record("tasks_navigate", rows, samples, NAV_KEYS);
+    minimal_tui_render(&tui);
+    for (int i = 0; i < NAV_KEYS; i++) {
+        int key = (i / 500) % 2 == 0 ? KEY_DOWN : KEY_UP;
+        unsigned long frames = headless_stats()->frames;
+        uint64_t start = now_ns();
+        minimal_tui_handle_input(&tui, key);
+        minimal_tui_render(&tui);
+        samples[i] = now_ns() - start;
+        bool drawn = headless_stats()->frames != frames;
+        bytes[i] = drawn ? headless_stats()->last_bytes : 0;
+        cells[i] = drawn ? headless_stats()->last_cells : 0;
+    }
+    record("tasks_navigate_draw", rows, samples, NAV_KEYS);
+    record_unit("tasks_navigate_bytes", "bytes", rows, bytes, NAV_KEYS);
+    record_unit("tasks_navigate_cells", "cells", rows, cells, NAV_KEYS);
+
+    for (int i = 0; i < RENDER_FRAMES; i++) {
+        minimal_tui_invalidate(&tui);
+        uint64_t start = now_ns();
+        minimal_tui_render(&tui);
+        samples[i] = now_ns() - start;
+    }
+    record("tasks_render_full", rows, samples, RENDER_FRAMES);
+
+    minimal_tui_open_module(&tui, 0); // Habits
+    for (int i = 0; i < RENDER_FRAMES; i++) {
+        minimal_tui_invalidate(&tui);
+        uint64_t start = now_ns();
+        minimal_tui_render(&tui);
+        samples[i] = now_ns() - start;
+    }
+    record("habits_render_full", rows, samples, RENDER_FRAMES);
+
+    free(samples);
+    free(bytes);
+    free(cells);
+    minimal_tui_cleanup(&tui);
+}
+
+static void write_json(FILE* out, long max_rows) {
+    fprintf(out, "{\n  \"benchmark\": \"zinc\",\n  \"timestamp\": %ld,\n  \"max_rows\": %ld,\n",
+            (long)time(NULL), max_rows);
+    fprintf(out, "  \"terminal\": \"%dx%d\",\n  \"results\": [\n", LINES, COLS);
+    for (int i = 0; i < result_count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"unit\": \"%s\", \"rows\": %ld, \"samples\": %d, \"min\": %llu, "
+                     "\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu, \"mean\": %.0f}%s\n",
+                r->name, r->unit, r->rows, r->samples, (unsigned long long)r->min, (unsigned long long)r->p50,
+                (unsigned long long)r->p90, (unsigned long long)r->p99, (unsigned long long)r->max,
+                r->mean, i + 1 < result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void remove_data(void) {
+    const char* files[] = {
+        "data/tasks.csv", "data/tasks.cache", "data/tasks.journal",
+        "data/habits.csv", "data/habits.cache", "data/habits.journal",
+        "data/pomodoro.log",
+    };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) unlink(files[i]);
+    rmdir("data");
+}
+
+int main(int argc, char** argv) {
+    long max_rows = argc > 1 ? atol(argv[1]) : 1000000;
+    const char* out_path = argc > 2 ? argv[2] : NULL;
+    if (max_rows < 10) {
+        fprintf(stderr, "usage: %s [max_rows] [out.json]\n", argv[0]);
+        return 1;
+    }
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        perror(out_path);
+        return 1;
+    }
+
+    // everything runs in a scratch directory, the app's relative data/ paths included
+    char dir[] = "/tmp/zinc-bench-XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0 || mkdir("data", 0755) != 0) {
+        perror("scratch directory");
+        return 1;
+    }
+
+    // frames are drawn for a fixed size terminal, metered and thrown away
+    FILE* term_in = fopen("/dev/null", "r");
+    if (!term_in || !headless_init(50, 160, term_in)) {
+        fprintf(stderr, "no headless terminal (is TERM set to something terminfo knows?)\n");
+        return 1;
+    }
+    noecho();
+    curs_set(0);
+
+    for (long rows = 10; rows <= max_rows; rows *= 10) {
+        write_tasks(rows);
+        write_habits(rows);
+        bench_load_save(rows);
+        bench_ui(rows);
+        tasks_close();
+        habits_close();
+        tasks_cleanup();
+        habits_cleanup();
+    }
+
+    write_json(out, max_rows); // before endwin, LINES and COLS are still the bench's
+    endwin();
+    headless_cleanup();
+    fclose(term_in);
+    if (out != stdout) fclose(out);
+
+    remove_data();
+    rmdir(dir);
+    return 0;
+}
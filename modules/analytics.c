@@ -0,0 +1,65 @@
+#include "analytics.h"
+#include "history.h"
+#include "imodule.h"
+#include "pomodoro_manager.h"
+#include "session_log.h"
+#include <stdio.h>
+
+typedef struct {
+    const char* label;
+    int from;
+    int to;
+} AnalyticsRange;
+
+// "2h 05m", or just "35m" under an hour
+static void format_duration(char* buf, size_t size, int64_t seconds) {
+    long minutes = (long)(seconds / 60);
+    if (minutes >= 60) {
+        snprintf(buf, size, "%ldh %02ldm", minutes / 60, minutes % 60);
+    } else {
+        snprintf(buf, size, "%ldm", minutes);
+    }
+}
+
+void analytics_module_render(struct IModule* self, WINDOW* win) {
+    (void)self;
+    const SessionLog* log = pomodoro_session_log();
+    int today = history_today();
+    int year, month, mday;
+    history_date(today, &year, &month, &mday);
+    int weekday = ((today + 3) % 7 + 7) % 7; // 1970-01-01 was a thursday, monday is 0
+
+    AnalyticsRange ranges[] = {
+        {"Today", today, today},
+        {"This week", today - weekday, today},
+        {"Last 7 days", today - 6, today},
+        {"This month", history_day(year, month, 1), today},
+        {"Last 30 days", today - 29, today},
+        {"All time", log->first_day, today},
+    };
+
+    werase(win);
+    mvwprintw(win, 1, 2, "Time Analytics");
+    mvwprintw(win, 3, 4, "%-14s %10s %10s %9s", "", "Focus", "Rest", "Sessions");
+    int y = 4;
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        SessionTotals t = session_log_range(log, ranges[i].from, ranges[i].to);
+        char focus[32], rest[32];
+        format_duration(focus, sizeof(focus), t.work_seconds);
+        format_duration(rest, sizeof(rest), t.rest_seconds);
+        mvwprintw(win, y++, 4, "%-14s %10s %10s %9lld", ranges[i].label, focus, rest,
+                  (long long)t.work_sessions);
+    }
+    if (log->record_count == 0) {
+        mvwprintw(win, y + 1, 4, "No pomodoro sessions logged yet.");
+    }
+    mvwprintw(win, y + 3, 2, "[b] Back");
+    wnoutrefresh(win);
+}
+
+void analytics_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui) {
+    (void)self;
+    (void)action;
+    (void)key;
+    (void)tui;
+}
@@ -0,0 +1,14 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <ncurses.h>
+#include "imodule.h"
+
+struct MinimalTui;
+
+// the "Time Analytics" module: focus and rest totals from the pomodoro
+// session log. every figure is a range query on its prefix sums.
+void analytics_module_render(struct IModule* self, WINDOW* win);
+void analytics_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui);
+
+#endif
@@ -0,0 +1,97 @@
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ARENA_MIN_CAPACITY 8
+
+struct ArenaBlock {
+    ArenaBlock* prev;
+    ArenaBlock* next;
+    size_t size;
+    max_align_t align[]; // user data starts here, suitably aligned
+};
+
+static ArenaBlock* block_of(void* ptr) {
+    return (ArenaBlock*)((char*)ptr - offsetof(ArenaBlock, align));
+}
+
+static void link_block(Arena* arena, ArenaBlock* block) {
+    block->prev = NULL;
+    block->next = arena->blocks;
+    if (arena->blocks) arena->blocks->prev = block;
+    arena->blocks = block;
+}
+
+static void unlink_block(Arena* arena, ArenaBlock* block) {
+    if (block->prev) block->prev->next = block->next;
+    else arena->blocks = block->next;
+    if (block->next) block->next->prev = block->prev;
+}
+
+static void account(Arena* arena, size_t added, size_t removed) {
+    arena->reserved += added;
+    arena->reserved -= removed;
+    if (arena->reserved > arena->peak) arena->peak = arena->reserved;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + size);
+    if (!block) return NULL;
+    block->size = size;
+    link_block(arena, block);
+    arena->block_count++;
+    account(arena, sizeof(ArenaBlock) + size, 0);
+    return block->align;
+}
+
+void* arena_resize(Arena* arena, void* ptr, size_t size) {
+    if (!ptr) return arena_alloc(arena, size);
+
+    ArenaBlock* old = block_of(ptr);
+    size_t old_size = old->size;
+    unlink_block(arena, old);
+    ArenaBlock* block = realloc(old, sizeof(ArenaBlock) + size);
+    if (!block) {
+        link_block(arena, old);
+        return NULL;
+    }
+    block->size = size;
+    link_block(arena, block);
+    account(arena, size, old_size);
+    return block->align;
+}
+
+void arena_release(Arena* arena, void* ptr) {
+    if (!ptr) return;
+    ArenaBlock* block = block_of(ptr);
+    unlink_block(arena, block);
+    arena->block_count--;
+    account(arena, 0, sizeof(ArenaBlock) + block->size);
+    free(block);
+}
+
+void arena_reset(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->reserved = 0;
+    arena->block_count = 0;
+}
+
+void* arena_grow(Arena* arena, void* vec, int* capacity, int needed, size_t elem_size) {
+    if (vec && needed <= *capacity) return vec;
+
+    int new_capacity = *capacity > 0 ? *capacity : ARENA_MIN_CAPACITY;
+    while (new_capacity < needed) {
+        if (new_capacity > INT32_MAX / 2) return NULL;
+        new_capacity *= 2;
+    }
+    void* grown = arena_resize(arena, vec, (size_t)new_capacity * elem_size);
+    if (!grown) return NULL;
+    *capacity = new_capacity;
+    return grown;
+}
@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// a module's allocation zone. every block a module owns is linked into its
+// arena, so the module's footprint can be read off at any time and all of it
+// released in one go. blocks stay individually resizable, which is what the
+// growable item vectors need.
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* blocks;
+    size_t reserved;   // bytes currently held, headers included
+    size_t peak;
+    int block_count;
+} Arena;
+
+void* arena_alloc(Arena* arena, size_t size);
+// like realloc: NULL on failure, with the old block left untouched
+void* arena_resize(Arena* arena, void* ptr, size_t size);
+void arena_release(Arena* arena, void* ptr);
+// frees every block at once
+void arena_reset(Arena* arena);
+
+// makes room for at least `needed` elements in a vector, doubling its
+// capacity. returns the (possibly moved) vector, or NULL leaving it as it was.
+void* arena_grow(Arena* arena, void* vec, int* capacity, int needed, size_t elem_size);
+
+#endif
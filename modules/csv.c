@@ -0,0 +1,173 @@
+#include "csv.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int csv_open(CsvReader* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    // private and writable: unescaping copies only the pages it touches
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+        r->map = map;
+        r->data = map;
+        r->size = size;
+        close(fd);
+        return 0;
+    }
+
+    char* buf = malloc(size);
+    size_t got = 0;
+    while (buf && got < size) {
+        ssize_t n = read(fd, buf + got, size - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+    if (!buf) return 1;
+    r->data = buf;
+    r->size = got;
+    r->owned = true;
+    return 0;
+}
+
+void csv_from_buffer(CsvReader* r, char* data, size_t size) {
+    memset(r, 0, sizeof(*r));
+    r->data = data;
+    r->size = size;
+}
+
+void csv_close(CsvReader* r) {
+    if (r->map) munmap(r->map, r->size);
+    if (r->owned) free(r->data);
+    memset(r, 0, sizeof(*r));
+}
+
+// a quoted field starting after its opening quote. "" collapses to " by
+// shifting the rest of the field down, so fields without escapes are never
+// written to.
+static CsvField read_quoted(CsvReader* r) {
+    char* data = r->data;
+    size_t start = r->pos, out = r->pos, pos = r->pos;
+    while (pos < r->size) {
+        char c = data[pos];
+        if (c == '"') {
+            if (pos + 1 < r->size && data[pos + 1] == '"') {
+                data[out++] = '"';
+                pos += 2;
+                continue;
+            }
+            pos++; // closing quote
+            break;
+        }
+        if (out != pos) data[out] = c;
+        out++;
+        pos++;
+    }
+    // anything between the closing quote and the delimiter is dropped
+    while (pos < r->size && data[pos] != ',' && data[pos] != '\n' && data[pos] != '\r') pos++;
+    r->pos = pos;
+    CsvField field = {data + start, out - start};
+    return field;
+}
+
+static CsvField read_plain(CsvReader* r) {
+    const char* data = r->data;
+    size_t start = r->pos, pos = r->pos;
+    while (pos < r->size && data[pos] != ',' && data[pos] != '\n' && data[pos] != '\r') pos++;
+    r->pos = pos;
+    CsvField field = {data + start, pos - start};
+    return field;
+}
+
+int csv_next(CsvReader* r) {
+    while (r->pos < r->size && (r->data[r->pos] == '\n' || r->data[r->pos] == '\r')) r->pos++;
+    if (r->pos >= r->size) return -1;
+
+    int count = 0;
+    for (;;) {
+        CsvField field;
+        if (r->data[r->pos] == '"') {
+            r->pos++;
+            field = read_quoted(r);
+        } else {
+            field = read_plain(r);
+        }
+        if (count < CSV_MAX_FIELDS) r->fields[count] = field;
+        count++;
+
+        if (r->pos < r->size && r->data[r->pos] == ',') {
+            r->pos++;
+            if (r->pos >= r->size) { // trailing comma at the very end
+                CsvField empty = {r->data + r->pos, 0};
+                if (count < CSV_MAX_FIELDS) r->fields[count] = empty;
+                count++;
+                break;
+            }
+            continue;
+        }
+        if (r->pos < r->size && r->data[r->pos] == '\r') r->pos++;
+        if (r->pos < r->size && r->data[r->pos] == '\n') r->pos++;
+        break;
+    }
+    r->field_count = count < CSV_MAX_FIELDS ? count : CSV_MAX_FIELDS;
+    return r->field_count;
+}
+
+bool csv_field_equals(CsvField field, const char* s) {
+    return strlen(s) == field.len && memcmp(field.ptr, s, field.len) == 0;
+}
+
+long csv_field_long(CsvField field) {
+    size_t i = 0;
+    while (i < field.len && (field.ptr[i] == ' ' || field.ptr[i] == '\t')) i++;
+    bool negative = i < field.len && field.ptr[i] == '-';
+    if (i < field.len && (field.ptr[i] == '-' || field.ptr[i] == '+')) i++;
+    long value = 0;
+    for (; i < field.len && field.ptr[i] >= '0' && field.ptr[i] <= '9'; i++) {
+        value = value * 10 + (field.ptr[i] - '0');
+    }
+    return negative ? -value : value;
+}
+
+void csv_writer_init(CsvWriter* w, FILE* file) {
+    w->file = file;
+    w->column = 0;
+}
+
+void csv_write_text(CsvWriter* w, const char* s) {
+    if (w->column++ > 0) putc(',', w->file);
+    putc('"', w->file);
+    for (const char* q; (q = strchr(s, '"')); s = q + 1) {
+        fwrite(s, 1, (size_t)(q - s), w->file);
+        fputs("\"\"", w->file);
+    }
+    fputs(s, w->file);
+    putc('"', w->file);
+}
+
+void csv_write_long(CsvWriter* w, long value) {
+    if (w->column++ > 0) putc(',', w->file);
+    fprintf(w->file, "%ld", value);
+}
+
+void csv_end_record(CsvWriter* w) {
+    putc('\n', w->file);
+    w->column = 0;
+}
@@ -0,0 +1,52 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define CSV_MAX_FIELDS 16 // fields past this are parsed but dropped
+
+// a field of the current record. not NUL terminated: it points straight
+// into the file buffer, which is only rewritten (in place) to unescape "".
+typedef struct {
+    const char* ptr;
+    size_t len;
+} CsvField;
+
+// RFC 4180 reader over a whole file, mmap'd privately when possible and
+// read into one buffer otherwise. records have no length limit and quoted
+// fields may hold commas, "" and newlines.
+typedef struct {
+    char* data;
+    size_t size;
+    size_t pos;
+    void* map;   // set when data is a mapping
+    bool owned;  // set when data was malloc'd
+    CsvField fields[CSV_MAX_FIELDS];
+    int field_count;
+} CsvReader;
+
+int csv_open(CsvReader* r, const char* path);
+// parses a caller-owned buffer, which gets modified in place
+void csv_from_buffer(CsvReader* r, char* data, size_t size);
+// advances to the next record and returns its field count, -1 at the end.
+// blank lines are skipped.
+int csv_next(CsvReader* r);
+void csv_close(CsvReader* r);
+
+bool csv_field_equals(CsvField field, const char* s);
+long csv_field_long(CsvField field); // like atol, 0 for junk
+
+// writes one record at a time, quoting text and doubling embedded quotes
+typedef struct {
+    FILE* file;
+    int column;
+} CsvWriter;
+
+void csv_writer_init(CsvWriter* w, FILE* file);
+void csv_write_text(CsvWriter* w, const char* s); // always quoted
+void csv_write_long(CsvWriter* w, long value);
+void csv_end_record(CsvWriter* w);
+
+#endif
@@ -0,0 +1,273 @@
+#include "gram_index.h"
+#include <string.h>
+
+#define GRAM_TABLE_MIN 256
+
+static bool is_space(unsigned char c) {
+    return c <= ' ';
+}
+
+static unsigned char lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static uint32_t pack(unsigned char a, unsigned char b, unsigned char c) {
+    return ((uint32_t)a << 16) | ((uint32_t)b << 8) | c;
+}
+
+static int bucket_of(uint32_t key, int capacity) {
+    return (int)((key * 2654435761u) & (uint32_t)(capacity - 1));
+}
+
+void gram_index_init(GramIndex* index, Arena* arena) {
+    memset(index, 0, sizeof(*index));
+    index->arena = arena;
+}
+
+void gram_index_release(GramIndex* index) {
+    for (int i = 0; i < index->table_capacity; i++) {
+        if (index->table[i].key != 0) arena_release(index->arena, index->table[i].docs);
+    }
+    arena_release(index->arena, index->table);
+    gram_index_init(index, index->arena);
+}
+
+static GramPosting* find_posting(const GramIndex* index, uint32_t key) {
+    if (index->table_capacity == 0) return NULL;
+    int mask = index->table_capacity - 1;
+    for (int i = bucket_of(key, index->table_capacity); index->table[i].key != 0; i = (i + 1) & mask) {
+        if (index->table[i].key == key) return &index->table[i];
+    }
+    return NULL;
+}
+
+static bool grow_table(GramIndex* index) {
+    int capacity = index->table_capacity ? index->table_capacity * 2 : GRAM_TABLE_MIN;
+    GramPosting* table = arena_alloc(index->arena, (size_t)capacity * sizeof(GramPosting));
+    if (!table) return false;
+    memset(table, 0, (size_t)capacity * sizeof(GramPosting));
+    for (int i = 0; i < index->table_capacity; i++) {
+        if (index->table[i].key == 0) continue;
+        int j = bucket_of(index->table[i].key, capacity);
+        while (table[j].key != 0) j = (j + 1) & (capacity - 1);
+        table[j] = index->table[i];
+    }
+    arena_release(index->arena, index->table);
+    index->table = table;
+    index->table_capacity = capacity;
+    return true;
+}
+
+static GramPosting* posting_for(GramIndex* index, uint32_t key) {
+    GramPosting* posting = find_posting(index, key);
+    if (posting) return posting;
+    if ((index->gram_count + 1) * 2 > index->table_capacity && !grow_table(index)) return NULL;
+
+    int mask = index->table_capacity - 1;
+    int i = bucket_of(key, index->table_capacity);
+    while (index->table[i].key != 0) i = (i + 1) & mask;
+    index->table[i].key = key;
+    index->gram_count++;
+    return &index->table[i];
+}
+
+// first position in docs holding a value >= doc
+static int lower_bound(const int* docs, int count, int doc) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (docs[mid] < doc) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// docs mostly arrive in ascending order (loading), which makes this an append
+static bool posting_insert(GramIndex* index, GramPosting* posting, int doc) {
+    int n = posting->count;
+    int i = (n == 0 || posting->docs[n - 1] < doc) ? n : lower_bound(posting->docs, n, doc);
+    if (i < posting->count && posting->docs[i] == doc) return true; // gram repeats in the text
+    int* docs = arena_grow(index->arena, posting->docs, &posting->capacity, posting->count + 1, sizeof(int));
+    if (!docs) return false;
+    posting->docs = docs;
+    memmove(&docs[i + 1], &docs[i], (size_t)(posting->count - i) * sizeof(int));
+    docs[i] = doc;
+    posting->count++;
+    return true;
+}
+
+static void posting_erase(GramPosting* posting, int doc) {
+    int i = lower_bound(posting->docs, posting->count, doc);
+    if (i >= posting->count || posting->docs[i] != doc) return;
+    memmove(&posting->docs[i], &posting->docs[i + 1], (size_t)(posting->count - i - 1) * sizeof(int));
+    posting->count--;
+}
+
+bool gram_index_add(GramIndex* index, int doc, const char* text, size_t len) {
+    unsigned char a = 0, b = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (is_space(c)) {
+            a = b = 0;
+            continue;
+        }
+        c = lower(c);
+        GramPosting* posting = posting_for(index, pack(a, b, c));
+        if (!posting || !posting_insert(index, posting, doc)) return false;
+        a = b;
+        b = c;
+    }
+    return true;
+}
+
+void gram_index_remove(GramIndex* index, int doc, const char* text, size_t len) {
+    unsigned char a = 0, b = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (is_space(c)) {
+            a = b = 0;
+            continue;
+        }
+        c = lower(c);
+        GramPosting* posting = find_posting(index, pack(a, b, c));
+        if (posting) posting_erase(posting, doc);
+        a = b;
+        b = c;
+    }
+}
+
+void gram_query_parse(GramQuery* query, const char* text) {
+    memset(query, 0, sizeof(*query));
+    int n = 0;
+    for (; text[n] && n < GRAM_QUERY_LENGTH - 1; n++) {
+        query->text[n] = (char)lower((unsigned char)text[n]);
+    }
+
+    for (int i = 0; i < n && query->word_count < GRAM_QUERY_WORDS; ) {
+        if (is_space((unsigned char)query->text[i])) {
+            i++;
+            continue;
+        }
+        int start = i;
+        while (i < n && !is_space((unsigned char)query->text[i])) i++;
+        int length = i - start;
+        query->word_start[query->word_count] = start;
+        query->word_length[query->word_count] = length;
+        query->word_count++;
+
+        const unsigned char* w = (const unsigned char*)&query->text[start];
+        if (length == 1) {
+            query->grams[query->gram_count++] = pack(0, 0, w[0]);
+        } else if (length == 2) {
+            query->grams[query->gram_count++] = pack(0, w[0], w[1]);
+        } else {
+            for (int j = 0; j + 2 < length && query->gram_count < GRAM_QUERY_GRAMS; j++) {
+                query->grams[query->gram_count++] = pack(w[j], w[j + 1], w[j + 2]);
+            }
+        }
+    }
+}
+
+// where word occurs in text, preferring an occurrence at the start of a
+// text word; short words must start one. -1 when absent.
+static int find_word(const char* text, size_t len, const char* word, int wlen, bool* at_start) {
+    int found = -1;
+    for (size_t i = 0; i + (size_t)wlen <= len; i++) {
+        int j = 0;
+        while (j < wlen && lower((unsigned char)text[i + j]) == (unsigned char)word[j]) j++;
+        if (j < wlen) continue;
+        bool start = i == 0 || is_space((unsigned char)text[i - 1]);
+        if (start) {
+            *at_start = true;
+            return (int)i;
+        }
+        if (wlen >= 3 && found < 0) found = (int)i;
+    }
+    *at_start = false;
+    return found;
+}
+
+int gram_query_match(const GramQuery* query, const char* text, size_t len) {
+    if (query->word_count == 0) return -1;
+    int points = 0;
+    for (int w = 0; w < query->word_count; w++) {
+        bool at_start;
+        int pos = find_word(text, len, &query->text[query->word_start[w]], query->word_length[w], &at_start);
+        if (pos < 0) return -1;
+        points += at_start ? 2 : 1;
+        if (w == 0 && pos == 0) points += 2; // the text starts with the query
+    }
+    // among equal matches the shorter text is the closer one
+    int length_penalty = len < 1023 ? (int)len : 1023;
+    return points * 1024 - length_penalty;
+}
+
+// first position from `from` on holding a value >= doc: doubling steps
+// find the range, a binary search finishes inside it
+static int gallop(const GramPosting* posting, int from, int doc) {
+    int step = 1;
+    int hi = from;
+    while (hi < posting->count && posting->docs[hi] < doc) {
+        from = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > posting->count) hi = posting->count;
+    return from + lower_bound(&posting->docs[from], hi - from, doc);
+}
+
+// keeps hits sorted best first, ties in arrival (doc) order
+static void insert_hit(GramHit* hits, int* count, int max, GramHit hit) {
+    int i = *count;
+    if (i == max) {
+        if (hits[max - 1].score >= hit.score) return;
+        i--;
+    } else {
+        (*count)++;
+    }
+    while (i > 0 && hits[i - 1].score < hit.score) {
+        hits[i] = hits[i - 1];
+        i--;
+    }
+    hits[i] = hit;
+}
+
+int gram_index_search(const GramIndex* index, const GramQuery* query,
+                      GramTextFn text_fn, void* ctx, GramHit* hits, int max) {
+    if (query->gram_count == 0 || max <= 0) return 0;
+
+    // every gram must be present; walk the rarest list and probe the others
+    const GramPosting* postings[GRAM_QUERY_GRAMS];
+    int driver = 0;
+    for (int g = 0; g < query->gram_count; g++) {
+        postings[g] = find_posting(index, query->grams[g]);
+        if (!postings[g] || postings[g]->count == 0) return 0;
+        if (postings[g]->count < postings[driver]->count) driver = g;
+    }
+
+    // the driver's docs ascend, so each other list is only ever searched
+    // forward from where the previous doc was found
+    int cursor[GRAM_QUERY_GRAMS] = {0};
+    int count = 0;
+    int matched = 0;
+    const GramPosting* lead = postings[driver];
+    for (int i = 0; i < lead->count && matched < GRAM_MATCH_LIMIT; i++) {
+        int doc = lead->docs[i];
+        bool all = true;
+        for (int g = 0; g < query->gram_count && all; g++) {
+            if (g == driver) continue;
+            cursor[g] = gallop(postings[g], cursor[g], doc);
+            all = cursor[g] < postings[g]->count && postings[g]->docs[cursor[g]] == doc;
+        }
+        if (!all) continue;
+
+        size_t len;
+        const char* text = text_fn(doc, &len, ctx);
+        int score = text ? gram_query_match(query, text, len) : -1;
+        if (score < 0) continue;
+        GramHit hit = {doc, score};
+        insert_hit(hits, &count, max, hit);
+        matched++;
+    }
+    return count;
+}
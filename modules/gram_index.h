@@ -0,0 +1,71 @@
+#ifndef GRAM_INDEX_H
+#define GRAM_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+// an inverted index from trigrams to the documents (plain ints chosen by the
+// owner) whose text contains them. text is lowercased and split into words
+// on whitespace; every word is padded with two boundary marks in front, so
+// "milk" yields [^^m] [^mi] [mil] [ilk]. a one or two letter query word then
+// looks up words starting with it, a longer one any substring.
+//
+// postings are sorted doc arrays from the owner's arena, updated in place as
+// documents are added and removed, so the index never has to be rebuilt.
+#define GRAM_QUERY_LENGTH 64
+#define GRAM_QUERY_WORDS 8
+#define GRAM_QUERY_GRAMS GRAM_QUERY_LENGTH
+// a search stops after this many matches: enough to rank the few that are
+// shown, and a bound on the work a keystroke can cost
+#define GRAM_MATCH_LIMIT 512
+
+typedef struct {
+    uint32_t key;   // three packed bytes, 0 marks an empty bucket
+    int* docs;      // ascending
+    int count;
+    int capacity;
+} GramPosting;
+
+typedef struct {
+    Arena* arena;
+    GramPosting* table;
+    int table_capacity;
+    int gram_count;
+} GramIndex;
+
+// a parsed query: its words (lowercase) and every gram a match must have
+typedef struct {
+    char text[GRAM_QUERY_LENGTH];
+    int word_start[GRAM_QUERY_WORDS];
+    int word_length[GRAM_QUERY_WORDS];
+    int word_count;
+    uint32_t grams[GRAM_QUERY_GRAMS];
+    int gram_count;
+} GramQuery;
+
+typedef struct {
+    int doc;
+    int score;
+} GramHit;
+
+// the owner's text for a doc, consulted to verify and rank candidates
+typedef const char* (*GramTextFn)(int doc, size_t* len, void* ctx);
+
+void gram_index_init(GramIndex* index, Arena* arena);
+// gives every posting back to the arena; the index is empty afterwards
+void gram_index_release(GramIndex* index);
+// text must be what the doc is removed with later
+bool gram_index_add(GramIndex* index, int doc, const char* text, size_t len);
+void gram_index_remove(GramIndex* index, int doc, const char* text, size_t len);
+
+void gram_query_parse(GramQuery* query, const char* text);
+// score of text against the query, higher is better, -1 when it doesn't match
+int gram_query_match(const GramQuery* query, const char* text, size_t len);
+
+// best matches first, at most max of them. returns how many were stored.
+int gram_index_search(const GramIndex* index, const GramQuery* query,
+                      GramTextFn text_fn, void* ctx, GramHit* hits, int max);
+
+#endif
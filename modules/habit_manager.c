@@ -1,56 +1,37 @@
 #include "habit_manager.h"
 #include "imodule.h"
-#include "../src/minimal_tui.h"
+#include "journal.h"
+#include "csv.h"
+#include "persist.h"
+#include "state_cache.h"
+#include "../src/config.h"
+#include <limits.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 static HabitData habit_data;
+static SnapshotJournal habit_journal = SNAPSHOT_JOURNAL_INIT(habits_save);
 
 void habits_init() {
-    habit_data.head_count = 0;
+    habits_cleanup();
+    item_store_init(&habit_data.store, &habit_data.arena, sizeof(Task), offsetof(Task, name));
+    undo_init(&habit_data.undo, &habit_data.arena);
+    habit_data.today = history_today();
     habit_data.selected_head = 0;
-    habit_data.selected_task = 0;
+    habit_data.selected_task = -1; // nothing to select until a habit exists
     habit_data.edit_mode = false;
     habit_data.move_mode = false;
-}
-
-// helper function to get string input in a popup window
-static bool prompt_for_string(WINDOW* parent_win, const char* prompt, char* buffer, int buffer_size) {
-    int parent_h, parent_w;
-    getmaxyx(parent_win, parent_h, parent_w);
-    int h = 3;
-    int w = strlen(prompt) + 20; // a bit of padding
-    int y = (parent_h - h) / 2;
-    int x = (parent_w - w) / 2;
-
-    WINDOW* win = newwin(h, w, y, x);
-    box(win, 0, 0);
-    mvwprintw(win, 1, 2, "%s", prompt);
-    wrefresh(win);
-
-    echo();
-    curs_set(1);
-    wgetnstr(win, buffer, buffer_size - 1);
-    curs_set(0);
-    noecho();
-
-    delwin(win);
-    // this is a bit of a hack to "clear" the parent window where the popup was
-    // without doing a full redraw of the app, which would be slow.
-    touchwin(parent_win); 
-    wnoutrefresh(parent_win);
-
-    // check if user entered something or just pressed enter/esc
-    return strlen(buffer) > 0;
+    text_entry_cancel(&habit_data.entry);
 }
 
 static void ensure_task_selected() {
-    if (habit_data.selected_task != -1 && habit_data.head_count > 0 && habit_data.heads[habit_data.selected_head].task_count > 0) return;
-    if (habit_data.head_count == 0) return;
+    if (habit_data.selected_task != -1 && habit_data.store.head_count > 0 && habit_data.store.heads[habit_data.selected_head].task_count > 0) return;
+    if (habit_data.store.head_count == 0) return;
 
-    for (int i = 0; i < habit_data.head_count; i++) {
-        if (habit_data.heads[i].task_count > 0) {
+    for (int i = 0; i < habit_data.store.head_count; i++) {
+        if (habit_data.store.heads[i].task_count > 0) {
             habit_data.selected_head = i;
             habit_data.selected_task = 0;
             return;
@@ -59,235 +40,714 @@ static void ensure_task_selected() {
 }
 
 void habits_cleanup() {
-    // nothing to clean up with static allocation
+    arena_reset(&habit_data.arena);
+    memset(&habit_data, 0, sizeof(habit_data));
 }
 
-void habits_module_render(struct IModule* self, WINDOW* win) {
-    werase(win);
-    mvwprintw(win, 1, 2, "Habits %s", habit_data.edit_mode ? "[EDIT MODE]" : "");
+void habits_string_usage(size_t* used, size_t* reserved) {
+    *used = str_arena_used(&habit_data.store.strings);
+    *reserved = str_arena_reserved(&habit_data.store.strings);
+}
 
-    int y = 3;
-    for (int h = 0; h < habit_data.head_count; h++) {
-        if (h == habit_data.selected_head && habit_data.selected_task == -1) {
-            wattron(win, A_REVERSE);
-        }
-        mvwprintw(win, y++, 2, "%s:", habit_data.heads[h].name);
-        if (h == habit_data.selected_head && habit_data.selected_task == -1) {
-            wattroff(win, A_REVERSE);
+// --- Storage ---
+// the heads, their slots and every name live in habit_data.store, see
+// item_store.h
+
+static Task* habit_at(int head, int task) {
+    return item_store_at(&habit_data.store, head, task);
+}
+
+// only valid until the next string is stored
+static const char* text_of(StrRef ref) {
+    return item_store_text(&habit_data.store, ref);
+}
+
+// --- Mutations ---
+// every change to habit_data goes through an apply_* helper so replaying the
+// journal does exactly what the ui did. the public habits_* wrappers apply,
+// append one record and push the inverse for undo.
+
+static bool valid_task(int head, int task) {
+    return item_store_valid(&habit_data.store, head, task);
+}
+
+static bool apply_add_head(const char* name) {
+    return item_store_add_head(&habit_data.store, name, strlen(name)) != NULL;
+}
+
+static bool apply_add_task(int head_idx, int pos, const char* name) {
+    Task* task = item_store_insert(&habit_data.store, head_idx, pos, name, strlen(name));
+    if (!task) return false;
+    task->id = habit_data.store.heads[head_idx].task_count;
+    return true;
+}
+
+// a habit's history is the one thing it holds besides its name
+static void release_habit(void* item, void* ctx) {
+    (void)ctx;
+    history_release(&((Task*)item)->history, &habit_data.arena);
+}
+
+static bool apply_delete_head(int head_idx) {
+    return item_store_delete_head(&habit_data.store, head_idx, release_habit, NULL);
+}
+
+static bool apply_delete_task(int head_idx, int task_idx) {
+    return item_store_delete(&habit_data.store, head_idx, task_idx, release_habit, NULL);
+}
+
+static bool apply_move_head(int from, int to) {
+    return item_store_move_head(&habit_data.store, from, to);
+}
+
+// takes the habit out of from_head and inserts it at to_task in to_head
+static bool apply_move_task(int from_head, int from_task, int to_head, int to_task) {
+    return item_store_move(&habit_data.store, from_head, from_task, to_head, to_task);
+}
+
+static bool apply_set_done(int head_idx, int task_idx, int day, bool done) {
+    if (!valid_task(head_idx, task_idx)) return false;
+    return history_set(&habit_at(head_idx, task_idx)->history, &habit_data.arena, day, done);
+}
+
+// marks the days named in the csv's ranges format
+static bool apply_add_days(int head_idx, int task_idx, const char* days) {
+    if (!valid_task(head_idx, task_idx)) return false;
+    return history_parse(&habit_at(head_idx, task_idx)->history, &habit_data.arena, days, strlen(days));
+}
+
+// task_idx == -1 renames the head itself
+static bool apply_rename(int head_idx, int task_idx, const char* text) {
+    return item_store_rename(&habit_data.store, head_idx, task_idx, text);
+}
+
+static const char* num(char* buf, int value) {
+    snprintf(buf, 16, "%d", value);
+    return buf;
+}
+
+// habits first..last of a head from last to first, each as its name and
+// the days it was done (the ranges the csv stores), then the head's name
+// if with_head; all NUL terminated
+static char* save_habits(int head, int first, int last, bool with_head) {
+    const char* name = text_of(habit_data.store.heads[head].name);
+    size_t size = with_head ? strlen(name) + 1 : 1;
+    for (int t = first; t <= last; t++) {
+        const Task* habit = habit_at(head, t);
+        size += strlen(text_of(habit->name)) + history_format(&habit->history, NULL, 0) + 2;
+    }
+    char* saved = arena_alloc(&habit_data.arena, size);
+    if (!saved) return NULL;
+
+    char* p = saved;
+    for (int t = last; t >= first; t--) {
+        const Task* habit = habit_at(head, t);
+        const char* text = text_of(habit->name);
+        size_t len = strlen(text);
+        memcpy(p, text, len + 1);
+        p += len + 1;
+        p += history_format(&habit->history, p, size - (size_t)(p - saved)) + 1;
+    }
+    if (with_head) memcpy(p, name, strlen(name) + 1);
+    else *p = '\0';
+    return saved;
+}
+
+// pushes the re-add of one habit saved above, returns the next entry
+static const char* push_restore_habit(int head, int task, const char* saved) {
+    const char* days = saved + strlen(saved) + 1;
+    undo_push(&habit_data.undo, UNDO_ADD_ITEM, head, task, 0, 0, saved, days);
+    return days + strlen(days) + 1;
+}
+
+void habits_add_head(const char* name) {
+    if (!apply_add_head(name)) return;
+    const char* rec[] = {"AH", name};
+    snapshot_journal_append(&habit_journal, 2, rec);
+    undo_begin(&habit_data.undo);
+    undo_push(&habit_data.undo, UNDO_DELETE_HEAD, habit_data.store.head_count - 1, 0, 0, 0, NULL, NULL);
+}
+
+void habits_add_task(int head, int pos, const char* name) {
+    if (!apply_add_task(head, pos, name)) return;
+    char a[16], b[16];
+    const char* rec[] = {"AT", num(a, head), num(b, pos), name};
+    snapshot_journal_append(&habit_journal, 4, rec);
+    undo_begin(&habit_data.undo);
+    undo_push(&habit_data.undo, UNDO_DELETE_ITEM, head, pos, 0, 0, NULL, NULL);
+}
+
+void habits_delete_head(int head) {
+    if (head < 0 || head >= habit_data.store.head_count) return;
+    int count = habit_data.store.heads[head].task_count;
+    char* saved = save_habits(head, 0, count - 1, true);
+    if (!saved || !apply_delete_head(head)) {
+        arena_release(&habit_data.arena, saved);
+        return;
+    }
+    char a[16];
+    const char* rec[] = {"DH", num(a, head)};
+    snapshot_journal_append(&habit_journal, 2, rec);
+
+    undo_begin(&habit_data.undo);
+    const char* p = saved;
+    for (int t = count - 1; t >= 0; t--) {
+        p = push_restore_habit(head, t, p);
+    }
+    undo_push_head_restore(&habit_data.undo, head, habit_data.store.head_count, p);
+    arena_release(&habit_data.arena, saved);
+}
+
+void habits_delete_task(int head, int task) {
+    if (!valid_task(head, task)) return;
+    char* saved = save_habits(head, task, task, false);
+    if (!saved || !apply_delete_task(head, task)) {
+        arena_release(&habit_data.arena, saved);
+        return;
+    }
+    char a[16], b[16];
+    const char* rec[] = {"DT", num(a, head), num(b, task)};
+    snapshot_journal_append(&habit_journal, 3, rec);
+    undo_begin(&habit_data.undo);
+    push_restore_habit(head, task, saved);
+    arena_release(&habit_data.arena, saved);
+}
+
+void habits_move_head(int from, int to) {
+    if (!apply_move_head(from, to)) return;
+    char a[16], b[16];
+    const char* rec[] = {"MH", num(a, from), num(b, to)};
+    snapshot_journal_append(&habit_journal, 3, rec);
+    undo_begin(&habit_data.undo);
+    undo_push(&habit_data.undo, UNDO_MOVE_HEAD, to, from, 0, 0, NULL, NULL);
+}
+
+void habits_move_task(int from_head, int from_task, int to_head, int to_task) {
+    if (!apply_move_task(from_head, from_task, to_head, to_task)) return;
+    char a[16], b[16], c[16], d[16];
+    const char* rec[] = {"MT", num(a, from_head), num(b, from_task), num(c, to_head), num(d, to_task)};
+    snapshot_journal_append(&habit_journal, 5, rec);
+    undo_begin(&habit_data.undo);
+    undo_push(&habit_data.undo, UNDO_MOVE_ITEM, to_head, to_task, from_head, from_task, NULL, NULL);
+}
+
+void habits_set_done(int head, int task, int day, bool done) {
+    if (!valid_task(head, task)) return;
+    bool was = history_get(&habit_at(head, task)->history, day);
+    if (!apply_set_done(head, task, day, done)) return;
+    char a[16], b[16], c[16], d[16];
+    const char* rec[] = {"SH", num(a, head), num(b, task), num(c, day), num(d, done)};
+    snapshot_journal_append(&habit_journal, 5, rec);
+    undo_begin(&habit_data.undo);
+    undo_push(&habit_data.undo, UNDO_SET_ITEM, head, task, day, was, NULL, NULL);
+}
+
+void habits_rename(int head, int task, const char* text) {
+    if (head < 0 || head >= habit_data.store.head_count || (task != -1 && !valid_task(head, task))) return;
+    StrRef old = task == -1 ? habit_data.store.heads[head].name : habit_at(head, task)->name;
+    char* saved = undo_save_text(&habit_data.undo, text_of(old));
+    if (!saved || !apply_rename(head, task, text)) {
+        arena_release(&habit_data.arena, saved);
+        return;
+    }
+    char a[16], b[16];
+    const char* rec[] = {"RN", num(a, head), num(b, task), text};
+    snapshot_journal_append(&habit_journal, 4, rec);
+    undo_begin(&habit_data.undo);
+    undo_push(&habit_data.undo, UNDO_RENAME, head, task, 0, 0, saved, NULL);
+    arena_release(&habit_data.arena, saved);
+}
+
+// gives a habit put back by an undo the days it had. it only ever follows
+// the re-add, whose own inverse deletes the habit, so it pushes nothing
+static void restore_days(int head, int task, const char* days) {
+    if (!days || !days[0] || !apply_add_days(head, task, days)) return;
+    char a[16], b[16];
+    const char* rec[] = {"HD", num(a, head), num(b, task), days};
+    snapshot_journal_append(&habit_journal, 4, rec);
+}
+
+// one journal record, through the same apply_* helpers as the edit itself
+static void replay_record(int argc, char** argv, void* ctx) {
+    (void)ctx;
+    const char* op = argv[0];
+    int a = argc > 1 ? atoi(argv[1]) : 0;
+    int b = argc > 2 ? atoi(argv[2]) : 0;
+
+    if (strcmp(op, "AH") == 0 && argc >= 2) apply_add_head(argv[1]);
+    else if (strcmp(op, "AT") == 0 && argc >= 4) apply_add_task(a, b, argv[3]);
+    else if (strcmp(op, "DH") == 0 && argc >= 2) apply_delete_head(a);
+    else if (strcmp(op, "DT") == 0 && argc >= 3) apply_delete_task(a, b);
+    else if (strcmp(op, "MH") == 0 && argc >= 3) apply_move_head(a, b);
+    else if (strcmp(op, "MT") == 0 && argc >= 5) apply_move_task(a, b, atoi(argv[3]), atoi(argv[4]));
+    else if (strcmp(op, "SH") == 0 && argc >= 5) apply_set_done(a, b, atoi(argv[3]), atoi(argv[4]) != 0);
+    else if (strcmp(op, "RN") == 0 && argc >= 4) apply_rename(a, b, argv[3]);
+    else if (strcmp(op, "HD") == 0 && argc >= 4) apply_add_days(a, b, argv[3]);
+}
+
+// --- Binary cache ---
+// data/habits.cache holds habit_data as parsed from data/habits.csv, keyed
+// by the CSV's size, mtime and inode, so an unchanged CSV loads unparsed
+
+static bool load_cache(const char* filename, CacheKey* key) {
+    char path[JOURNAL_PATH_LENGTH];
+    cache_path_for(filename, path, sizeof(path));
+    CacheView view;
+    if (cache_open(path, filename, key, sizeof(Task), &view) != 0) return false;
+
+    habits_init();
+    bool ok = item_store_adopt(&habit_data.store, &view);
+    // the history words follow in item order; the cached pointers are stale
+    size_t offset = 0;
+    for (int i = 0; i < habit_data.store.item_count; i++) {
+        HabitHistory* history = &((Task*)item_store_slot(&habit_data.store, i))->history;
+        history->words = NULL;
+        if (!ok || history->block_count == 0) continue;
+        size_t bytes = (size_t)history->block_count * HISTORY_BLOCK_WORDS * sizeof(uint64_t);
+        ok = history->block_count > 0 && bytes <= view.extra_bytes - offset;
+        if (ok) history->words = arena_alloc(&habit_data.arena, bytes);
+        ok = ok && history->words != NULL;
+        if (ok) memcpy(history->words, (const char*)view.extra + offset, bytes);
+        offset += bytes;
+    }
+    cache_close(&view);
+
+    if (!ok) habits_init();
+    return ok;
+}
+
+// the cached copies lose their history pointers, the words go in extra
+static void pack_habit(void* item, void* ctx) {
+    (void)ctx;
+    ((Task*)item)->history.words = NULL;
+}
+
+static void write_cache(const char* filename, CacheKey* key) {
+    size_t history_words = 0;
+    for (int h = 0; h < habit_data.store.head_count; h++) {
+        for (int t = 0; t < habit_data.store.heads[h].task_count; t++) {
+            history_words += (size_t)habit_at(h, t)->history.block_count * HISTORY_BLOCK_WORDS;
         }
+    }
 
-        for (int t = 0; t < habit_data.heads[h].task_count; t++) {
-            if (h == habit_data.selected_head && t == habit_data.selected_task) {
-                wattron(win, A_REVERSE);
-            }
-            mvwprintw(win, y++, 4, "%d. [%c] %s (%d)",
-                     t + 1,
-                     habit_data.heads[h].tasks[t].done_today ? 'X' : ' ',
-                     habit_data.heads[h].tasks[t].name,
-                     habit_data.heads[h].tasks[t].streak);
-            if (h == habit_data.selected_head && t == habit_data.selected_task) {
-                wattroff(win, A_REVERSE);
+    // in the order the store writes the habits
+    uint64_t* words = arena_alloc(&habit_data.arena, (history_words + 1) * sizeof(uint64_t));
+    if (words) {
+        size_t w = 0;
+        for (int h = 0; h < habit_data.store.head_count; h++) {
+            for (int t = 0; t < habit_data.store.heads[h].task_count; t++) {
+                const HabitHistory* history = &habit_at(h, t)->history;
+                size_t count = (size_t)history->block_count * HISTORY_BLOCK_WORDS;
+                if (count > 0) memcpy(&words[w], history->words, count * sizeof(uint64_t));
+                w += count;
             }
         }
-        y++; // add space between heads
+        item_store_write_cache(&habit_data.store, filename, key, pack_habit, NULL,
+                               words, (uint32_t)(history_words * sizeof(uint64_t)));
     }
+    arena_release(&habit_data.arena, words);
+}
 
-    // draw help text
-    int max_y = getmaxy(win);
+int habits_close(void) {
+    return snapshot_journal_close(&habit_journal);
+}
+
+bool habits_is_loaded(void) {
+    return snapshot_journal_is_loaded(&habit_journal);
+}
+
+// --- Search ---
+
+int habits_search(const GramQuery* query, GramHit* hits, int max) {
+    return item_store_search(&habit_data.store, query, hits, max);
+}
+
+const char* habits_hit_text(int doc) {
+    return item_store_hit_text(&habit_data.store, doc);
+}
+
+// selects the head in edit mode, its first habit otherwise
+static void select_head(int head_idx) {
+    if (habit_data.edit_mode) {
+        habit_data.selected_head = head_idx;
+        habit_data.selected_task = -1;
+    } else if (habit_data.store.heads[head_idx].task_count > 0) {
+        habit_data.selected_head = head_idx;
+        habit_data.selected_task = 0;
+    }
+}
+
+void habits_reveal(int doc) {
+    if (doc < 0) {
+        int h = item_store_hit_head(&habit_data.store, doc);
+        if (h >= 0) select_head(h);
+        return;
+    }
+    item_store_locate(&habit_data.store, doc, &habit_data.selected_head, &habit_data.selected_task);
+}
+
+// --- List view ---
+// from window row 3 every head takes its header, its habits and a blank row
+
+#define LIST_TOP 3
+#define RECENT_DAYS 30 // the completion rate shown covers this many days
+
+static int head_rows(int head) {
+    return habit_data.store.heads[head].task_count + 2;
+}
+
+static bool layout_list(void) {
+    return list_view_layout(&habit_data.store.view, habit_data.store.head_count, head_rows);
+}
+
+// row of a head (task == -1) or a habit within the whole list
+static int list_row(int head, int task) {
+    if (head < 0 || head >= habit_data.store.head_count || !layout_list()) return -1;
+    return list_view_start(&habit_data.store.view, head) + 1 + task;
+}
+
+// window row of a head or habit, -1 when it is scrolled out of view
+static int habit_row(int head, int task) {
+    int row = list_row(head, task);
+    return row < 0 ? -1 : list_view_screen_row(&habit_data.store.view, row, LIST_TOP);
+}
+
+// repaints the rows of the heads from a to b, which a move reshuffled
+// among themselves
+static void invalidate_heads(struct IModule* self, int a, int b) {
+    if (!layout_list()) {
+        imodule_invalidate(self);
+        return;
+    }
+    const ListView* view = &habit_data.store.view;
+    int lo = a < b ? a : b;
+    int hi = a < b ? b : a;
+    int top = list_view_start(view, lo) - view->scroll;
+    int bottom = list_view_start(view, hi + 1) - 1 - view->scroll;
+    imodule_invalidate_rows(self, LIST_TOP + top, LIST_TOP + bottom);
+}
+
+static void draw_row(WINDOW* win, int y, int row) {
+    wmove(win, y, 0);
+    wclrtoeol(win);
+
+    int h = list_view_head_at(&habit_data.store.view, row);
+    if (h < 0) return;
+    int t = row - list_view_start(&habit_data.store.view, h) - 1;
+    if (t >= habit_data.store.heads[h].task_count) return; // gap
+
+    bool is_selected = h == habit_data.selected_head && t == habit_data.selected_task;
+    if (is_selected) wattron(win, A_REVERSE);
+    if (t == -1) {
+        mvwprintw(win, y, 2, "%s:", text_of(habit_data.store.heads[h].name));
+    } else {
+        HabitHistory* history = &habit_at(h, t)->history;
+        int today = habit_data.today;
+        int month = history_count(history, today - RECENT_DAYS + 1, today) * 100 / RECENT_DAYS;
+        mvwprintw(win, y, 4, "%d. [%c] %s (%d, best %d, %d%%)",
+                 t + 1,
+                 history_get(history, today) ? 'X' : ' ',
+                 text_of(habit_at(h, t)->name),
+                 history_streak(history, today),
+                 history_best_run(history),
+                 month);
+    }
+    if (is_selected) wattroff(win, A_REVERSE);
+}
+
+static void draw_help(WINDOW* win, int help_y) {
     if (habit_data.edit_mode) {
-        int help_y = max_y - 8;
-        if (help_y < y) help_y = y;
         mvwprintw(win, help_y++, 2, "Edit Mode %s:", habit_data.move_mode ? "[MOVING]" : "");
         mvwprintw(win, help_y++, 4, "R+U: New Head");
         mvwprintw(win, help_y++, 4, "R+I: New Task");
         mvwprintw(win, help_y++, 4, "D: Delete Item");
+        mvwprintw(win, help_y++, 4, "N: Rename Item");
+        mvwprintw(win, help_y++, 4, "G: Go to Head");
         mvwprintw(win, help_y++, 4, "S: Toggle Move");
         mvwprintw(win, help_y++, 4, "E+I: Toggle Edit");
         mvwprintw(win, help_y++, 4, "ESC: Exit Edit/Move");
     } else {
-        int help_y = max_y - 5;
-        if (help_y < y) help_y = y;
         mvwprintw(win, help_y++, 2, "Navigation:");
         mvwprintw(win, help_y++, 4, "↑/↓: Move");
         mvwprintw(win, help_y++, 4, "Space: Toggle");
+        mvwprintw(win, help_y++, 4, "G: Go to Head");
         mvwprintw(win, help_y++, 4, "E+I: Edit Mode");
     }
-    
+}
+
+// only the rows inside the viewport are formatted, whatever the list length
+void habits_module_render(struct IModule* self, WINDOW* win) {
+    int max_y = getmaxy(win);
+    int help_y = max_y - (habit_data.edit_mode ? 10 : 6);
+    ListView* view = &habit_data.store.view;
+
+    layout_list();
+    bool scrolled = list_view_resize(view, help_y - LIST_TOP);
+    scrolled |= list_view_follow(view, list_row(habit_data.selected_head, habit_data.selected_task));
+    if (scrolled) imodule_invalidate(self);
+
+    if (self->full_redraw) {
+        werase(win);
+        mvwprintw(win, 1, 2, "Habits %s", habit_data.edit_mode ? "[EDIT MODE]" : "");
+    }
+
+    // rows past the end only need clearing when the list just got shorter
+    int total = list_view_total(view);
+    for (int row = view->scroll; row < view->scroll + view->height; row++) {
+        if (row >= total && self->full_redraw) break;
+        int y = LIST_TOP + row - view->scroll;
+        if (imodule_row_dirty(self, y)) draw_row(win, y, row);
+    }
+
+    // the help block only moves when the list changes shape, which is
+    // always a full redraw
+    if (self->full_redraw) draw_help(win, help_y);
+    // the popup goes over whatever rows were just repainted
+    if (habit_data.entry.active) text_entry_render(&habit_data.entry, win);
     wnoutrefresh(win);
 }
 
-void habits_module_handle_input(struct IModule* self, int ch, struct MinimalTui* tui) {
+// --- Undo ---
+// an undo replays inverse operations through the wrappers above, so the
+// journal records it like any other edit. the log notes what the replay
+// changed (see UndoTouched), which becomes rows once the group is done.
+
+static void apply_undo(const UndoOp* op, void* ctx) {
+    (void)ctx;
+    const int* a = op->args;
+    switch (op->op) {
+        case UNDO_ADD_HEAD:
+            habits_add_head(op->text);
+            break;
+        case UNDO_ADD_ITEM:
+            habits_add_task(a[0], a[1], op->text);
+            restore_days(a[0], a[1], op->detail);
+            break;
+        case UNDO_DELETE_HEAD:
+            habits_delete_head(a[0]);
+            break;
+        case UNDO_DELETE_ITEM:
+            habits_delete_task(a[0], a[1]);
+            break;
+        case UNDO_MOVE_HEAD:
+            habits_move_head(a[0], a[1]);
+            break;
+        case UNDO_MOVE_ITEM:
+            habits_move_task(a[0], a[1], a[2], a[3]);
+            break;
+        case UNDO_SET_ITEM:
+            habits_set_done(a[0], a[1], a[2], a[3] != 0);
+            break;
+        case UNDO_RENAME:
+            habits_rename(a[0], a[1], op->text);
+            break;
+    }
+}
+
+// puts the cursor where the replay left it, and repaints from the first
+// row it touched, or just that row when nothing moved
+static void undo_step(struct IModule* self, bool redo) {
+    UndoLog* log = &habit_data.undo;
+    int head = habit_data.selected_head;
+    int task = habit_data.selected_task;
+    bool done = redo ? undo_redo(log, apply_undo, NULL, head, task)
+                     : undo_undo(log, apply_undo, NULL, head, task);
+    if (!done || habit_data.store.head_count == 0) return;
+
+    const UndoTouched* touched = &log->touched;
+    habit_data.selected_head = touched->head;
+    habit_data.selected_task = touched->pos;
+    item_store_clamp(&habit_data.store, &habit_data.selected_head, &habit_data.selected_task);
+    if (!habit_data.edit_mode) ensure_task_selected();
+
+    const ListView* view = &habit_data.store.view;
+    if (!layout_list()) {
+        imodule_invalidate(self);
+        return;
+    }
+    int top = list_view_start(view, touched->first);
+    if (!touched->shape && valid_task(touched->first, touched->first_pos)) {
+        top = list_row(touched->first, touched->first_pos);
+    }
+    if (top < view->scroll) {
+        imodule_invalidate(self); // rows above the viewport moved
+        return;
+    }
+    int y = LIST_TOP + top - view->scroll;
+    imodule_invalidate_rows(self, y, touched->shape ? INT_MAX : y);
+}
+
+// what the text field is for; where its text goes is fixed when it opens
+enum { ENTRY_ADD_HEAD, ENTRY_ADD_ITEM, ENTRY_RENAME, ENTRY_JUMP };
+
+static void open_entry(struct IModule* self, const char* prompt, int purpose, int head, int task) {
+    text_entry_start(&habit_data.entry, prompt, purpose);
+    habit_data.entry_head = head;
+    habit_data.entry_task = task;
+    imodule_invalidate(self); // the popup covers part of the list
+}
+
+// the field has the keyboard until it is confirmed or cancelled; only then
+// does anything change
+static void handle_entry(struct IModule* self, InputAction action, int key) {
+    TextEntry* entry = &habit_data.entry;
+    TextEntryStatus status = text_entry_feed(entry, action, key);
+    if (status == TEXT_ENTRY_TYPING) {
+        imodule_invalidate_rows(self, entry->top, entry->top + TEXT_ENTRY_ROWS - 1);
+        return;
+    }
+    imodule_invalidate(self); // uncovers the list
+    bool done = status == TEXT_ENTRY_DONE;
+    switch (entry->purpose) {
+        case ENTRY_ADD_HEAD:
+            if (done) {
+                habits_add_head(entry->text);
+                habit_data.selected_head = habit_data.store.head_count - 1;
+                habit_data.selected_task = -1;
+            }
+            habit_data.move_mode = false;
+            ensure_task_selected();
+            break;
+        case ENTRY_ADD_ITEM:
+            if (done) {
+                habits_add_task(habit_data.entry_head, habit_data.entry_task, entry->text);
+                habit_data.selected_head = habit_data.entry_head;
+                habit_data.selected_task = habit_data.entry_task;
+            }
+            habit_data.move_mode = false;
+            ensure_task_selected();
+            break;
+        case ENTRY_RENAME:
+            if (done) habits_rename(habit_data.entry_head, habit_data.entry_task, entry->text);
+            break;
+        case ENTRY_JUMP:
+            if (done) {
+                int head_idx = item_store_find_head(&habit_data.store, entry->text, (size_t)entry->length);
+                if (head_idx >= 0) select_head(head_idx);
+            }
+            break;
+    }
+}
+
+static void handle_action(struct IModule* self, InputAction action) {
+    if (action == ACTION_UNDO || action == ACTION_REDO) {
+        undo_step(self, action == ACTION_REDO);
+        return;
+    }
     if (habit_data.edit_mode) {
         if (habit_data.move_mode) {
-            if (ch == 's' || ch == 'S' || ch == 27) {
+            int moved_head = habit_data.selected_head;
+            if (action == ACTION_MOVE_MODE || action == ACTION_CANCEL) {
+                imodule_invalidate(self); // the help block changes
                 habit_data.move_mode = false;
-            } else if (ch == KEY_UP) {
+            } else if (action == ACTION_UP) {
                 if (habit_data.selected_task == -1) { // moving a head
                     if (habit_data.selected_head > 0) {
-                        HabitHead temp = habit_data.heads[habit_data.selected_head];
-                        habit_data.heads[habit_data.selected_head] = habit_data.heads[habit_data.selected_head - 1];
-                        habit_data.heads[habit_data.selected_head - 1] = temp;
+                        habits_move_head(habit_data.selected_head, habit_data.selected_head - 1);
                         habit_data.selected_head--;
                     }
                 } else { // moving a task
                     int head_idx = habit_data.selected_head;
                     int task_idx = habit_data.selected_task;
-                    HabitHead* current_head = &habit_data.heads[head_idx];
+                    ItemHead* current_head = &habit_data.store.heads[head_idx];
 
                     if (task_idx > 0) { // move up within the same head
-                        Task temp = current_head->tasks[task_idx];
-                        current_head->tasks[task_idx] = current_head->tasks[task_idx - 1];
-                        current_head->tasks[task_idx - 1] = temp;
+                        habits_move_task(head_idx, task_idx, head_idx, task_idx - 1);
                         habit_data.selected_task--;
                     } else if (task_idx == 0 && head_idx > 0) { // move task to the previous head
-                        HabitHead* prev_head = &habit_data.heads[head_idx - 1];
-                        if (prev_head->task_count < MAX_TASKS_PER_HEAD) {
-                            Task task_to_move = current_head->tasks[task_idx];
-                            
-                            prev_head->tasks[prev_head->task_count] = task_to_move;
-                            prev_head->task_count++;
-                            
-                            memmove(&current_head->tasks[0], &current_head->tasks[1], (current_head->task_count - 1) * sizeof(Task));
-                            current_head->task_count--;
-                            
-                            habit_data.selected_head--;
-                            habit_data.selected_task = prev_head->task_count - 1;
-
-                            if (current_head->task_count == 0) {
-                                habit_data.selected_task = -1; // select the head if it's now empty
-                            }
+                        ItemHead* prev_head = &habit_data.store.heads[head_idx - 1];
+                        habits_move_task(head_idx, task_idx, head_idx - 1, prev_head->task_count);
+
+                        habit_data.selected_head--;
+                        habit_data.selected_task = prev_head->task_count - 1;
+
+                        if (current_head->task_count == 0) {
+                            habit_data.selected_task = -1; // select the head if it's now empty
                         }
                     }
                 }
-            } else if (ch == KEY_DOWN) {
+            } else if (action == ACTION_DOWN) {
                 if (habit_data.selected_task == -1) { // moving a head
-                    if (habit_data.selected_head < habit_data.head_count - 1) {
-                        HabitHead temp = habit_data.heads[habit_data.selected_head];
-                        habit_data.heads[habit_data.selected_head] = habit_data.heads[habit_data.selected_head + 1];
-                        habit_data.heads[habit_data.selected_head + 1] = temp;
+                    if (habit_data.selected_head < habit_data.store.head_count - 1) {
+                        habits_move_head(habit_data.selected_head, habit_data.selected_head + 1);
                         habit_data.selected_head++;
                     }
                 } else { // moving a task
                     int head_idx = habit_data.selected_head;
                     int task_idx = habit_data.selected_task;
-                    HabitHead* current_head = &habit_data.heads[head_idx];
+                    ItemHead* current_head = &habit_data.store.heads[head_idx];
 
                     if (task_idx < current_head->task_count - 1) { // move down within the same head
-                        Task temp = current_head->tasks[task_idx];
-                        current_head->tasks[task_idx] = current_head->tasks[task_idx + 1];
-                        current_head->tasks[task_idx + 1] = temp;
+                        habits_move_task(head_idx, task_idx, head_idx, task_idx + 1);
                         habit_data.selected_task++;
-                    } else if (task_idx == current_head->task_count - 1 && head_idx < habit_data.head_count - 1) { // move task to the next head
-                        HabitHead* next_head = &habit_data.heads[head_idx + 1];
-                        if (next_head->task_count < MAX_TASKS_PER_HEAD) {
-                            Task task_to_move = current_head->tasks[task_idx];
-
-                            memmove(&next_head->tasks[1], &next_head->tasks[0], next_head->task_count * sizeof(Task));
-                            
-                            next_head->tasks[0] = task_to_move;
-                            next_head->task_count++;
-                            
-                            current_head->task_count--;
-                            
-                            habit_data.selected_head++;
-                            habit_data.selected_task = 0;
-                        }
+                    } else if (task_idx == current_head->task_count - 1 && head_idx < habit_data.store.head_count - 1) { // move task to the next head
+                        habits_move_task(head_idx, task_idx, head_idx + 1, 0);
+
+                        habit_data.selected_head++;
+                        habit_data.selected_task = 0;
                     }
                 }
             }
+            invalidate_heads(self, moved_head, habit_data.selected_head);
             return; 
         }
 
         // standard edit mode commands
-        switch (ch) {
-            case 'E': case 'e': {
-                int next_ch = getch();
-                if (next_ch == 'I' || next_ch == 'i') {
-                    habit_data.edit_mode = false;
-                    ensure_task_selected();
-                }
+        switch (action) {
+            case ACTION_EDIT_MODE:
+                habit_data.edit_mode = false;
+                ensure_task_selected();
+                imodule_invalidate(self);
                 break;
-            }
-            case 'R': case 'r': {
-                int next_ch = getch();
-                if (next_ch == 'U' || next_ch == 'u') {
-                    if (habit_data.head_count < MAX_HEADS) {
-                        char new_head_name[MAX_NAME_LENGTH] = {0};
-                        if (prompt_for_string(tui->wm.panel_win, "Enter head name: ", new_head_name, MAX_NAME_LENGTH)) {
-                            habit_data.heads[habit_data.head_count].id = habit_data.head_count + 1;
-                            strncpy(habit_data.heads[habit_data.head_count].name, new_head_name, MAX_NAME_LENGTH - 1);
-                            habit_data.heads[habit_data.head_count].task_count = 0;
-                            habit_data.head_count++;
-                            habit_data.selected_head = habit_data.head_count - 1;
-                            habit_data.selected_task = -1;
-                        }
-                    }
-                } else if (next_ch == 'I' || next_ch == 'i') {
-                    int head_idx = habit_data.selected_head;
-                    HabitHead* head = &habit_data.heads[head_idx];
-
-                    if (head_idx >= 0 && head->task_count < MAX_TASKS_PER_HEAD) {
-                        int insert_pos = (habit_data.selected_task == -1) ? 0 : habit_data.selected_task + 1;
+            case ACTION_ADD_HEAD:
+                open_entry(self, "Enter head name: ", ENTRY_ADD_HEAD, -1, -1);
+                break;
+            case ACTION_ADD_ITEM: {
+                int head_idx = habit_data.selected_head;
+                if (head_idx < 0 || head_idx >= habit_data.store.head_count) break;
 
-                        char new_task_name[MAX_NAME_LENGTH] = {0};
-                        if (prompt_for_string(tui->wm.panel_win, "Enter task name: ", new_task_name, MAX_NAME_LENGTH)) {
-                            if (insert_pos < head->task_count) {
-                                memmove(&head->tasks[insert_pos + 1], 
-                                        &head->tasks[insert_pos], 
-                                        (head->task_count - insert_pos) * sizeof(Task));
-                            }
-                            
-                            head->task_count++;
-                            Task* new_task = &head->tasks[insert_pos];
-                            strncpy(new_task->name, new_task_name, MAX_NAME_LENGTH - 1);
-                            new_task->name[MAX_NAME_LENGTH - 1] = '\0';
-                            new_task->id = head->task_count;
-                            new_task->streak = 0;
-                            new_task->done_today = false;
-
-                            habit_data.selected_task = insert_pos;
-                        }
-                    }
-                }
-                habit_data.move_mode = false;
-                ensure_task_selected();
+                int insert_pos = (habit_data.selected_task == -1) ? 0 : habit_data.selected_task + 1;
+                open_entry(self, "Enter task name: ", ENTRY_ADD_ITEM, head_idx, insert_pos);
                 break;
             }
-            case 's': case 'S':
-                if (habit_data.head_count > 0) habit_data.move_mode = true;
+            case ACTION_JUMP:
+                open_entry(self, "Jump to head: ", ENTRY_JUMP, -1, -1);
+                break;
+            case ACTION_MOVE_MODE:
+                if (habit_data.store.head_count > 0) habit_data.move_mode = true;
+                imodule_invalidate(self);
                 break;
-            case 'd': case 'D':
+            case ACTION_DELETE:
+                imodule_invalidate(self);
                  if (habit_data.selected_task == -1) { // a head is selected
-                    if (habit_data.head_count > 0) {
-                        int head_to_delete = habit_data.selected_head;
-                        for (int i = head_to_delete; i < habit_data.head_count - 1; i++) {
-                            habit_data.heads[i] = habit_data.heads[i + 1];
-                        }
-                        habit_data.head_count--;
-                        if (habit_data.selected_head >= habit_data.head_count && habit_data.head_count > 0) {
-                            habit_data.selected_head = habit_data.head_count - 1;
-                        } else if (habit_data.head_count == 0) {
+                    if (habit_data.store.head_count > 0) {
+                        habits_delete_head(habit_data.selected_head);
+                        if (habit_data.selected_head >= habit_data.store.head_count && habit_data.store.head_count > 0) {
+                            habit_data.selected_head = habit_data.store.head_count - 1;
+                        } else if (habit_data.store.head_count == 0) {
                             habit_data.selected_head = 0;
                         }
                     }
                 } else { // a task is selected
                     int head_idx = habit_data.selected_head;
-                    if (head_idx >= 0 && habit_data.heads[head_idx].task_count > 0) {
-                        int task_to_delete = habit_data.selected_task;
-                        for (int i = task_to_delete; i < habit_data.heads[head_idx].task_count - 1; i++) {
-                            habit_data.heads[head_idx].tasks[i] = habit_data.heads[head_idx].tasks[i + 1];
-                        }
-                        habit_data.heads[head_idx].task_count--;
-                        if (habit_data.selected_task >= habit_data.heads[head_idx].task_count) {
-                            habit_data.selected_task = habit_data.heads[head_idx].task_count - 1;
+                    if (head_idx >= 0 && habit_data.store.heads[head_idx].task_count > 0) {
+                        habits_delete_task(head_idx, habit_data.selected_task);
+                        if (habit_data.selected_task >= habit_data.store.heads[head_idx].task_count) {
+                            habit_data.selected_task = habit_data.store.heads[head_idx].task_count - 1;
                         }
-                         if (habit_data.heads[head_idx].task_count == 0) {
+                         if (habit_data.store.heads[head_idx].task_count == 0) {
                             habit_data.selected_task = -1;
                         }
                     }
                 }
                 break;
-            case KEY_UP:
+            case ACTION_RENAME: {
+                int head_idx = habit_data.selected_head;
+                if (head_idx < 0 || head_idx >= habit_data.store.head_count) break;
+                open_entry(self, "Rename to: ", ENTRY_RENAME, head_idx, habit_data.selected_task);
+                break;
+            }
+            case ACTION_UP:
                 if (habit_data.selected_task > 0) {
                     habit_data.selected_task--;
                 } else if (habit_data.selected_task == 0) {
@@ -296,32 +756,32 @@ void habits_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                     if (habit_data.selected_head > 0) {
                         habit_data.selected_head--;
                     } else {
-                        habit_data.selected_head = habit_data.head_count - 1; // loop to the end
+                        habit_data.selected_head = habit_data.store.head_count - 1; // loop to the end
                     }
                     // select the last task of the new head, or the head itself if empty
-                    if (habit_data.head_count > 0 && habit_data.heads[habit_data.selected_head].task_count > 0) {
-                        habit_data.selected_task = habit_data.heads[habit_data.selected_head].task_count - 1;
+                    if (habit_data.store.head_count > 0 && habit_data.store.heads[habit_data.selected_head].task_count > 0) {
+                        habit_data.selected_task = habit_data.store.heads[habit_data.selected_head].task_count - 1;
                     } else {
                         habit_data.selected_task = -1;
                     }
                 }
                 break;
-            case KEY_DOWN:
+            case ACTION_DOWN:
                 if (habit_data.selected_task == -1) { // a head is selected
-                    if (habit_data.head_count > 0 && habit_data.heads[habit_data.selected_head].task_count > 0) {
+                    if (habit_data.store.head_count > 0 && habit_data.store.heads[habit_data.selected_head].task_count > 0) {
                         habit_data.selected_task = 0; // move to first task
                     } else { // empty head, move to next head
-                        if (habit_data.selected_head < habit_data.head_count - 1) {
+                        if (habit_data.selected_head < habit_data.store.head_count - 1) {
                             habit_data.selected_head++;
                         } else {
                             habit_data.selected_head = 0; // loop
                         }
                         habit_data.selected_task = -1;
                     }
-                } else if (habit_data.selected_task < habit_data.heads[habit_data.selected_head].task_count - 1) {
+                } else if (habit_data.selected_task < habit_data.store.heads[habit_data.selected_head].task_count - 1) {
                     habit_data.selected_task++;
                 } else { // last task, move to next head
-                    if (habit_data.selected_head < habit_data.head_count - 1) {
+                    if (habit_data.selected_head < habit_data.store.head_count - 1) {
                         habit_data.selected_head++;
                     } else {
                         habit_data.selected_head = 0; // loop
@@ -329,64 +789,69 @@ void habits_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                     habit_data.selected_task = -1;
                 }
                 break;
-            case 27: // esc
+            case ACTION_CANCEL:
             habit_data.edit_mode = false;
                 habit_data.move_mode = false;
+                imodule_invalidate(self);
+                break;
+            default:
                 break;
         }
     } else {
         // normal mode commands
         int total_tasks = 0;
-        for (int i = 0; i < habit_data.head_count; i++) {
-            total_tasks += habit_data.heads[i].task_count;
+        for (int i = 0; i < habit_data.store.head_count; i++) {
+            total_tasks += habit_data.store.heads[i].task_count;
         }
         if (total_tasks == 0) {
-             if (ch == 'E' || ch == 'e') {
-                int next_ch = getch();
-                if (next_ch == 'I' || next_ch == 'i') habit_data.edit_mode = true;
+             if (action == ACTION_EDIT_MODE) {
+                habit_data.edit_mode = true;
+                imodule_invalidate(self);
             }
             return; // no tasks to navigate
         }
 
         ensure_task_selected();
 
-        switch (ch) {
-            case 'E': case 'e': {
-                int next_ch = getch();
-                if (next_ch == 'I' || next_ch == 'i') habit_data.edit_mode = true;
+        switch (action) {
+            case ACTION_EDIT_MODE:
+                habit_data.edit_mode = true;
+                imodule_invalidate(self);
                 break;
-            }
-            case KEY_UP:
+            case ACTION_JUMP:
+                open_entry(self, "Jump to head: ", ENTRY_JUMP, -1, -1);
+                break;
+            case ACTION_UP:
                 if (habit_data.selected_task > 0) {
                     habit_data.selected_task--;
                 } else { // first task of current head, find previous task
                     bool found_prev = false;
                     for (int h = habit_data.selected_head - 1; h >= 0; h--) {
-                        if (habit_data.heads[h].task_count > 0) {
+                        if (habit_data.store.heads[h].task_count > 0) {
                             habit_data.selected_head = h;
-                            habit_data.selected_task = habit_data.heads[h].task_count - 1;
+                            habit_data.selected_task = habit_data.store.heads[h].task_count - 1;
                             found_prev = true;
                             break;
                         }
                     }
                     if (!found_prev) { // loop from the end
-                        for (int h = habit_data.head_count - 1; h >= 0; h--) {
-                            if (habit_data.heads[h].task_count > 0) {
+                        for (int h = habit_data.store.head_count - 1; h >= 0; h--) {
+                            if (habit_data.store.heads[h].task_count > 0) {
                                 habit_data.selected_head = h;
-                                habit_data.selected_task = habit_data.heads[h].task_count - 1;
+                                habit_data.selected_task = habit_data.store.heads[h].task_count - 1;
                                 break;
                             }
                         }
                     }
                 }
                 break;
-            case KEY_DOWN:
-                if (habit_data.selected_task < habit_data.heads[habit_data.selected_head].task_count - 1) {
+            case ACTION_DOWN:
+                if (habit_data.selected_task < habit_data.store.heads[habit_data.selected_head].task_count - 1) {
                     habit_data.selected_task++;
                 } else { // last task of current head, find next task
                     bool found_next = false;
-                    for (int h = habit_data.selected_head + 1; h < habit_data.head_count; h++) {
-                        if (habit_data.heads[h].task_count > 0) {
+                    for (int h = habit_data.selected_head + 1; h < habit_data.store.head_count; h++) {
+                        if (habit_data.store.heads[h].task_count > 0) {
                             habit_data.selected_head = h;
                             habit_data.selected_task = 0;
                             found_next = true;
@@ -394,8 +859,8 @@ void habits_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                         }
                     }
                     if (!found_next) { // loop from the beginning
-                        for (int h = 0; h < habit_data.head_count; h++) {
-                            if (habit_data.heads[h].task_count > 0) {
+                        for (int h = 0; h < habit_data.store.head_count; h++) {
+                            if (habit_data.store.heads[h].task_count > 0) {
                                 habit_data.selected_head = h;
                                 habit_data.selected_task = 0;
                                 break;
@@ -404,171 +869,213 @@ void habits_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                     }
                 }
                 break;
-            case ' ':
+            case ACTION_TOGGLE:
                 // toggle task completion
                 if (habit_data.selected_head >= 0 && habit_data.selected_task >= 0) {
                     int head_idx = habit_data.selected_head;
                     int task_idx = habit_data.selected_task;
-                    Task* task = &habit_data.heads[head_idx].tasks[task_idx];
-                    
-                    task->done_today = !task->done_today;
-                    if (task->done_today) {
-                        task->streak++;
-                    } else {
-                        if (task->streak > 0) {
-                            task->streak--;
-                        }
-                    }
+                    habits_toggle_today(head_idx, task_idx);
+                    int row = habit_row(head_idx, task_idx);
+                    imodule_invalidate_rows(self, row, row);
                 }
                 break;
+            default:
+                break;
         }
     }
 }
 
-static int parse_csv_line(char *line, char **fields, int max_fields) {
-    int field_count = 0;
-    char *p = line;
-    
-    while (*p && field_count < max_fields) {
-        char *start;
-        if (*p == '"') {
-            p++; // Skip "
-            start = p;
-            while (*p && *p != '"') {
-                p++;
-            }
-            if (*p == '"') {
-                *p = '\0';
-                p++;
-            }
-        } else {
-            start = p;
-            while (*p && *p != ',') {
-                p++;
-            }
-        }
-        
-        if (*p == ',') {
-            *p = '\0';
-            p++;
+void habits_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui) {
+    (void)tui;
+    int old_head = habit_data.selected_head;
+    int old_task = habit_data.selected_task;
+
+    if (habit_data.entry.active) {
+        handle_entry(self, action, key);
+    } else {
+        handle_action(self, action);
+    }
+
+    // moving the cursor only repaints the rows it left and landed on, unless
+    // the list has to scroll to keep it in view
+    if (old_head != habit_data.selected_head || old_task != habit_data.selected_task) {
+        if (list_view_follow(&habit_data.store.view, list_row(habit_data.selected_head, habit_data.selected_task))) {
+            imodule_invalidate(self);
+            return;
         }
-        
-        fields[field_count++] = start;
+        int old_row = habit_row(old_head, old_task);
+        int new_row = habit_row(habit_data.selected_head, habit_data.selected_task);
+        imodule_invalidate_rows(self, old_row, old_row);
+        imodule_invalidate_rows(self, new_row, new_row);
     }
-    
-    return field_count;
 }
 
-int habits_load(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        return 1;
-    }
+void habits_module_leave(struct IModule* self) {
+    (void)self;
+    text_entry_cancel(&habit_data.entry);
+    list_view_release(&habit_data.store.view);
+}
 
-    char line[512];
-    habits_init(); 
+void habits_module_idle(struct IModule* self) {
+    (void)self;
+    item_store_drop_search(&habit_data.store);
+}
+
+bool habits_module_takes_text(const struct IModule* self) {
+    (void)self;
+    return habit_data.entry.active;
+}
 
-    // Skip header
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
+size_t habits_module_memory(const struct IModule* self) {
+    (void)self;
+    return habit_data.arena.reserved;
+}
+
+int habits_load(const char* filename) {
+    CacheKey key;
+    bool have_csv = cache_key_for(filename, &key) == 0;
+    if (have_csv && load_cache(filename, &key)) {
+        snapshot_journal_open(&habit_journal, filename, key.hash, replay_record, NULL);
         return 0;
     }
 
-    while (fgets(line, sizeof(line), file)) {
-        line[strcspn(line, "\r\n")] = 0;
-        if (strlen(line) == 0) continue;
+    habits_init(); 
+    CsvReader csv;
+    if (csv_open(&csv, filename) != 0) {
+        // a journal may exist even without a snapshot
+        snapshot_journal_open(&habit_journal, filename, cache_key_hash(filename, &key), replay_record, NULL);
+        return 1;
+    }
 
-        char *fields[4];
-        int num_fields = parse_csv_line(line, fields, 4);
+    csv_next(&csv); // header
+    // files from before the history only kept the current streak, as of
+    // the last_update day the old daily reset left in settings.conf. with
+    // no date that reset would run now, so the file is taken as yesterday's.
+    const char* last_update = config_get("last_update");
+    int legacy_day;
+    if (!last_update || !history_parse_date(last_update, strlen(last_update), &legacy_day)) {
+        legacy_day = habit_data.today - 1;
+    }
 
+    int num_fields;
+    while ((num_fields = csv_next(&csv)) >= 0) {
         if (num_fields < 2) continue;
         
-        char* head_name = fields[0];
-        char* task_name = fields[1];
-        char* streak_str = (num_fields > 2) ? fields[2] : "0";
-        char* done_today_str = (num_fields > 3) ? fields[3] : "0";
-
-        int head_idx = -1;
-        for (int i = 0; i < habit_data.head_count; i++) {
-            if (strcmp(habit_data.heads[i].name, head_name) == 0) {
-                head_idx = i;
-                break;
-            }
-        }
+        CsvField head_name = csv.fields[0];
+        CsvField task_name = csv.fields[1];
+
+        int head_idx = item_store_find_head(&habit_data.store, head_name.ptr, head_name.len);
 
         if (head_idx == -1) {
-            if (habit_data.head_count >= MAX_HEADS) continue;
-            head_idx = habit_data.head_count;
-            HabitHead* new_head = &habit_data.heads[head_idx];
-            strncpy(new_head->name, head_name, MAX_NAME_LENGTH - 1);
-            new_head->name[MAX_NAME_LENGTH-1] = '\0';
-            new_head->task_count = 0;
-            habit_data.head_count++;
+            if (!item_store_add_head(&habit_data.store, head_name.ptr, head_name.len)) continue;
+            head_idx = habit_data.store.head_count - 1;
         }
 
-        if (strlen(task_name) == 0) {
+        if (task_name.len == 0) {
             continue;
         }
 
-        HabitHead* head = &habit_data.heads[head_idx];
-        if (head->task_count < MAX_TASKS_PER_HEAD) {
-            int task_idx = head->task_count;
-            Task* task = &head->tasks[task_idx];
-            strncpy(task->name, task_name, MAX_NAME_LENGTH - 1);
-            task->name[MAX_NAME_LENGTH - 1] = '\0';
-            task->streak = atoi(streak_str);
-            task->done_today = atoi(done_today_str);
-            task->id = task_idx + 1;
-            head->task_count++;
+        Task* task = item_store_insert(&habit_data.store, head_idx, habit_data.store.heads[head_idx].task_count,
+                                       task_name.ptr, task_name.len);
+        if (task) {
+            task->id = habit_data.store.heads[head_idx].task_count;
+            if (num_fields > 4) {
+                CsvField days = csv.fields[4];
+                history_parse(&task->history, &habit_data.arena, days.ptr, days.len);
+            } else {
+                int streak = num_fields > 2 ? (int)csv_field_long(csv.fields[2]) : 0;
+                bool done_today = num_fields > 3 && csv_field_long(csv.fields[3]) != 0;
+                int last = done_today ? legacy_day : legacy_day - 1;
+                if (streak > 0) history_set_range(&task->history, &habit_data.arena, last - streak + 1, last);
+            }
         }
     }
 
-    fclose(file);
+    csv_close(&csv);
+    // before the journal is replayed: the cache mirrors the CSV alone
+    if (have_csv) write_cache(filename, &key);
+    snapshot_journal_open(&habit_journal, filename, cache_key_hash(filename, &key), replay_record, NULL);
     return 0;
 }
 
 int habits_save(const char* filename) {
-    FILE* file = fopen(filename, "w");
+    PersistFile out;
+    FILE* file = persist_begin(&out, filename);
     if (!file) {
         return 1;
     }
 
-    fprintf(file, "head_name,task_name,streak,done_today\n");
+    // streak and done_today are derived, kept for whatever else reads the file
+    fprintf(file, "head_name,task_name,streak,done_today,history\n");
 
-    for (int h = 0; h < habit_data.head_count; h++) {
-        if (habit_data.heads[h].task_count == 0) {
-            fprintf(file, "\"%s\",\"\",0,0\n", habit_data.heads[h].name);
+    int today = habit_data.today;
+    char small[1024];
+    char* days = small;
+    size_t days_size = sizeof(small);
+    bool ok = true;
+    CsvWriter csv;
+    csv_writer_init(&csv, file);
+    for (int h = 0; ok && h < habit_data.store.head_count; h++) {
+        if (habit_data.store.heads[h].task_count == 0) {
+            csv_write_text(&csv, text_of(habit_data.store.heads[h].name));
+            csv_write_text(&csv, "");
+            csv_write_long(&csv, 0);
+            csv_write_long(&csv, 0);
+            csv_write_text(&csv, "");
+            csv_end_record(&csv);
         } else {
-            for (int t = 0; t < habit_data.heads[h].task_count; t++) {
-                fprintf(file, "\"%s\",\"%s\",%d,%d\n",
-                        habit_data.heads[h].name,
-                        habit_data.heads[h].tasks[t].name,
-                        habit_data.heads[h].tasks[t].streak,
-                        (int)habit_data.heads[h].tasks[t].done_today);
+            for (int t = 0; ok && t < habit_data.store.heads[h].task_count; t++) {
+                Task* task = habit_at(h, t);
+                size_t needed = history_format(&task->history, days, days_size) + 1;
+                if (needed > days_size) {
+                    // a long history with many gaps, rare enough to size exactly
+                    char* bigger = arena_resize(&habit_data.arena, days == small ? NULL : days, needed);
+                    ok = bigger != NULL;
+                    if (!ok) break;
+                    days = bigger;
+                    days_size = needed;
+                    history_format(&task->history, days, days_size);
+                }
+                csv_write_text(&csv, text_of(habit_data.store.heads[h].name));
+                csv_write_text(&csv, text_of(task->name));
+                csv_write_long(&csv, history_streak(&task->history, today));
+                csv_write_long(&csv, history_get(&task->history, today));
+                csv_write_text(&csv, days);
+                csv_end_record(&csv);
             }
         }
     }
 
-    fclose(file);
+    if (days != small) arena_release(&habit_data.arena, days);
+    if (!ok) {
+        persist_abort(&out);
+        return 1;
+    }
+
+    // written to a temp file and renamed, the old snapshot stays intact on failure
+    if (persist_commit(&out) != 0) return 1;
+
+    // the snapshot now holds everything, start a fresh journal on top of it
+    if (snapshot_journal_owns(&habit_journal, filename)) {
+        CacheKey key;
+        cache_key_for(filename, &key);
+        journal_reset(&habit_journal.journal, cache_key_hash(filename, &key));
+        write_cache(filename, &key);
+    }
     return 0;
 }
 
-void habits_daily_update(void) {
-    for (int h = 0; h < habit_data.head_count; h++) {
-        for (int t = 0; t < habit_data.heads[h].task_count; t++) {
-            Task* task = &habit_data.heads[h].tasks[t];
-            if (!task->done_today) {
-                task->streak = 0;
-            }
-            task->done_today = false;
-        }
-    }
+// every streak and today's marks are read off the histories relative to
+// habit_data.today, so any number of days passing is this one assignment
+bool habits_set_today(int day) {
+    if (day == habit_data.today) return false;
+    habit_data.today = day;
+    return true;
 }
 
 void habits_toggle_today(int head_idx, int task_idx) {
-    if (head_idx >= 0 && head_idx < habit_data.head_count &&
-        task_idx >= 0 && task_idx < habit_data.heads[head_idx].task_count) {
-        habit_data.heads[head_idx].tasks[task_idx].done_today = 
-            !habit_data.heads[head_idx].tasks[task_idx].done_today;
+    if (valid_task(head_idx, task_idx)) {
+        int today = habit_data.today;
+        habits_set_done(head_idx, task_idx, today, !history_get(&habit_at(head_idx, task_idx)->history, today));
     }
 } 
\ No newline at end of file
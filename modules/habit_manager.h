@@ -2,21 +2,59 @@
 #define HABIT_MANAGER_H
 
 #include <ncurses.h>
+#include "imodule.h"
 #include "structs.h"
 
-struct IModule;
 struct MinimalTui;
 
 void habits_init();
 void habits_cleanup();
 
 void habits_module_render(struct IModule* self, WINDOW* win);
-void habits_module_handle_input(struct IModule* self, int ch, struct MinimalTui* tui);
-void habits_daily_update(void);
+void habits_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui);
+// drops the row layout while the list is hidden
+void habits_module_leave(struct IModule* self);
+// drops the search index, rebuilt by the next search
+void habits_module_idle(struct IModule* self);
+size_t habits_module_memory(const struct IModule* self);
+bool habits_module_takes_text(const struct IModule* self);
 
+// loads the CSV snapshot and replays data/<name>.journal on top of it
 int habits_load(const char* filename);
+// writes a full snapshot; for the loaded file this also compacts the journal
 int habits_save(const char* filename);
+// flushes on exit: compacts if the journal grew large, closes it. does
+// nothing when nothing was loaded
+int habits_close(void);
+// whether habits_load ran since the last close
+bool habits_is_loaded(void);
 int get_habit_count();
+// moves "today" on at midnight. nothing stored changes, days without a mark
+// are simply missed; true when the list needs repainting.
+bool habits_set_today(int day);
+// flips today's mark, one journal record
 void habits_toggle_today(int head_idx, int task_idx);
 
+// text bytes stored (deleted text included until the next compaction)
+// against bytes allocated for them
+void habits_string_usage(size_t* used, size_t* reserved);
+
+// palette search over habit and head names, best first. a head's hit
+// carries -1 - its id as doc, a habit's its slot.
+int habits_search(const GramQuery* query, GramHit* hits, int max);
+// text of a hit, NULL once the item is gone
+const char* habits_hit_text(int doc);
+// selects the hit's habit or head
+void habits_reveal(int doc);
+
+// journaled mutations, each costs one appended record
+void habits_add_head(const char* name);
+void habits_add_task(int head, int pos, const char* name);
+void habits_delete_head(int head);
+void habits_delete_task(int head, int task);
+void habits_move_head(int from, int to);
+void habits_move_task(int from_head, int from_task, int to_head, int to_task);
+void habits_set_done(int head, int task, int day, bool done); // day as in history.h
+void habits_rename(int head, int task, const char* text); // task == -1 renames the head
+
 #endif 
\ No newline at end of file
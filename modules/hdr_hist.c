@@ -0,0 +1,77 @@
+#include "hdr_hist.h"
+#include <string.h>
+
+#define HDR_LIMIT ((1ULL << (HDR_MAX_SHIFT + HDR_SUB_BITS)) - 1)
+
+// below 2^HDR_SUB_BITS the value is its own bucket; above, value >> shift
+// lands in [HDR_HALF, 2 * HDR_HALF) and shift picks the group of buckets
+static int bucket_of(uint64_t value) {
+    if (value > HDR_LIMIT) value = HDR_LIMIT;
+    if (value < 2 * HDR_HALF) return (int)value;
+    int shift = 63 - __builtin_clzll(value) - (HDR_SUB_BITS - 1);
+    return shift * HDR_HALF + (int)(value >> shift);
+}
+
+static uint64_t highest_in(int bucket) {
+    if (bucket < 2 * HDR_HALF) return (uint64_t)bucket;
+    int shift = bucket / HDR_HALF - 1;
+    uint64_t sub = (uint64_t)(bucket - shift * HDR_HALF);
+    return ((sub + 1) << shift) - 1;
+}
+
+void hdr_reset(HdrHist* h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hdr_record_n(HdrHist* h, uint64_t value, uint32_t n) {
+    if (n == 0) return;
+    if (h->count == 0 || value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    h->count += n;
+    h->total += value * n;
+    h->buckets[bucket_of(value)] += n;
+}
+
+void hdr_record(HdrHist* h, uint64_t value) {
+    hdr_record_n(h, value, 1);
+}
+
+uint64_t hdr_value_at(const HdrHist* h, double pct) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(pct / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > h->count) rank = h->count;
+    uint64_t seen = 0;
+    for (int i = 0; i < HDR_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            // the bucket's top may overshoot what was actually seen
+            uint64_t v = highest_in(i);
+            return v > h->max ? h->max : v;
+        }
+    }
+    return h->max;
+}
+
+double hdr_mean(const HdrHist* h) {
+    return h->count ? (double)h->total / (double)h->count : 0.0;
+}
+
+void hdr_write(const HdrHist* h, FILE* out, double scale) {
+    fprintf(out, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    uint64_t seen = 0;
+    for (int i = 0; i < HDR_BUCKETS && seen < h->count; i++) {
+        if (h->buckets[i] == 0) continue;
+        seen += h->buckets[i];
+        uint64_t v = highest_in(i);
+        if (v > h->max) v = h->max;
+        double pct = (double)seen / (double)h->count;
+        if (seen < h->count) {
+            fprintf(out, "%12.3f %14.12f %10llu %14.2f\n", v / scale, pct, (unsigned long long)seen, 1.0 / (1.0 - pct));
+        } else {
+            fprintf(out, "%12.3f %14.12f %10llu\n", v / scale, pct, (unsigned long long)seen);
+        }
+    }
+    fprintf(out, "#[Mean    = %12.3f, Max        = %12.3f]\n", hdr_mean(h) / scale, h->max / scale);
+    fprintf(out, "#[Min     = %12.3f, TotalCount = %12llu]\n", h->min / scale, (unsigned long long)h->count);
+}
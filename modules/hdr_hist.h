@@ -0,0 +1,38 @@
+#ifndef HDR_HIST_H
+#define HDR_HIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// log-linear histogram in the HdrHistogram style: values below 64 get a
+// bucket each, above that every power of two is split into 32 buckets, so
+// any recorded value is known to within about 3% while the whole range of
+// 1 ns to 36 minutes fits in a fixed 4.6 KB table. recording is a shift and
+// an increment, cheap enough to leave on in every build.
+#define HDR_SUB_BITS 6
+#define HDR_HALF (1 << (HDR_SUB_BITS - 1))
+#define HDR_MAX_SHIFT 35 // values above 2^41 are clamped
+#define HDR_BUCKETS ((HDR_MAX_SHIFT + 2) * HDR_HALF)
+
+typedef struct {
+    uint64_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint32_t buckets[HDR_BUCKETS];
+} HdrHist;
+
+void hdr_reset(HdrHist* h);
+void hdr_record(HdrHist* h, uint64_t value);
+void hdr_record_n(HdrHist* h, uint64_t value, uint32_t n);
+
+// the value below which pct percent of the recordings fall (the highest
+// value its bucket stands for), 0 when nothing was recorded
+uint64_t hdr_value_at(const HdrHist* h, double pct);
+double hdr_mean(const HdrHist* h);
+
+// percentile distribution in the .hgrm text layout (value, percentile,
+// total count, 1/(1-percentile)) with values divided by scale
+void hdr_write(const HdrHist* h, FILE* out, double scale);
+
+#endif
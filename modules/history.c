@@ -0,0 +1,261 @@
+#include "history.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define WORD_BITS 64
+
+static int floor_div(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static int bit_count(const HabitHistory* h) {
+    return h->block_count * HISTORY_BLOCK_DAYS;
+}
+
+// bit of day, negative or >= bit_count when it is outside the stored blocks
+static int bit_of(const HabitHistory* h, int day) {
+    return day - h->first_block * HISTORY_BLOCK_DAYS;
+}
+
+// bits [lo, hi] of one word, 0 <= lo <= hi < 64
+static uint64_t word_mask(int lo, int hi) {
+    uint64_t upto = hi == WORD_BITS - 1 ? ~0ULL : (1ULL << (hi + 1)) - 1;
+    return upto & ~((1ULL << lo) - 1);
+}
+
+bool history_get(const HabitHistory* h, int day) {
+    int i = bit_of(h, day);
+    if (i < 0 || i >= bit_count(h)) return false;
+    return (h->words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+// makes the stored blocks cover days [from, to]
+static bool cover(HabitHistory* h, Arena* arena, int from, int to) {
+    int first = floor_div(from, HISTORY_BLOCK_DAYS);
+    int last = floor_div(to, HISTORY_BLOCK_DAYS);
+    if (h->block_count > 0) {
+        int old_last = h->first_block + h->block_count - 1;
+        if (first >= h->first_block && last <= old_last) return true;
+        if (first > h->first_block) first = h->first_block;
+        if (last < old_last) last = old_last;
+    }
+
+    size_t words = (size_t)(last - first + 1) * HISTORY_BLOCK_WORDS;
+    uint64_t* grown = arena_resize(arena, h->words, words * sizeof(uint64_t));
+    if (!grown) return false;
+    // the old blocks move up by however many were added in front
+    size_t old_words = (size_t)h->block_count * HISTORY_BLOCK_WORDS;
+    size_t shift = h->block_count > 0 ? (size_t)(h->first_block - first) * HISTORY_BLOCK_WORDS : 0;
+    memmove(&grown[shift], grown, old_words * sizeof(uint64_t));
+    memset(grown, 0, shift * sizeof(uint64_t));
+    memset(&grown[shift + old_words], 0, (words - shift - old_words) * sizeof(uint64_t));
+
+    h->words = grown;
+    h->first_block = first;
+    h->block_count = last - first + 1;
+    return true;
+}
+
+bool history_set(HabitHistory* h, Arena* arena, int day, bool done) {
+    int i = bit_of(h, day);
+    if (!done) {
+        // clearing outside the stored blocks changes nothing
+        if (i >= 0 && i < bit_count(h)) h->words[i / WORD_BITS] &= ~(1ULL << (i % WORD_BITS));
+        return true;
+    }
+    if (!cover(h, arena, day, day)) return false;
+    i = bit_of(h, day);
+    h->words[i / WORD_BITS] |= 1ULL << (i % WORD_BITS);
+    return true;
+}
+
+bool history_set_range(HabitHistory* h, Arena* arena, int from, int to) {
+    if (from > to) return true;
+    if (!cover(h, arena, from, to)) return false;
+    int lo = bit_of(h, from);
+    int hi = bit_of(h, to);
+    for (int w = lo / WORD_BITS; w <= hi / WORD_BITS; w++) {
+        int a = w == lo / WORD_BITS ? lo % WORD_BITS : 0;
+        int b = w == hi / WORD_BITS ? hi % WORD_BITS : WORD_BITS - 1;
+        h->words[w] |= word_mask(a, b);
+    }
+    return true;
+}
+
+void history_release(HabitHistory* h, Arena* arena) {
+    arena_release(arena, h->words);
+    memset(h, 0, sizeof(*h));
+}
+
+// --- Kernels ---
+
+// first bit at or after i that is set (or clear), bit_count if none is
+static int next_bit(const HabitHistory* h, int i, bool set) {
+    int n = bit_count(h);
+    if (i >= n) return n;
+    int w = i / WORD_BITS;
+    uint64_t flip = set ? 0 : ~0ULL;
+    uint64_t word = (h->words[w] ^ flip) & ~((1ULL << (i % WORD_BITS)) - 1);
+    while (word == 0) {
+        if (++w == n / WORD_BITS) return n;
+        word = h->words[w] ^ flip;
+    }
+    return w * WORD_BITS + __builtin_ctzll(word);
+}
+
+int history_run_back(const HabitHistory* h, int day) {
+    int i = bit_of(h, day);
+    if (i < 0 || i >= bit_count(h)) return 0;
+    int run = 0;
+    int w = i / WORD_BITS;
+    int b = i % WORD_BITS;
+    for (; w >= 0; w--, b = WORD_BITS - 1) {
+        // clear bits at or below b; the highest one ends the run
+        uint64_t gaps = ~h->words[w] & word_mask(0, b);
+        if (gaps != 0) return run + b - (WORD_BITS - 1 - __builtin_clzll(gaps));
+        run += b + 1;
+    }
+    return run;
+}
+
+int history_streak(const HabitHistory* h, int today) {
+    int run = history_run_back(h, today);
+    return run > 0 ? run : history_run_back(h, today - 1);
+}
+
+int history_best_run(const HabitHistory* h) {
+    int best = 0;
+    int n = bit_count(h);
+    for (int i = next_bit(h, 0, true); i < n; ) {
+        int end = next_bit(h, i, false);
+        if (end - i > best) best = end - i;
+        i = next_bit(h, end, true);
+    }
+    return best;
+}
+
+int history_count(const HabitHistory* h, int from, int to) {
+    int lo = bit_of(h, from);
+    int hi = bit_of(h, to);
+    if (lo < 0) lo = 0;
+    if (hi >= bit_count(h)) hi = bit_count(h) - 1;
+    if (lo > hi) return 0;
+    int count = 0;
+    for (int w = lo / WORD_BITS; w <= hi / WORD_BITS; w++) {
+        int a = w == lo / WORD_BITS ? lo % WORD_BITS : 0;
+        int b = w == hi / WORD_BITS ? hi % WORD_BITS : WORD_BITS - 1;
+        count += __builtin_popcountll(h->words[w] & word_mask(a, b));
+    }
+    return count;
+}
+
+// --- Dates ---
+// proleptic gregorian, eras of 400 years (146097 days) starting in march
+
+int history_day(int year, int month, int mday) {
+    year -= month <= 2;
+    int era = floor_div(year, 400);
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + mday - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void history_date(int day, int* year, int* month, int* mday) {
+    day += 719468;
+    int era = floor_div(day, 146097);
+    int doe = day - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    *mday = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
+int history_today(void) {
+    return history_day_at(time(NULL));
+}
+
+int history_day_at(int64_t unix_seconds) {
+    time_t at = (time_t)unix_seconds;
+    struct tm tm_at;
+    localtime_r(&at, &tm_at);
+    return history_day(tm_at.tm_year + 1900, tm_at.tm_mon + 1, tm_at.tm_mday);
+}
+
+// --- Text ---
+
+static size_t put_date(char* out, size_t size, size_t pos, int day) {
+    int y, m, d;
+    history_date(day, &y, &m, &d);
+    int n = snprintf(pos < size ? out + pos : NULL, pos < size ? size - pos : 0, "%04d-%02d-%02d", y, m, d);
+    return pos + (size_t)n;
+}
+
+static size_t put_text(char* out, size_t size, size_t pos, const char* text) {
+    int n = snprintf(pos < size ? out + pos : NULL, pos < size ? size - pos : 0, "%s", text);
+    return pos + (size_t)n;
+}
+
+size_t history_format(const HabitHistory* h, char* out, size_t size) {
+    if (size > 0) out[0] = '\0';
+    size_t pos = 0;
+    int base = h->first_block * HISTORY_BLOCK_DAYS;
+    int n = bit_count(h);
+    for (int i = next_bit(h, 0, true); i < n; ) {
+        int end = next_bit(h, i, false);
+        if (pos > 0) pos = put_text(out, size, pos, " ");
+        pos = put_date(out, size, pos, base + i);
+        if (end - 1 > i) {
+            pos = put_text(out, size, pos, "..");
+            pos = put_date(out, size, pos, base + end - 1);
+        }
+        i = next_bit(h, end, true);
+    }
+    return pos;
+}
+
+bool history_parse_date(const char* s, size_t len, int* day) {
+    if (len != 10 || s[4] != '-' || s[7] != '-') return false;
+    int v[3] = {0, 0, 0};
+    int field = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (i == 4 || i == 7) {
+            field++;
+        } else if (s[i] >= '0' && s[i] <= '9') {
+            v[field] = v[field] * 10 + (s[i] - '0');
+        } else {
+            return false;
+        }
+    }
+    if (v[1] < 1 || v[1] > 12 || v[2] < 1 || v[2] > 31) return false;
+    *day = history_day(v[0], v[1], v[2]);
+    int y, m, d;
+    history_date(*day, &y, &m, &d);
+    return y == v[0] && m == v[1] && d == v[2];
+}
+
+bool history_parse(HabitHistory* h, Arena* arena, const char* text, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && text[i] == ' ') i++;
+        size_t start = i;
+        while (i < len && text[i] != ' ') i++;
+        size_t n = i - start;
+        if (n == 0) continue;
+
+        const char* token = text + start;
+        int from, to;
+        if (n == 22 && token[10] == '.' && token[11] == '.') {
+            if (!history_parse_date(token, 10, &from) || !history_parse_date(token + 12, 10, &to)) continue;
+        } else if (history_parse_date(token, n, &from)) {
+            to = from;
+        } else {
+            continue;
+        }
+        if (!history_set_range(h, arena, from, to)) return false;
+    }
+    return true;
+}
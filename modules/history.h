@@ -0,0 +1,57 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+// a habit's day by day record, one bit per day. days are counted from
+// 1970-01-01 in local civil time. bits are kept in blocks of a little over a
+// year, block b holding days [b * HISTORY_BLOCK_DAYS, (b + 1) * ...), and
+// only the blocks from the first to the last day ever marked are stored, so
+// a decade costs about 500 bytes per habit.
+//
+// streaks, best streaks and completion counts are word scans and popcounts,
+// never per day loops.
+#define HISTORY_BLOCK_WORDS 6
+#define HISTORY_BLOCK_DAYS (HISTORY_BLOCK_WORDS * 64)
+
+typedef struct {
+    int first_block;
+    int block_count; // 0 when nothing was ever marked
+    uint64_t* words; // block_count * HISTORY_BLOCK_WORDS, from the arena
+} HabitHistory;
+
+bool history_get(const HabitHistory* h, int day);
+// grows the bitset as needed; false only when the arena is out of memory
+bool history_set(HabitHistory* h, Arena* arena, int day, bool done);
+// marks every day in [from, to]
+bool history_set_range(HabitHistory* h, Arena* arena, int from, int to);
+void history_release(HabitHistory* h, Arena* arena);
+
+// consecutive marked days ending at day (inclusive), 0 if day isn't marked
+int history_run_back(const HabitHistory* h, int day);
+// the current streak: the run through today, or through yesterday while
+// today is still open
+int history_streak(const HabitHistory* h, int today);
+int history_best_run(const HabitHistory* h);
+// marked days in [from, to]
+int history_count(const HabitHistory* h, int from, int to);
+
+// day numbers of civil dates and back
+int history_day(int year, int month, int mday);
+void history_date(int day, int* year, int* month, int* mday);
+int history_today(void);
+int history_day_at(int64_t unix_seconds); // the local date at that instant
+
+// marked days as ISO dates, runs collapsed into ranges:
+// "2025-01-01..2025-01-07 2025-01-09". returns the length the text needs
+// (like snprintf), out is only written up to size.
+size_t history_format(const HabitHistory* h, char* out, size_t size);
+// "YYYY-MM-DD" exactly, and a date that exists
+bool history_parse_date(const char* text, size_t len, int* day);
+// adds the days named by text in the format above. junk tokens are skipped.
+bool history_parse(HabitHistory* h, Arena* arena, const char* text, size_t len);
+
+#endif
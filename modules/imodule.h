@@ -3,14 +3,83 @@
 
 #include <ncurses.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 struct MinimalTui; // Forward declaration
 
+// what a key, or a chord of keys, means. the keymap (src/keymap.c) resolves
+// keys against the active module's bindings before anything sees them, so
+// modules switch on actions and never wait for a second key themselves.
+typedef enum {
+    ACTION_NONE,        // unbound; text entry still gets the key
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_CONFIRM,
+    ACTION_BACK,
+    ACTION_EXIT,
+    ACTION_CANCEL,
+    ACTION_SEARCH,
+    ACTION_PROFILER,
+    ACTION_TOGGLE,      // mark done, start/pause
+    ACTION_EDIT_MODE,
+    ACTION_ADD_HEAD,
+    ACTION_ADD_ITEM,
+    ACTION_JUMP,
+    ACTION_MOVE_MODE,
+    ACTION_DELETE,
+    ACTION_RENAME,
+    ACTION_RESET,
+    ACTION_CYCLE_MODE,
+    ACTION_EDIT_WORK,
+    ACTION_EDIT_REST,
+    ACTION_UNDO,
+    ACTION_REDO,
+    ACTION_COUNT
+} InputAction;
+
 typedef struct IModule {
     const char* name;
     void (*render)(struct IModule* self, WINDOW* win);
-    void (*handle_input)(struct IModule* self, int ch, struct MinimalTui* tui);
+    // key is the one that completed the action; only text entry looks at it
+    void (*handle_input)(struct IModule* self, InputAction action, int key, struct MinimalTui* tui);
+
+    // lifecycle, every hook optional (NULL). on_leave runs when the module
+    // goes off screen and is where render caches go; opening a module
+    // repaints it in full, so there is no matching on_enter.
+    void (*on_leave)(struct IModule* self);
+    // runs once the deadline it returned last time comes, and after input
+    // that may have moved it; returns the next one (event loop time), 0 for
+    // none. hidden modules keep ticking.
+    uint64_t (*tick)(struct IModule* self, uint64_t now);
+    // nobody has pressed a key for a while, or zinc went over its memory
+    // budget: shed what can be rebuilt
+    void (*on_idle)(struct IModule* self);
+    // bytes the module holds right now
+    size_t (*memory_usage)(const struct IModule* self);
+    // true while a text field has the keyboard: keys then skip the keymap
+    // and arrive as ACTION_NONE with the key, except enter (ACTION_CONFIRM)
+    // and esc (ACTION_CANCEL)
+    bool (*takes_text)(const struct IModule* self);
     void* data; // Pointer to module-specific data
+
+    // invalidation state, owned by the frame pipeline in minimal_tui.c.
+    // render is only called while dirty; when full_redraw is false only rows
+    // dirty_top..dirty_bottom (window coordinates) need repainting.
+    bool dirty;
+    bool full_redraw;
+    int dirty_top;
+    int dirty_bottom;
+    uint64_t next_tick; // what tick returned last, kept by minimal_tui.c
 } IModule;
 
-#endif 
\ No newline at end of file
+// mark the whole module window for repaint
+void imodule_invalidate(IModule* self);
+// mark rows top..bottom (inclusive) for repaint, merged with any pending range
+void imodule_invalidate_rows(IModule* self, int top, int bottom);
+// true when row y has to be drawn in the current render pass
+bool imodule_row_dirty(const IModule* self, int y);
+
+#endif 
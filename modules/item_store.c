@@ -0,0 +1,511 @@
+#include "item_store.h"
+#include "journal.h"
+#include <string.h>
+
+#define SEARCH_MAX 32
+
+void item_store_init(ItemStore* store, Arena* arena, size_t item_size, size_t text_offset) {
+    memset(store, 0, sizeof(*store));
+    store->arena = arena;
+    store->item_size = item_size;
+    store->text_offset = text_offset;
+    str_arena_init(&store->strings, arena);
+    name_index_init(&store->head_index, arena);
+    list_view_init(&store->view, arena);
+    gram_index_init(&store->item_grams, arena);
+    gram_index_init(&store->head_grams, arena);
+}
+
+// --- Storage ---
+// every array lives in the owner's arena and grows on demand; items sit in
+// one contiguous vector and heads hold slot numbers into it
+
+void* item_store_slot(const ItemStore* store, int slot) {
+    return (char*)store->items + (size_t)slot * store->item_size;
+}
+
+void* item_store_at(const ItemStore* store, int head, int pos) {
+    return item_store_slot(store, store->heads[head].items[pos]);
+}
+
+static StrRef* text_ref(const ItemStore* store, int slot) {
+    return (StrRef*)((char*)item_store_slot(store, slot) + store->text_offset);
+}
+
+const char* item_store_text(const ItemStore* store, StrRef ref) {
+    return str_get(&store->strings, ref);
+}
+
+bool item_store_valid(const ItemStore* store, int head, int pos) {
+    return head >= 0 && head < store->head_count &&
+           pos >= 0 && pos < store->heads[head].task_count;
+}
+
+void item_store_clamp(const ItemStore* store, int* head, int* pos) {
+    if (*head < 0) *head = 0;
+    if (*head >= store->head_count) *head = store->head_count - 1;
+    int count = store->heads[*head].task_count;
+    if (*pos >= count) *pos = count - 1;
+    if (*pos < -1) *pos = -1;
+}
+
+// deletes and renames only mark their text as garbage; once that is half
+// the buffer, rebuild it from the strings still referenced
+static void compact_strings(ItemStore* store) {
+    StrArena* sa = &store->strings;
+    if (!str_arena_wants_compaction(sa) || !str_arena_compact_begin(sa)) return;
+    for (int h = 0; h < store->head_count; h++) {
+        ItemHead* head = &store->heads[h];
+        str_arena_relocate(sa, &head->name);
+        for (int t = 0; t < head->task_count; t++) {
+            str_arena_relocate(sa, text_ref(store, head->items[t]));
+        }
+    }
+    str_arena_compact_end(sa);
+}
+
+// head_index keeps every head under the hash of its name. callers take a
+// range of heads out before shifting or renaming them and put it back after.
+static uint32_t head_hash(const ItemStore* store, int head) {
+    StrRef name = store->heads[head].name;
+    return name_index_hash(item_store_text(store, name), name.length);
+}
+
+static bool index_heads(ItemStore* store, int from, int to) {
+    for (int h = from; h <= to; h++) {
+        if (!name_index_add(&store->head_index, head_hash(store, h), h)) return false;
+        store->head_pos[store->heads[h].id] = h;
+    }
+    return true;
+}
+
+static void unindex_heads(ItemStore* store, int from, int to) {
+    for (int h = from; h <= to; h++) {
+        name_index_remove(&store->head_index, head_hash(store, h), h);
+    }
+}
+
+int item_store_find_head(const ItemStore* store, const char* name, size_t len) {
+    uint32_t hash = name_index_hash(name, len);
+    int best = -1;
+    int cursor = 0;
+    int h;
+    while ((h = name_index_next(&store->head_index, hash, &cursor)) >= 0) {
+        if ((best == -1 || h < best) && str_ref_equals(&store->strings, store->heads[h].name, name, len)) {
+            best = h;
+        }
+    }
+    return best;
+}
+
+// the palette's trigram indexes: items by slot and heads by id, both stay
+// put when things move, so only adding, deleting and renaming touch them.
+// they are built by the first search, loading doesn't pay for them.
+static void search_add_item(ItemStore* store, int slot) {
+    if (!store->grams_ready) return;
+    StrRef text = *text_ref(store, slot);
+    gram_index_add(&store->item_grams, slot, item_store_text(store, text), text.length);
+}
+
+static void search_remove_item(ItemStore* store, int slot) {
+    if (!store->grams_ready) return;
+    StrRef text = *text_ref(store, slot);
+    gram_index_remove(&store->item_grams, slot, item_store_text(store, text), text.length);
+}
+
+static void search_add_head(ItemStore* store, int head) {
+    if (!store->grams_ready) return;
+    StrRef text = store->heads[head].name;
+    gram_index_add(&store->head_grams, store->heads[head].id, item_store_text(store, text), text.length);
+}
+
+static void search_remove_head(ItemStore* store, int head) {
+    if (!store->grams_ready) return;
+    StrRef text = store->heads[head].name;
+    gram_index_remove(&store->head_grams, store->heads[head].id, item_store_text(store, text), text.length);
+}
+
+static int alloc_slot(ItemStore* store) {
+    if (store->free_count > 0) return store->free_slots[--store->free_count];
+    void* items = arena_grow(store->arena, store->items, &store->item_capacity,
+                             store->item_count + 1, store->item_size);
+    if (!items) return -1;
+    store->items = items;
+    return store->item_count++;
+}
+
+static void free_slot(ItemStore* store, int slot) {
+    int* free_slots = arena_grow(store->arena, store->free_slots, &store->free_capacity,
+                                 store->free_count + 1, sizeof(int));
+    if (!free_slots) return; // the slot just stays unused
+    store->free_slots = free_slots;
+    store->free_slots[store->free_count++] = slot;
+}
+
+// a head's slot numbers sit inside their block with free room at both
+// ends, so a member joins or leaves either end without the rest moving and
+// anywhere else only the shorter side shifts
+static int* member_block(const ItemHead* head) {
+    return head->items ? head->items - head->front : NULL;
+}
+
+// room for needed members after the front room
+static bool reserve_members(ItemStore* store, ItemHead* head, int needed) {
+    int* block = arena_grow(store->arena, member_block(head), &head->capacity,
+                            head->front + needed, sizeof(int));
+    if (!block) return false;
+    head->items = block + head->front;
+    return true;
+}
+
+// makes sure both ends can take a member. an end that ran out gets the
+// free room split evenly again, the block doubling first when little is
+// left, so this is amortised O(1) per insert
+static bool reserve_ends(ItemStore* store, ItemHead* head) {
+    int count = head->task_count;
+    if (head->front > 0 && head->capacity - head->front - count > 0) return true;
+    int* block = member_block(head);
+    if (head->capacity - count < count / 2 + 2) {
+        block = arena_grow(store->arena, block, &head->capacity, 2 * count + 2, sizeof(int));
+        if (!block) return false;
+    }
+    int front = (head->capacity - count) / 2;
+    memmove(block + front, block + head->front, count * sizeof(int));
+    head->items = block + front;
+    head->front = front;
+    return true;
+}
+
+// reserve_ends must have succeeded
+static void insert_member(ItemHead* head, int pos, int slot) {
+    if (pos < head->task_count - pos) {
+        head->items--;
+        head->front--;
+        memmove(&head->items[0], &head->items[1], pos * sizeof(int));
+    } else if (pos < head->task_count) {
+        memmove(&head->items[pos + 1], &head->items[pos], (head->task_count - pos) * sizeof(int));
+    }
+    head->items[pos] = slot;
+    head->task_count++;
+}
+
+static int remove_member(ItemHead* head, int pos) {
+    int slot = head->items[pos];
+    if (pos < head->task_count - 1 - pos) {
+        memmove(&head->items[1], &head->items[0], pos * sizeof(int));
+        head->items++;
+        head->front++;
+    } else if (pos < head->task_count - 1) {
+        memmove(&head->items[pos], &head->items[pos + 1], (head->task_count - pos - 1) * sizeof(int));
+    }
+    head->task_count--;
+    return slot;
+}
+
+// --- Edits ---
+
+// takes a name already stored, the cache hands them over that way
+static ItemHead* push_head(ItemStore* store, StrRef name) {
+    ItemHead* heads = arena_grow(store->arena, store->heads, &store->head_capacity,
+                                 store->head_count + 1, sizeof(ItemHead));
+    if (!heads) return NULL;
+    store->heads = heads;
+    int* head_pos = arena_grow(store->arena, store->head_pos, &store->head_pos_capacity,
+                               store->next_head_id + 1, sizeof(int));
+    if (!head_pos) return NULL;
+    store->head_pos = head_pos;
+
+    ItemHead* head = &heads[store->head_count];
+    memset(head, 0, sizeof(*head));
+    head->id = store->next_head_id;
+    head->name = name;
+    if (!index_heads(store, store->head_count, store->head_count)) return NULL;
+    store->next_head_id++;
+    search_add_head(store, store->head_count);
+    store->head_count++;
+    list_view_invalidate(&store->view);
+    return head;
+}
+
+ItemHead* item_store_add_head(ItemStore* store, const char* name, size_t len) {
+    return push_head(store, str_intern_n(&store->strings, name, len));
+}
+
+void* item_store_insert(ItemStore* store, int head_idx, int pos, const char* text, size_t len) {
+    if (head_idx < 0 || head_idx >= store->head_count) return NULL;
+    ItemHead* head = &store->heads[head_idx];
+    if (pos < 0 || pos > head->task_count) return NULL;
+    if (!reserve_ends(store, head)) return NULL;
+    int slot = alloc_slot(store);
+    if (slot < 0) return NULL;
+
+    insert_member(head, pos, slot);
+    list_view_invalidate(&store->view);
+    void* item = item_store_slot(store, slot);
+    memset(item, 0, store->item_size); // the slot may be reused
+    *text_ref(store, slot) = str_intern_n(&store->strings, text, len);
+    search_add_item(store, slot);
+    return item;
+}
+
+static void release_item(ItemStore* store, int slot, ItemFn release, void* ctx) {
+    search_remove_item(store, slot);
+    str_release(&store->strings, *text_ref(store, slot));
+    if (release) release(item_store_slot(store, slot), ctx);
+    free_slot(store, slot);
+}
+
+bool item_store_delete_head(ItemStore* store, int head_idx, ItemFn release, void* ctx) {
+    if (head_idx < 0 || head_idx >= store->head_count) return false;
+    ItemHead* head = &store->heads[head_idx];
+    unindex_heads(store, head_idx, store->head_count - 1);
+    search_remove_head(store, head_idx);
+    str_release(&store->strings, head->name);
+    for (int t = 0; t < head->task_count; t++) {
+        release_item(store, head->items[t], release, ctx);
+    }
+    arena_release(store->arena, member_block(head));
+    if (head_idx < store->head_count - 1) {
+        memmove(&store->heads[head_idx], &store->heads[head_idx + 1],
+                (store->head_count - head_idx - 1) * sizeof(ItemHead));
+    }
+    store->head_count--;
+    index_heads(store, head_idx, store->head_count - 1);
+    list_view_invalidate(&store->view);
+    compact_strings(store);
+    return true;
+}
+
+bool item_store_delete(ItemStore* store, int head, int pos, ItemFn release, void* ctx) {
+    if (!item_store_valid(store, head, pos)) return false;
+    release_item(store, remove_member(&store->heads[head], pos), release, ctx);
+    list_view_invalidate(&store->view);
+    compact_strings(store);
+    return true;
+}
+
+bool item_store_move_head(ItemStore* store, int from, int to) {
+    if (from < 0 || from >= store->head_count || to < 0 || to >= store->head_count) return false;
+    int lo = from < to ? from : to;
+    int hi = from < to ? to : from;
+    unindex_heads(store, lo, hi);
+    ItemHead temp = store->heads[from];
+    if (hi - lo == 1) {
+        // move mode only ever moves by one: a swap
+        store->heads[from] = store->heads[to];
+    } else if (from < to) {
+        memmove(&store->heads[from], &store->heads[from + 1], (to - from) * sizeof(ItemHead));
+    } else if (from > to) {
+        memmove(&store->heads[to + 1], &store->heads[to], (from - to) * sizeof(ItemHead));
+    }
+    store->heads[to] = temp;
+    index_heads(store, lo, hi);
+    list_view_update(&store->view, lo, hi);
+    return true;
+}
+
+bool item_store_move(ItemStore* store, int from_head, int from_pos, int to_head, int to_pos) {
+    if (!item_store_valid(store, from_head, from_pos) || to_head < 0 || to_head >= store->head_count) return false;
+    ItemHead* dst = &store->heads[to_head];
+    int limit = dst->task_count - (from_head == to_head ? 1 : 0);
+    if (to_pos < 0 || to_pos > limit) return false;
+
+    if (from_head == to_head) {
+        // slides the slots in between along, a swap for neighbours
+        int slot = dst->items[from_pos];
+        if (from_pos < to_pos) {
+            memmove(&dst->items[from_pos], &dst->items[from_pos + 1], (to_pos - from_pos) * sizeof(int));
+        } else if (from_pos > to_pos) {
+            memmove(&dst->items[to_pos + 1], &dst->items[to_pos], (from_pos - to_pos) * sizeof(int));
+        }
+        dst->items[to_pos] = slot;
+        return true;
+    }
+    if (!reserve_ends(store, dst)) return false;
+    insert_member(dst, to_pos, remove_member(&store->heads[from_head], from_pos));
+    int lo = from_head < to_head ? from_head : to_head;
+    int hi = from_head < to_head ? to_head : from_head;
+    list_view_update(&store->view, lo, hi);
+    return true;
+}
+
+bool item_store_rename(ItemStore* store, int head, int pos, const char* text) {
+    if (head < 0 || head >= store->head_count) return false;
+    if (pos != -1 && !item_store_valid(store, head, pos)) return false;
+    StrRef* ref;
+    if (pos == -1) {
+        ref = &store->heads[head].name;
+        unindex_heads(store, head, head);
+        search_remove_head(store, head);
+    } else {
+        ref = text_ref(store, store->heads[head].items[pos]);
+        search_remove_item(store, store->heads[head].items[pos]);
+    }
+    str_release(&store->strings, *ref);
+    *ref = str_intern(&store->strings, text);
+    if (pos == -1) {
+        index_heads(store, head, head);
+        search_add_head(store, head);
+    } else {
+        search_add_item(store, store->heads[head].items[pos]);
+    }
+    compact_strings(store);
+    return true;
+}
+
+// --- Search ---
+
+static void build_search_index(ItemStore* store) {
+    if (store->grams_ready) return;
+    store->grams_ready = true;
+    for (int h = 0; h < store->head_count; h++) {
+        search_add_head(store, h);
+        for (int t = 0; t < store->heads[h].task_count; t++) {
+            search_add_item(store, store->heads[h].items[t]);
+        }
+    }
+}
+
+static const char* item_text(int doc, size_t* len, void* ctx) {
+    const ItemStore* store = ctx;
+    StrRef text = *text_ref(store, doc);
+    *len = text.length;
+    return item_store_text(store, text);
+}
+
+static const char* head_text(int doc, size_t* len, void* ctx) {
+    const ItemStore* store = ctx;
+    StrRef name = store->heads[store->head_pos[doc]].name;
+    *len = name.length;
+    return item_store_text(store, name);
+}
+
+int item_store_hit_head(const ItemStore* store, int doc) {
+    int id = -1 - doc;
+    if (id < 0 || id >= store->next_head_id) return -1;
+    int h = store->head_pos[id];
+    return h >= 0 && h < store->head_count && store->heads[h].id == id ? h : -1;
+}
+
+int item_store_search(ItemStore* store, const GramQuery* query, GramHit* hits, int max) {
+    if (max > SEARCH_MAX) max = SEARCH_MAX;
+    GramHit head_hits[SEARCH_MAX];
+    build_search_index(store);
+    int n = gram_index_search(&store->item_grams, query, item_text, store, hits, max);
+    int m = gram_index_search(&store->head_grams, query, head_text, store, head_hits, max);
+
+    // merge the heads in, ahead of items that score the same
+    for (int i = 0; i < m; i++) {
+        GramHit hit = {-1 - head_hits[i].doc, head_hits[i].score};
+        int pos;
+        if (n < max) {
+            pos = n++;
+        } else if (hits[max - 1].score <= hit.score) {
+            pos = max - 1;
+        } else {
+            break; // head hits are sorted, the rest score lower still
+        }
+        while (pos > 0 && hits[pos - 1].score <= hit.score) {
+            hits[pos] = hits[pos - 1];
+            pos--;
+        }
+        hits[pos] = hit;
+    }
+    return n;
+}
+
+const char* item_store_hit_text(const ItemStore* store, int doc) {
+    if (doc < 0) {
+        int h = item_store_hit_head(store, doc);
+        return h >= 0 ? item_store_text(store, store->heads[h].name) : NULL;
+    }
+    return doc < store->item_count ? item_store_text(store, *text_ref(store, doc)) : NULL;
+}
+
+bool item_store_locate(const ItemStore* store, int slot, int* head, int* pos) {
+    // slots don't know their head, a reveal is rare enough to just look
+    for (int h = 0; h < store->head_count; h++) {
+        for (int t = 0; t < store->heads[h].task_count; t++) {
+            if (store->heads[h].items[t] == slot) {
+                *head = h;
+                *pos = t;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void item_store_drop_search(ItemStore* store) {
+    if (!store->grams_ready) return;
+    gram_index_release(&store->item_grams);
+    gram_index_release(&store->head_grams);
+    store->grams_ready = false;
+}
+
+// --- Binary cache ---
+// the cache holds the store as parsed from its CSV: heads with their items
+// in display order, and the string buffer as is
+
+bool item_store_adopt(ItemStore* store, const CacheView* view) {
+    bool ok = str_arena_adopt(&store->strings, view->strings, view->string_bytes);
+    for (uint32_t i = 0; ok && i < view->item_count; i++) {
+        const char* item = (const char*)view->items + i * store->item_size;
+        StrRef text;
+        memcpy(&text, item + store->text_offset, sizeof(text));
+        ok = str_ref_valid(&store->strings, text);
+    }
+    if (ok && view->item_count > 0) {
+        void* dst = arena_grow(store->arena, store->items, &store->item_capacity,
+                               (int)view->item_count, store->item_size);
+        ok = dst != NULL;
+        if (ok) {
+            memcpy(dst, view->items, view->item_count * store->item_size);
+            store->items = dst;
+            store->item_count = (int)view->item_count;
+        }
+    }
+    for (uint32_t h = 0; ok && h < view->head_count; h++) {
+        const CacheHead* cached = &view->heads[h];
+        ItemHead* head = str_ref_valid(&store->strings, cached->name) ? push_head(store, cached->name) : NULL;
+        ok = head && reserve_members(store, head, (int)cached->count);
+        for (uint32_t t = 0; ok && t < cached->count; t++) {
+            head->items[t] = (int)(cached->first + t);
+        }
+        if (ok) head->task_count = (int)cached->count;
+    }
+    return ok;
+}
+
+void item_store_write_cache(ItemStore* store, const char* csv_path, CacheKey* key,
+                            ItemFn pack, void* ctx, const void* extra, uint32_t extra_bytes) {
+    if (cache_key_hash(csv_path, key) == 0) return;
+    int total = 0;
+    for (int h = 0; h < store->head_count; h++) total += store->heads[h].task_count;
+
+    CacheHead* heads = arena_alloc(store->arena, (store->head_count + 1) * sizeof(CacheHead));
+    char* items = arena_alloc(store->arena, (total + 1) * store->item_size);
+    if (heads && items) {
+        uint32_t n = 0;
+        for (int h = 0; h < store->head_count; h++) {
+            heads[h].name = store->heads[h].name;
+            heads[h].first = n;
+            heads[h].count = (uint32_t)store->heads[h].task_count;
+            for (int t = 0; t < store->heads[h].task_count; t++) {
+                void* copy = items + n++ * store->item_size;
+                memcpy(copy, item_store_at(store, h, t), store->item_size);
+                if (pack) pack(copy, ctx);
+            }
+        }
+
+        char path[JOURNAL_PATH_LENGTH];
+        cache_path_for(csv_path, path, sizeof(path));
+        uint32_t string_bytes;
+        const char* strings = str_arena_buffer(&store->strings, &string_bytes);
+        cache_write(path, key, heads, (uint32_t)store->head_count,
+                    items, (uint32_t)total, (uint32_t)store->item_size,
+                    extra, extra_bytes, strings, string_bytes);
+    }
+    arena_release(store->arena, heads);
+    arena_release(store->arena, items);
+}
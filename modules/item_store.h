@@ -0,0 +1,105 @@
+#ifndef ITEM_STORE_H
+#define ITEM_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "str_arena.h"
+#include "name_index.h"
+#include "list_view.h"
+#include "gram_index.h"
+#include "state_cache.h"
+
+// the lists both managers keep: named heads, each listing slots of one
+// contiguous vector of fixed size items in display order. moving an item
+// only moves its slot number, and a deleted item's slot is reused. every
+// item carries its text as a StrRef at text_offset; the store keeps that
+// text, the head names, the name lookup, the row layout and the palette
+// search in step. the rest of the item is the owner's.
+typedef struct {
+    int id;
+    StrRef name;
+    int* items;     // inside a block with room left at both ends
+    int front;      // free ints before items[0]
+    int task_count;
+    int capacity;   // of the whole block
+} ItemHead;
+
+// what the owner does per item: release what it holds besides its text
+// before the slot is freed, or strip pointers from a copy bound for the cache
+typedef void (*ItemFn)(void* item, void* ctx);
+
+typedef struct {
+    Arena* arena;        // the owner's, holds every array below
+    size_t item_size;
+    size_t text_offset;  // of the item's StrRef
+    StrArena strings;    // head names and item texts
+    void* items;         // a slot keeps its item until it's deleted
+    int item_count;      // slots handed out so far, free ones included
+    int item_capacity;
+    int* free_slots;     // deleted slots, reused before items grows
+    int free_count;
+    int free_capacity;
+    ItemHead* heads;
+    int head_count;
+    int head_capacity;
+    NameIndex head_index; // head name -> position in heads
+    ListView view;        // scroll position and row layout of the list
+    GramIndex item_grams; // palette search: items by slot,
+    GramIndex head_grams; // heads by id
+    bool grams_ready;     // built on the first search, kept current after
+    int* head_pos;        // head id -> position in heads
+    int head_pos_capacity;
+    int next_head_id;     // ids are never reused
+} ItemStore;
+
+// an empty store; arena must outlive it, resetting the arena frees it
+void item_store_init(ItemStore* store, Arena* arena, size_t item_size, size_t text_offset);
+
+void* item_store_slot(const ItemStore* store, int slot);
+void* item_store_at(const ItemStore* store, int head, int pos);
+// only valid until the next string is stored
+const char* item_store_text(const ItemStore* store, StrRef ref);
+bool item_store_valid(const ItemStore* store, int head, int pos);
+// keeps a cursor on the list: head within it, pos from -1 (the head
+// itself) to its last item. the list must have a head.
+void item_store_clamp(const ItemStore* store, int* head, int* pos);
+// first head with this name, -1 if there is none
+int item_store_find_head(const ItemStore* store, const char* name, size_t len);
+
+// edits; a failed one (false or NULL) leaves the store as it was
+ItemHead* item_store_add_head(ItemStore* store, const char* name, size_t len);
+// claims a slot at pos in the head for an item with this text, the rest of
+// it zeroed for the caller to fill
+void* item_store_insert(ItemStore* store, int head, int pos, const char* text, size_t len);
+// release (may be NULL) sees each item before its slot is freed
+bool item_store_delete_head(ItemStore* store, int head, ItemFn release, void* ctx);
+bool item_store_delete(ItemStore* store, int head, int pos, ItemFn release, void* ctx);
+bool item_store_move_head(ItemStore* store, int from, int to);
+// takes the item out of from_head and inserts it at to_pos in to_head
+bool item_store_move(ItemStore* store, int from_head, int from_pos, int to_head, int to_pos);
+// pos == -1 renames the head itself
+bool item_store_rename(ItemStore* store, int head, int pos, const char* text);
+
+// palette search over item texts and head names, best first. a head's hit
+// carries -1 - its id as doc, an item's its slot.
+int item_store_search(ItemStore* store, const GramQuery* query, GramHit* hits, int max);
+// text of a hit, NULL once the head is gone
+const char* item_store_hit_text(const ItemStore* store, int doc);
+// position of the head a hit names, -1 once it is gone
+int item_store_hit_head(const ItemStore* store, int doc);
+// where a slot sits in the list, false if no head lists it
+bool item_store_locate(const ItemStore* store, int slot, int* head, int* pos);
+// drops the search index, rebuilt by the next search
+void item_store_drop_search(ItemStore* store);
+
+// fills a freshly initialised store from a cache's heads, items and
+// strings. false if the cache doesn't hold together; the store is then
+// half filled and wants initialising again.
+bool item_store_adopt(ItemStore* store, const CacheView* view);
+// writes data/<name>.cache for the CSV the store was just loaded from or
+// saved to. pack (may be NULL) sees each item's copy; extra as in cache_write
+void item_store_write_cache(ItemStore* store, const char* csv_path, CacheKey* key,
+                            ItemFn pack, void* ctx, const void* extra, uint32_t extra_bytes);
+
+#endif
@@ -0,0 +1,250 @@
+#include "journal.h"
+#include "persist.h"
+#include "../src/event_loop.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JOURNAL_MAGIC "#zinc-journal 1"
+
+uint64_t journal_file_hash(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+
+    uint64_t hash = 14695981039346656037ULL;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            hash ^= buf[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    fclose(f);
+    return hash ? hash : 1; // 0 is reserved for "no snapshot"
+}
+
+void journal_path_for(const char* snapshot, char* out, int out_size) {
+    int len = (int)strlen(snapshot);
+    if (len > 4 && strcmp(snapshot + len - 4, ".csv") == 0) len -= 4;
+    snprintf(out, out_size, "%.*s.journal", len, snapshot);
+}
+
+static void header_for(uint64_t base_hash, char* out, int out_size) {
+    snprintf(out, out_size, "%s %016llx\n", JOURNAL_MAGIC, (unsigned long long)base_hash);
+}
+
+static int write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// splits a record on tabs and undoes the escaping, in place
+static int split_record(char* line, char** argv) {
+    int argc = 0;
+    char* p = line;
+    while (argc < JOURNAL_MAX_FIELDS) {
+        argv[argc++] = p;
+        char* out = p;
+        while (*p && *p != '\t') {
+            if (*p == '\\' && p[1]) {
+                p++;
+                *out++ = (*p == 't') ? '\t' : (*p == 'n') ? '\n' : *p;
+                p++;
+            } else {
+                *out++ = *p++;
+            }
+        }
+        bool more = (*p == '\t');
+        *out = '\0';
+        if (!more) break;
+        p++;
+    }
+    return argc;
+}
+
+// applies the complete records in buf and returns how many bytes are valid
+static long replay(char* buf, long len, uint64_t base_hash, JournalApplyFn apply, void* ctx, int* count) {
+    char header[64];
+    header_for(base_hash, header, sizeof(header));
+    long header_len = (long)strlen(header);
+    if (len < header_len || memcmp(buf, header, header_len) != 0) {
+        return 0; // written against another snapshot, or no header at all
+    }
+
+    long pos = header_len;
+    while (pos < len) {
+        char* line = buf + pos;
+        char* nl = memchr(line, '\n', len - pos);
+        if (!nl) break; // torn write from a crash, drop it
+        *nl = '\0';
+
+        char* argv[JOURNAL_MAX_FIELDS];
+        int argc = split_record(line, argv);
+        if (argc > 0 && argv[0][0]) {
+            apply(argc, argv, ctx);
+            (*count)++;
+        }
+        pos = (nl - buf) + 1;
+    }
+    return pos;
+}
+
+int journal_open(Journal* j, const char* path, uint64_t base_hash, JournalApplyFn apply, void* ctx) {
+    j->fd = -1;
+    j->size = 0;
+    j->base_hash = base_hash;
+    strncpy(j->path, path, JOURNAL_PATH_LENGTH - 1);
+    j->path[JOURNAL_PATH_LENGTH - 1] = '\0';
+
+    int replayed = 0;
+    long valid = 0;
+    FILE* f = fopen(path, "rb");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        char* buf = malloc(len + 1);
+        if (buf && fread(buf, 1, len, f) == (size_t)len) {
+            buf[len] = '\0';
+            valid = replay(buf, len, base_hash, apply, ctx, &replayed);
+        }
+        free(buf);
+        fclose(f);
+    }
+
+    j->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (j->fd < 0) return -1;
+
+    if (valid == 0) {
+        if (journal_reset(j, base_hash) != 0) return -1;
+    } else {
+        if (ftruncate(j->fd, valid) != 0) return -1;
+        j->size = valid;
+    }
+    return replayed;
+}
+
+void journal_close(Journal* j) {
+    if (j->fd >= 0) {
+        if (persist_should_sync()) fdatasync(j->fd);
+        close(j->fd);
+    }
+    j->fd = -1;
+}
+
+int journal_append(Journal* j, int argc, const char** argv) {
+    if (j->fd < 0) return 1;
+    uint64_t started = persist_clock_ns();
+
+    // worst case every byte gets escaped, plus separators and the newline
+    size_t need = 1;
+    for (int i = 0; i < argc; i++) need += 2 * strlen(argv[i]) + 1;
+
+    char stack_buf[JOURNAL_RECORD_LENGTH];
+    char* buf = need <= sizeof(stack_buf) ? stack_buf : malloc(need);
+    if (!buf) return 1;
+
+    size_t len = 0;
+    for (int i = 0; i < argc; i++) {
+        if (i > 0) buf[len++] = '\t';
+        for (const char* p = argv[i]; *p; p++) {
+            if (*p == '\t') { buf[len++] = '\\'; buf[len++] = 't'; }
+            else if (*p == '\n') { buf[len++] = '\\'; buf[len++] = 'n'; }
+            else if (*p == '\\') { buf[len++] = '\\'; buf[len++] = '\\'; }
+            else buf[len++] = *p;
+        }
+    }
+    buf[len++] = '\n';
+
+    // one write per record: a crash can only tear the record being written
+    int rc = write_all(j->fd, buf, len);
+    if (rc == 0 && persist_policy() == PERSIST_SYNC_EVERY_SAVE && fdatasync(j->fd) != 0) rc = 1;
+    if (rc == 0) j->size += (long)len;
+    if (buf != stack_buf) free(buf);
+    persist_record(PERSIST_STAT_JOURNAL, started);
+    return rc;
+}
+
+int journal_reset(Journal* j, uint64_t base_hash) {
+    if (j->fd < 0) return 1;
+    char header[64];
+    header_for(base_hash, header, sizeof(header));
+    if (ftruncate(j->fd, 0) != 0) return 1;
+    j->base_hash = base_hash;
+    j->size = 0;
+    if (write_all(j->fd, header, strlen(header)) != 0) return 1;
+    j->size = (long)strlen(header);
+    return 0;
+}
+
+bool journal_is_open(const Journal* j) {
+    return j->fd >= 0;
+}
+
+bool journal_needs_compaction(const Journal* j) {
+    return j->fd >= 0 && j->size > JOURNAL_COMPACT_BYTES;
+}
+
+// --- Snapshot journals ---
+
+#define COMPACT_DELAY_NS (2 * NSEC_PER_SEC) // let a burst of edits settle first
+
+static void compact_cb(void* ctx) {
+    SnapshotJournal* sj = ctx;
+    sj->compact_timer = -1;
+    if (journal_needs_compaction(&sj->journal)) {
+        sj->save(sj->snapshot);
+    }
+}
+
+void snapshot_journal_open(SnapshotJournal* sj, const char* snapshot, uint64_t snapshot_hash,
+                           JournalApplyFn apply, void* ctx) {
+    char path[JOURNAL_PATH_LENGTH];
+    journal_close(&sj->journal);
+    strncpy(sj->snapshot, snapshot, JOURNAL_PATH_LENGTH - 1);
+    sj->snapshot[JOURNAL_PATH_LENGTH - 1] = '\0';
+    journal_path_for(snapshot, path, sizeof(path));
+    journal_open(&sj->journal, path, snapshot_hash, apply, ctx);
+}
+
+void snapshot_journal_append(SnapshotJournal* sj, int argc, const char** argv) {
+    if (journal_append(&sj->journal, argc, argv) != 0) return;
+    if (journal_needs_compaction(&sj->journal) && sj->compact_timer < 0) {
+        sj->compact_timer = event_loop_timer_start(compact_cb, sj, event_loop_now() + COMPACT_DELAY_NS, 0);
+    }
+}
+
+int snapshot_journal_close(SnapshotJournal* sj) {
+    event_loop_timer_stop(sj->compact_timer);
+    sj->compact_timer = -1;
+    // never loaded: saving now would write an empty list over the file
+    if (!snapshot_journal_is_loaded(sj)) return 0;
+    int rc = 0;
+    // without a journal the snapshot is the only copy, so it has to be written
+    if (!journal_is_open(&sj->journal) || journal_needs_compaction(&sj->journal)) {
+        rc = sj->save(sj->snapshot);
+    }
+    journal_close(&sj->journal);
+    sj->snapshot[0] = '\0';
+    return rc;
+}
+
+bool snapshot_journal_is_loaded(const SnapshotJournal* sj) {
+    return sj->snapshot[0] != '\0';
+}
+
+bool snapshot_journal_owns(const SnapshotJournal* sj, const char* filename) {
+    return journal_is_open(&sj->journal) && strcmp(filename, sj->snapshot) == 0;
+}
@@ -0,0 +1,71 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define JOURNAL_PATH_LENGTH 256
+#define JOURNAL_MAX_FIELDS 8
+#define JOURNAL_RECORD_LENGTH 1024
+#define JOURNAL_COMPACT_BYTES (64 * 1024) // fold into a fresh snapshot past this
+
+// append-only log of mutations on top of a CSV snapshot. every record is one
+// tab-separated line written with a single write(2); the header line names
+// the snapshot (by content hash) the records apply to, so a journal left
+// over from before the last snapshot is recognised and discarded.
+typedef struct {
+    int fd;
+    char path[JOURNAL_PATH_LENGTH];
+    long size;
+    uint64_t base_hash;
+} Journal;
+
+typedef void (*JournalApplyFn)(int argc, char** argv, void* ctx);
+
+// FNV-1a over the whole file, 0 when it can't be read
+uint64_t journal_file_hash(const char* path);
+// "data/tasks.csv" -> "data/tasks.journal"
+void journal_path_for(const char* snapshot, char* out, int out_size);
+
+// replays every complete record whose header matches base_hash, then opens
+// the journal for appending (dropping a torn last record, or the whole file
+// if it belongs to another snapshot). returns the number of records replayed.
+int journal_open(Journal* j, const char* path, uint64_t base_hash,
+                 JournalApplyFn apply, void* ctx);
+void journal_close(Journal* j);
+
+// appends one record. fields are plain strings, escaping is handled here.
+int journal_append(Journal* j, int argc, const char** argv);
+// starts over on top of a freshly written snapshot
+int journal_reset(Journal* j, uint64_t base_hash);
+
+bool journal_is_open(const Journal* j);
+bool journal_needs_compaction(const Journal* j);
+
+// a loaded snapshot and the journal on top of it. an append that leaves the
+// journal large has save rewrite the snapshot a little later, once a burst
+// of edits settled, which starts the journal over.
+typedef int (*JournalSaveFn)(const char* snapshot);
+
+typedef struct {
+    Journal journal;
+    char snapshot[JOURNAL_PATH_LENGTH]; // empty while nothing is loaded
+    int compact_timer;                  // -1 unless a save is pending
+    JournalSaveFn save;
+} SnapshotJournal;
+
+#define SNAPSHOT_JOURNAL_INIT(save_fn) {.journal = {.fd = -1}, .compact_timer = -1, .save = (save_fn)}
+
+// replays <snapshot>.journal on top of the snapshot just loaded and keeps it
+// open for appending
+void snapshot_journal_open(SnapshotJournal* sj, const char* snapshot, uint64_t snapshot_hash,
+                           JournalApplyFn apply, void* ctx);
+void snapshot_journal_append(SnapshotJournal* sj, int argc, const char** argv);
+// flushes on exit: saves if the journal grew large (or there is none),
+// closes it. does nothing when nothing was loaded
+int snapshot_journal_close(SnapshotJournal* sj);
+bool snapshot_journal_is_loaded(const SnapshotJournal* sj);
+// whether a save of filename replaces the snapshot under the open journal
+bool snapshot_journal_owns(const SnapshotJournal* sj, const char* filename);
+
+#endif
@@ -0,0 +1,96 @@
+#include "list_view.h"
+#include <string.h>
+
+void list_view_init(ListView* view, Arena* arena) {
+    memset(view, 0, sizeof(*view));
+    view->arena = arena;
+    view->height = 1;
+}
+
+void list_view_invalidate(ListView* view) {
+    view->valid = false;
+}
+
+void list_view_update(ListView* view, int lo, int hi) {
+    if (!view->valid || hi >= view->head_count) return;
+    for (int h = lo; h < hi; h++) {
+        view->starts[h + 1] = view->starts[h] + view->head_rows(h);
+    }
+}
+
+void list_view_release(ListView* view) {
+    arena_release(view->arena, view->starts);
+    view->starts = NULL;
+    view->capacity = 0;
+    view->head_count = 0;
+    view->valid = false;
+}
+
+bool list_view_layout(ListView* view, int head_count, ListRowsFn head_rows) {
+    if (view->valid && view->head_count == head_count) return true;
+    int* starts = arena_grow(view->arena, view->starts, &view->capacity, head_count + 1, sizeof(int));
+    if (!starts) return false;
+    view->starts = starts;
+    view->head_rows = head_rows;
+
+    int row = 0;
+    for (int h = 0; h < head_count; h++) {
+        starts[h] = row;
+        row += head_rows(h);
+    }
+    starts[head_count] = row;
+    view->head_count = head_count;
+    view->valid = true;
+    return true;
+}
+
+int list_view_total(const ListView* view) {
+    return view->starts ? view->starts[view->head_count] : 0;
+}
+
+int list_view_start(const ListView* view, int head) {
+    if (!view->starts || head < 0) return 0;
+    if (head > view->head_count) head = view->head_count;
+    return view->starts[head];
+}
+
+int list_view_head_at(const ListView* view, int row) {
+    if (!view->starts || row < 0 || row >= list_view_total(view)) return -1;
+    // last head starting at or before row; empty blocks are skipped over
+    int lo = 0, hi = view->head_count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (view->starts[mid] <= row) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+// keeps the last page full when the list shrinks or the window grows
+static void clamp_scroll(ListView* view) {
+    int max_scroll = list_view_total(view) - view->height;
+    if (view->scroll > max_scroll) view->scroll = max_scroll;
+    if (view->scroll < 0) view->scroll = 0;
+}
+
+bool list_view_resize(ListView* view, int height) {
+    int old = view->scroll;
+    view->height = height > 0 ? height : 1;
+    clamp_scroll(view);
+    return view->scroll != old;
+}
+
+bool list_view_follow(ListView* view, int row) {
+    int old = view->scroll;
+    if (row >= 0) {
+        if (row < view->scroll) view->scroll = row;
+        else if (row >= view->scroll + view->height) view->scroll = row - view->height + 1;
+    }
+    clamp_scroll(view);
+    return view->scroll != old;
+}
+
+int list_view_screen_row(const ListView* view, int row, int top) {
+    if (row < view->scroll || row >= view->scroll + view->height) return -1;
+    return top + row - view->scroll;
+}
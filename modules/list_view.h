@@ -0,0 +1,48 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <stdbool.h>
+#include "arena.h"
+
+// the scroll state of a list of heads. every head takes a block of rows
+// (its header, its items, a gap); starts[h] is where head h begins, so a
+// row maps to its head by binary search and a frame only touches the rows
+// in the viewport.
+typedef int (*ListRowsFn)(int head); // rows taken by one head
+
+typedef struct {
+    Arena* arena;
+    ListRowsFn head_rows; // from the last layout
+    int* starts;     // first row of each head, then the total
+    int capacity;
+    int head_count;
+    bool valid;      // false once the heads change shape
+    int scroll;      // row shown at the top of the viewport
+    int height;      // viewport rows at the last render
+} ListView;
+
+void list_view_init(ListView* view, Arena* arena);
+// heads were added, removed, moved or gained/lost items
+void list_view_invalidate(ListView* view);
+// heads lo..hi were reordered or passed items among themselves, so they
+// still take the same rows between them: only their starts are redone
+void list_view_update(ListView* view, int lo, int hi);
+// frees the row layout while the list isn't shown; the next layout rebuilds it
+void list_view_release(ListView* view);
+// rebuilds starts if needed, false when out of memory
+bool list_view_layout(ListView* view, int head_count, ListRowsFn head_rows);
+
+int list_view_total(const ListView* view);
+int list_view_start(const ListView* view, int head);
+// head owning a row, -1 past the end
+int list_view_head_at(const ListView* view, int row);
+
+// both return true when the scroll offset changed
+bool list_view_resize(ListView* view, int height);
+bool list_view_follow(ListView* view, int row);
+
+// window row of a list row when the list starts at window row top, -1 when
+// it is scrolled out of view
+int list_view_screen_row(const ListView* view, int row, int top);
+
+#endif
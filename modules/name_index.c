@@ -0,0 +1,92 @@
+#include "name_index.h"
+#include <string.h>
+
+#define NAME_INDEX_MIN 16
+
+void name_index_init(NameIndex* index, Arena* arena) {
+    memset(index, 0, sizeof(*index));
+    index->arena = arena;
+}
+
+uint32_t name_index_hash(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void place(NameIndexEntry* slots, int capacity, NameIndexEntry entry) {
+    int mask = capacity - 1;
+    int i = (int)(entry.hash & (uint32_t)mask);
+    while (slots[i].value >= 0) i = (i + 1) & mask;
+    slots[i] = entry;
+}
+
+// keeps the load factor under 1/2, probes stay short
+static bool ensure_room(NameIndex* index) {
+    if ((index->count + 1) * 2 <= index->capacity) return true;
+
+    int capacity = index->capacity ? index->capacity * 2 : NAME_INDEX_MIN;
+    NameIndexEntry* slots = arena_alloc(index->arena, (size_t)capacity * sizeof(NameIndexEntry));
+    if (!slots) return false;
+    for (int i = 0; i < capacity; i++) slots[i].value = -1;
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->slots[i].value >= 0) place(slots, capacity, index->slots[i]);
+    }
+    arena_release(index->arena, index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    return true;
+}
+
+bool name_index_add(NameIndex* index, uint32_t hash, int value) {
+    if (!ensure_room(index)) return false;
+    NameIndexEntry entry = {hash, value};
+    place(index->slots, index->capacity, entry);
+    index->count++;
+    return true;
+}
+
+static int find_slot(const NameIndex* index, uint32_t hash, int value) {
+    if (index->capacity == 0) return -1;
+    int mask = index->capacity - 1;
+    for (int i = (int)(hash & (uint32_t)mask); index->slots[i].value >= 0; i = (i + 1) & mask) {
+        if (index->slots[i].hash == hash && index->slots[i].value == value) return i;
+    }
+    return -1;
+}
+
+void name_index_remove(NameIndex* index, uint32_t hash, int value) {
+    int i = find_slot(index, hash, value);
+    if (i < 0) return;
+
+    // backward shift: pull later entries of the probe run into the hole so
+    // lookups never need tombstones
+    int mask = index->capacity - 1;
+    int hole = i;
+    for (int j = (hole + 1) & mask; index->slots[j].value >= 0; j = (j + 1) & mask) {
+        int home = (int)(index->slots[j].hash & (uint32_t)mask);
+        // the entry can fill the hole unless its home lies in (hole, j]
+        bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays) {
+            index->slots[hole] = index->slots[j];
+            hole = j;
+        }
+    }
+    index->slots[hole].value = -1;
+    index->count--;
+}
+
+int name_index_next(const NameIndex* index, uint32_t hash, int* cursor) {
+    if (index->capacity == 0) return -1;
+    int mask = index->capacity - 1;
+    // cursor counts probe steps taken from the home slot
+    for (int i = (int)((hash + (uint32_t)*cursor) & (uint32_t)mask); index->slots[i].value >= 0;
+         i = (i + 1) & mask) {
+        (*cursor)++;
+        if (index->slots[i].hash == hash) return index->slots[i].value;
+    }
+    return -1;
+}
@@ -0,0 +1,34 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+// hash of a name -> the positions holding that name (head indices). only
+// hashes are stored: the owner compares the actual names, so the index never
+// goes stale when the string arena is compacted. equal names simply get one
+// entry each.
+typedef struct {
+    uint32_t hash;
+    int value; // -1 marks an empty slot
+} NameIndexEntry;
+
+typedef struct {
+    Arena* arena;
+    NameIndexEntry* slots;
+    int capacity;
+    int count;
+} NameIndex;
+
+void name_index_init(NameIndex* index, Arena* arena);
+uint32_t name_index_hash(const char* name, size_t len);
+
+bool name_index_add(NameIndex* index, uint32_t hash, int value);
+void name_index_remove(NameIndex* index, uint32_t hash, int value);
+
+// walks the values stored under hash: start with *cursor = 0, -1 when done
+int name_index_next(const NameIndex* index, uint32_t hash, int* cursor);
+
+#endif
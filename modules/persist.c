@@ -0,0 +1,125 @@
+#include "persist.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static PersistSyncPolicy sync_policy = PERSIST_SYNC_ON_EXIT;
+static bool shutting_down = false;
+static PersistStats stats[PERSIST_STAT_COUNT];
+static HdrHist histograms[PERSIST_STAT_COUNT];
+
+void persist_set_policy(PersistSyncPolicy policy) {
+    sync_policy = policy;
+}
+
+PersistSyncPolicy persist_policy(void) {
+    return sync_policy;
+}
+
+PersistSyncPolicy persist_parse_policy(const char* name) {
+    if (name && strcmp(name, "none") == 0) return PERSIST_SYNC_NONE;
+    if (name && strcmp(name, "every-save") == 0) return PERSIST_SYNC_EVERY_SAVE;
+    return PERSIST_SYNC_ON_EXIT;
+}
+
+const char* persist_policy_name(PersistSyncPolicy policy) {
+    switch (policy) {
+        case PERSIST_SYNC_NONE: return "none";
+        case PERSIST_SYNC_EVERY_SAVE: return "every-save";
+        default: return "on-exit";
+    }
+}
+
+void persist_set_exiting(bool exiting) {
+    shutting_down = exiting;
+}
+
+bool persist_should_sync(void) {
+    return sync_policy == PERSIST_SYNC_EVERY_SAVE ||
+           (sync_policy == PERSIST_SYNC_ON_EXIT && shutting_down);
+}
+
+uint64_t persist_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void persist_record(PersistStatKind kind, uint64_t started) {
+    uint64_t elapsed = persist_clock_ns() - started;
+    PersistStats* s = &stats[kind];
+    s->count++;
+    s->total_ns += elapsed;
+    s->last_ns = elapsed;
+    if (elapsed > s->max_ns) s->max_ns = elapsed;
+    hdr_record(&histograms[kind], elapsed);
+}
+
+const PersistStats* persist_stats(PersistStatKind kind) {
+    return &stats[kind];
+}
+
+const HdrHist* persist_histogram(PersistStatKind kind) {
+    return &histograms[kind];
+}
+
+// makes the rename itself durable
+static void sync_parent_dir(const char* path) {
+    char dir[PERSIST_PATH_LENGTH];
+    const char* slash = strrchr(path, '/');
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+    } else {
+        strcpy(dir, ".");
+    }
+    int fd = open(dir[0] ? dir : "/", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+FILE* persist_begin(PersistFile* pf, const char* path) {
+    pf->started = persist_clock_ns();
+    strncpy(pf->path, path, PERSIST_PATH_LENGTH - 1);
+    pf->path[PERSIST_PATH_LENGTH - 1] = '\0';
+    snprintf(pf->tmp_path, sizeof(pf->tmp_path), "%s.tmp", pf->path);
+    pf->file = fopen(pf->tmp_path, "w");
+    return pf->file;
+}
+
+// durable saves follow the sync policy and count in the snapshot stats
+static int finish(PersistFile* pf, bool durable) {
+    if (!pf->file) return 1;
+    bool sync = durable && persist_should_sync();
+
+    int failed = fflush(pf->file) != 0 || ferror(pf->file);
+    if (!failed && sync && fsync(fileno(pf->file)) != 0) failed = 1;
+    if (fclose(pf->file) != 0) failed = 1;
+    pf->file = NULL;
+
+    if (failed || rename(pf->tmp_path, pf->path) != 0) {
+        unlink(pf->tmp_path);
+        return 1;
+    }
+    if (sync) sync_parent_dir(pf->path);
+
+    if (durable) persist_record(PERSIST_STAT_SNAPSHOT, pf->started);
+    return 0;
+}
+
+int persist_commit(PersistFile* pf) {
+    return finish(pf, true);
+}
+
+int persist_commit_scratch(PersistFile* pf) {
+    return finish(pf, false);
+}
+
+void persist_abort(PersistFile* pf) {
+    if (pf->file) fclose(pf->file);
+    pf->file = NULL;
+    unlink(pf->tmp_path);
+}
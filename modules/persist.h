@@ -0,0 +1,63 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "hdr_hist.h"
+
+#define PERSIST_PATH_LENGTH 256
+
+// how hard saves push data to the disk (fsync_policy in settings.conf)
+typedef enum {
+    PERSIST_SYNC_NONE,       // leave it to the kernel
+    PERSIST_SYNC_ON_EXIT,    // fsync the final saves while shutting down
+    PERSIST_SYNC_EVERY_SAVE  // fsync every snapshot and journal record
+} PersistSyncPolicy;
+
+typedef enum {
+    PERSIST_STAT_SNAPSHOT, // full CSV rewrites
+    PERSIST_STAT_JOURNAL,  // single journal records
+    PERSIST_STAT_COUNT
+} PersistStatKind;
+
+typedef struct {
+    unsigned long count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t last_ns;
+} PersistStats;
+
+// a save in progress: everything is written to <path>.tmp and only renamed
+// over the real file once it is complete, so a crash or a full disk leaves
+// either the old or the new file, never half of one
+typedef struct {
+    FILE* file;
+    char path[PERSIST_PATH_LENGTH];
+    char tmp_path[PERSIST_PATH_LENGTH + 4];
+    uint64_t started;
+} PersistFile;
+
+void persist_set_policy(PersistSyncPolicy policy);
+PersistSyncPolicy persist_policy(void);
+PersistSyncPolicy persist_parse_policy(const char* name); // "none", "on-exit", "every-save"
+const char* persist_policy_name(PersistSyncPolicy policy);
+// from here on the on-exit policy syncs too
+void persist_set_exiting(bool exiting);
+// true when the current policy wants data on disk right now
+bool persist_should_sync(void);
+
+FILE* persist_begin(PersistFile* pf, const char* path);
+int persist_commit(PersistFile* pf); // 0 on success, the old file survives otherwise
+// for files that can be rebuilt at any time (the binary caches): renamed
+// into place all the same, but never synced and left out of the stats
+int persist_commit_scratch(PersistFile* pf);
+void persist_abort(PersistFile* pf);
+
+uint64_t persist_clock_ns(void);
+void persist_record(PersistStatKind kind, uint64_t started);
+const PersistStats* persist_stats(PersistStatKind kind);
+// the same durations as a distribution, in ns
+const HdrHist* persist_histogram(PersistStatKind kind);
+
+#endif
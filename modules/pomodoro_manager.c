@@ -1,12 +1,18 @@
 #include "pomodoro_manager.h"
 #include "imodule.h"
-#include <ctype.h>
+#include "../src/event_loop.h"
+#include "../src/notify.h"
 #include <ncurses.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#define SESSION_LOG_PATH "data/pomodoro.log"
 
 static PomodoroData pomodoro_data;
+static SessionLog session_log = {.fd = -1};
+static bool pomodoro_active; // pomodoro_init ran
 
 // static assets
 static const char *smoke_frames[4][2] = {
@@ -17,8 +23,51 @@ static const char *cup[] = {" ........", " |      |]", " \\      /", "  `----'"}
 // forward declaration
 static void start_new_session(PomodoroSessionState state);
 
+static uint64_t remaining_ns(const PomodoroData *data, uint64_t now) {
+  if (!data->is_running)
+    return data->remaining_ns;
+  return data->deadline > now ? data->deadline - now : 0;
+}
+
+// whole seconds left, rounded up so 25:00 shows for the first second
+static long remaining_seconds(const PomodoroData *data, uint64_t now) {
+  return (long)((remaining_ns(data, now) + NSEC_PER_SEC - 1) / NSEC_PER_SEC);
+}
+
+static void set_running(PomodoroData *data, int running) {
+  uint64_t now = event_loop_now();
+  if (running && !data->is_running) {
+    data->deadline = now + data->remaining_ns;
+    if (data->started_at == 0)
+      data->started_at = (int64_t)time(NULL);
+  } else if (!running && data->is_running) {
+    data->remaining_ns = remaining_ns(data, now);
+  }
+  data->is_running = running;
+}
+
+// appends the current session to the log if it ever ran. called before a
+// session is replaced, so resets and mode switches count the time spent too.
+static void end_session(PomodoroData *data) {
+  if (data->started_at == 0)
+    return;
+  long left = remaining_seconds(data, event_loop_now());
+  SessionRecord record;
+  memset(&record, 0, sizeof(record));
+  record.start = data->started_at;
+  record.duration = (uint32_t)(data->session_seconds - left);
+  record.state = (uint8_t)data->current_state;
+  record.mode = (uint8_t)data->cycle_mode;
+  record.completed = left == 0;
+  if (record.duration > 0)
+    session_log_append(&session_log, &record);
+  data->started_at = 0;
+}
+
 // --- Initialization ---
 void pomodoro_init() {
+  session_log_close(&session_log);
+  session_log_open(&session_log, SESSION_LOG_PATH); // without it nothing is recorded
   pomodoro_data.work_duration = 25 * 60;
   pomodoro_data.rest_duration = 5 * 60;
   pomodoro_data.progressive_step = 15 * 60;
@@ -26,9 +75,21 @@ void pomodoro_init() {
   pomodoro_data.cycle_mode = POMO_MODE_STANDARD;
   pomodoro_data.editing_state = POMO_STATE_WORK; // default
   pomodoro_data.frame = 0; // initialize frame
+  pomodoro_data.started_at = 0;
   start_new_session(POMO_STATE_WORK);
+  pomodoro_active = true;
 }
 
+void pomodoro_cleanup(void) {
+  end_session(&pomodoro_data);
+  session_log_close(&session_log);
+  pomodoro_active = false;
+}
+
+bool pomodoro_is_active(void) { return pomodoro_active; }
+
+const SessionLog *pomodoro_session_log(void) { return &session_log; }
+
 // --- UI Rendering ---
 static void draw_edit_window(WINDOW *parent_win) {
   int parent_h, parent_w;
@@ -74,8 +135,9 @@ void pomodoro_module_render(struct IModule *self, WINDOW *win) {
   }
   y++;
 
-  long minutes = data->total_seconds / 60;
-  long seconds = data->total_seconds % 60;
+  long left = remaining_seconds(data, event_loop_now());
+  long minutes = left / 60;
+  long seconds = left % 60;
   mvwprintw(win, y, 7, "%02ld:%02ld", minutes, seconds);
 
   y += 2;
@@ -98,17 +160,18 @@ void pomodoro_module_render(struct IModule *self, WINDOW *win) {
 }
 
 // --- Input Handling ---
-void pomodoro_module_handle_input(struct IModule *self, int ch, struct MinimalTui *tui) {
-  (void)self;
+void pomodoro_module_handle_input(struct IModule *self, InputAction action, int key, struct MinimalTui *tui) {
   (void)tui;
   PomodoroData *data = &pomodoro_data;
+  imodule_invalidate(self); // the whole screen is a handful of rows
 
   if (data->ui_mode == POMO_UI_EDITING) {
-    if (isdigit(ch) && data->edit_cursor_pos < 4) {
-      data->edit_buffer[data->edit_cursor_pos++] = ch;
-    } else if ((ch == KEY_BACKSPACE || ch == 127) && data->edit_cursor_pos > 0) {
+    // mmss is typed, so digits and backspace come through as plain keys
+    if (action == ACTION_NONE && key >= '0' && key <= '9' && data->edit_cursor_pos < 4) {
+      data->edit_buffer[data->edit_cursor_pos++] = (char)key;
+    } else if (action == ACTION_NONE && (key == KEY_BACKSPACE || key == 127) && data->edit_cursor_pos > 0) {
       data->edit_buffer[--data->edit_cursor_pos] = '\0';
-    } else if (ch == '\n' || ch == KEY_ENTER) {
+    } else if (action == ACTION_CONFIRM) {
       if (strlen(data->edit_buffer) == 4) {
         long min = (data->edit_buffer[0] - '0') * 10 + (data->edit_buffer[1] - '0');
         long sec = (data->edit_buffer[2] - '0') * 10 + (data->edit_buffer[3] - '0');
@@ -128,57 +191,101 @@ void pomodoro_module_handle_input(struct IModule *self, int ch, struct MinimalTu
         }
       }
       data->ui_mode = POMO_UI_NORMAL;
-    } else if (ch == 27 || ch == 'b' || ch == 'i' || ch == 'o') { // esc, b, or i/o to cancel
+    } else if (action == ACTION_CANCEL || action == ACTION_EDIT_WORK || action == ACTION_EDIT_REST) { // esc, or i/o to cancel
       data->ui_mode = POMO_UI_NORMAL;
     }
   } else { // normal mode
-    switch (ch) {
-    case 'i':
-    case 'o':
+    switch (action) {
+    case ACTION_EDIT_WORK:
+    case ACTION_EDIT_REST:
       if (data->cycle_mode == POMO_MODE_STANDARD) {
-        data->is_running = 0;
+        set_running(data, 0);
         data->ui_mode = POMO_UI_EDITING;
-        data->editing_state = (ch == 'i') ? POMO_STATE_WORK : POMO_STATE_REST;
+        data->editing_state = (action == ACTION_EDIT_WORK) ? POMO_STATE_WORK : POMO_STATE_REST;
         data->edit_cursor_pos = 0;
         memset(data->edit_buffer, 0, sizeof(data->edit_buffer));
       }
       break;
-    case ' ':
-      data->is_running = !data->is_running;
+    case ACTION_TOGGLE:
+      set_running(data, !data->is_running);
       break;
-    case 'r':
+    case ACTION_RESET:
       start_new_session(data->current_state);
       break;
-    case 'm':
+    case ACTION_CYCLE_MODE:
+      end_session(data); // logged under the mode it ran in
       data->cycle_mode = (data->cycle_mode == POMO_MODE_STANDARD) ? POMO_MODE_PROGRESSIVE : POMO_MODE_STANDARD;
       data->current_work_duration = 0; // reset progress
       start_new_session(POMO_STATE_WORK);
       break;
+    default:
+      break;
     }
   }
 }
 
 // --- Time & State Logic ---
-void pomodoro_module_tick(struct IModule *self) {
-  (void)self;
+// called whenever the clock may have moved on. everything is derived from
+// the deadline, so a late or missed wakeup (load, SIGSTOP, suspend) just
+// catches up instead of drifting.
+uint64_t pomodoro_module_tick(struct IModule *self, uint64_t now) {
   PomodoroData *data = &pomodoro_data;
-  if (data->is_running && data->total_seconds > 0) {
-    data->total_seconds--;
-  } else if (data->is_running && data->total_seconds == 0) {
-    beep(); napms(300); beep(); napms(300); beep(); // play a sound 3 times with a longer delay
+  if (!data->is_running)
+    return 0;
+
+  long left = remaining_seconds(data, now);
+  if (left != data->total_seconds)
+    imodule_invalidate(self);
+  data->total_seconds = left;
+  data->frame = (int)((data->session_seconds - left) % 4);
+
+  if (left == 0) {
+    // bells, flash and hook play out on timers, the ui keeps running
+    notify_alert(data->current_state == POMO_STATE_WORK
+                     ? "work session done, time to rest"
+                     : "break is over, back to work");
     if (data->current_state == POMO_STATE_WORK) {
       start_new_session(POMO_STATE_REST);
     } else {
       start_new_session(POMO_STATE_WORK);
     }
   }
-  if (data->is_running) {
-    data->frame = (data->frame + 1) % 4;
-  }
+  return pomodoro_next_wakeup();
+}
+
+size_t pomodoro_module_memory(const struct IModule *self) {
+  (void)self;
+  return session_log.arena.reserved;
+}
+
+int pomodoro_is_running(void) { return pomodoro_data.is_running; }
+
+uint64_t pomodoro_next_wakeup(void) {
+  const PomodoroData *data = &pomodoro_data;
+  if (!data->is_running)
+    return 0;
+  uint64_t now = event_loop_now();
+  if (data->deadline <= now)
+    return now;
+  // the display flips at deadline - k seconds; pick the nearest one ahead
+  uint64_t k = (data->deadline - now - 1) / NSEC_PER_SEC;
+  return data->deadline - k * NSEC_PER_SEC;
+}
+
+bool pomodoro_status_text(char *buf, size_t size) {
+  const PomodoroData *data = &pomodoro_data;
+  long left = remaining_seconds(data, event_loop_now());
+  if (!data->is_running && left == data->session_seconds)
+    return false;
+  snprintf(buf, size, "%s %02ld:%02ld%s",
+           data->current_state == POMO_STATE_WORK ? "Work" : "Rest",
+           left / 60, left % 60, data->is_running ? "" : " (paused)");
+  return true;
 }
 
 static void start_new_session(PomodoroSessionState state) {
   PomodoroData *data = &pomodoro_data;
+  end_session(data);
   data->current_state = state;
   data->is_running = 0;
   data->ui_mode = POMO_UI_NORMAL;
@@ -196,8 +303,11 @@ static void start_new_session(PomodoroSessionState state) {
     } else {
         data->current_work_duration = data->work_duration;
     }
-    data->total_seconds = data->current_work_duration;
+    data->session_seconds = data->current_work_duration;
   } else { // rest state
-    data->total_seconds = data->rest_duration;
+    data->session_seconds = data->rest_duration;
   }
+  data->total_seconds = data->session_seconds;
+  data->remaining_ns = (uint64_t)data->session_seconds * NSEC_PER_SEC;
+  data->frame = 0;
 }
\ No newline at end of file
@@ -2,8 +2,12 @@
 #define POMODORO_MANAGER_H
 
 #include <ncurses.h>
+#include "imodule.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "session_log.h"
 
-struct IModule;
 struct MinimalTui;
 
 typedef enum {
@@ -26,7 +30,14 @@ typedef struct {
     long rest_duration;  // in seconds
     long progressive_step; // in seconds
     long current_work_duration; // in seconds
-    long total_seconds;
+    long session_seconds; // length of the current session
+    long total_seconds;   // remaining seconds as last displayed
+
+    // the countdown is an absolute deadline on the event loop clock while
+    // running, and a frozen remainder while paused
+    uint64_t deadline;     // ns, valid while is_running
+    uint64_t remaining_ns; // valid while paused
+    int64_t started_at;    // wall clock seconds of the first start, 0 before it
 
     PomodoroSessionState current_state;
     PomodoroCycleMode cycle_mode;
@@ -42,8 +53,21 @@ typedef struct {
 } PomodoroData;
 
 void pomodoro_init(void);
+// logs a session in progress and closes the session log
+void pomodoro_cleanup(void);
+// between pomodoro_init and pomodoro_cleanup
+bool pomodoro_is_active(void);
 void pomodoro_module_render(struct IModule* self, WINDOW* win);
-void pomodoro_module_handle_input(struct IModule* self, int ch, struct MinimalTui* tui);
-void pomodoro_module_tick(struct IModule* self);
+void pomodoro_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui);
+uint64_t pomodoro_module_tick(struct IModule* self, uint64_t now);
+size_t pomodoro_module_memory(const struct IModule* self);
+int pomodoro_is_running(void);
+// next instant the displayed time changes, 0 while paused
+uint64_t pomodoro_next_wakeup(void);
+// short "Work 12:34" summary for the status bar; false when there is
+// nothing worth showing (a fresh session that was never started)
+bool pomodoro_status_text(char* buf, size_t size);
+// every finished session so far, for the analytics
+const SessionLog* pomodoro_session_log(void);
 
 #endif 
\ No newline at end of file
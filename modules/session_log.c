@@ -0,0 +1,181 @@
+#include "session_log.h"
+#include "history.h"
+#include "persist.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SESSION_MAGIC 0x53434e5au // "ZNCS"
+#define SESSION_VERSION 1
+#define SESSION_LAST_DAY 84000 // early 2199
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+} SessionHeader;
+
+static int write_all(int fd, const void* buf, size_t len) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void add_totals(SessionTotals* t, const SessionTotals* add) {
+    t->work_seconds += add->work_seconds;
+    t->rest_seconds += add->rest_seconds;
+    t->work_sessions += add->work_sessions;
+}
+
+// makes prefix cover days [from, to]; new days in front start at zero,
+// new days at the back carry the running total
+static bool cover(SessionLog* log, int from, int to) {
+    if (log->day_count == 0) {
+        log->first_day = from;
+    } else {
+        int last = log->first_day + log->day_count - 1;
+        if (from > log->first_day) from = log->first_day;
+        if (to < last) to = last;
+    }
+    int days = to - from + 1;
+    SessionTotals* prefix = arena_grow(&log->arena, log->prefix, &log->prefix_capacity,
+                                       days + 1, sizeof(SessionTotals));
+    if (!prefix) return false;
+    log->prefix = prefix;
+
+    int front = log->first_day - from;
+    if (front > 0) {
+        memmove(&prefix[front], prefix, (size_t)(log->day_count + 1) * sizeof(SessionTotals));
+        memset(prefix, 0, (size_t)front * sizeof(SessionTotals));
+        log->day_count += front;
+        log->first_day = from;
+    } else if (log->day_count == 0) {
+        memset(prefix, 0, sizeof(SessionTotals));
+    }
+    for (int i = log->day_count + 1; i <= days; i++) prefix[i] = prefix[log->day_count];
+    log->day_count = days;
+    return true;
+}
+
+// sessions arrive in time order, so only the last entry usually changes
+static bool roll_up(SessionLog* log, const SessionRecord* r) {
+    int day = history_day_at(r->start);
+    // a garbage timestamp would otherwise size the table by centuries
+    if (day < 0 || day > SESSION_LAST_DAY) return true;
+    if (!cover(log, day, day)) return false;
+    SessionTotals add = {0, 0, 0};
+    if (r->state == 0) { // POMO_STATE_WORK
+        add.work_seconds = r->duration;
+        add.work_sessions = r->completed != 0;
+    } else {
+        add.rest_seconds = r->duration;
+    }
+    for (int i = day - log->first_day + 1; i <= log->day_count; i++) add_totals(&log->prefix[i], &add);
+    log->record_count++;
+    return true;
+}
+
+static int write_header(SessionLog* log) {
+    SessionHeader h = {SESSION_MAGIC, SESSION_VERSION, sizeof(SessionRecord), 0};
+    return write_all(log->fd, &h, sizeof(h));
+}
+
+// moves a log this build can't read to path.bad (path.bad.1, ... if that is
+// taken) so a newer build or a person can still recover it
+static int set_aside(const char* path) {
+    char aside[4096];
+    for (int i = 0; i < 100; i++) {
+        int n = i == 0 ? snprintf(aside, sizeof(aside), "%s.bad", path)
+                       : snprintf(aside, sizeof(aside), "%s.bad.%d", path, i);
+        if (n < 0 || (size_t)n >= sizeof(aside)) return 1;
+        if (access(aside, F_OK) != 0) return rename(path, aside) != 0;
+    }
+    return 1;
+}
+
+int session_log_open(SessionLog* log, const char* path) {
+    memset(log, 0, sizeof(*log));
+    log->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log->fd < 0) return -1;
+
+    off_t size = lseek(log->fd, 0, SEEK_END);
+    SessionHeader h;
+    if (size == 0) {
+        if (write_header(log) != 0) {
+            session_log_close(log);
+            return -1;
+        }
+        return 0;
+    }
+    if (size < (off_t)sizeof(h) || pread(log->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        h.magic != SESSION_MAGIC || h.version != SESSION_VERSION || h.record_size != sizeof(SessionRecord)) {
+        // not a log this build can read: never truncate it, start a new one
+        // beside it, or give up if it can't be moved
+        session_log_close(log);
+        if (set_aside(path) != 0) return -1;
+        return session_log_open(log, path);
+    }
+
+    long count = (long)((size - (off_t)sizeof(h)) / (off_t)sizeof(SessionRecord));
+    SessionRecord* records = malloc((size_t)(count + 1) * sizeof(SessionRecord));
+    size_t bytes = (size_t)count * sizeof(SessionRecord);
+    if (!records || pread(log->fd, records, bytes, sizeof(h)) != (ssize_t)bytes) {
+        free(records);
+        session_log_close(log);
+        return -1;
+    }
+    for (long i = 0; i < count; i++) roll_up(log, &records[i]);
+    free(records);
+
+    // a crash mid-append leaves part of a record behind
+    off_t valid = (off_t)sizeof(h) + (off_t)bytes;
+    if (valid != size && ftruncate(log->fd, valid) != 0) {
+        session_log_close(log);
+        return -1;
+    }
+    return (int)count;
+}
+
+void session_log_close(SessionLog* log) {
+    if (log->fd >= 0) {
+        if (persist_should_sync()) fdatasync(log->fd);
+        close(log->fd);
+    }
+    arena_reset(&log->arena);
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+}
+
+int session_log_append(SessionLog* log, const SessionRecord* record) {
+    if (log->fd < 0) return 1;
+    // one write per record: a crash can only tear the record being written
+    if (write_all(log->fd, record, sizeof(*record)) != 0) return 1;
+    if (persist_policy() == PERSIST_SYNC_EVERY_SAVE && fdatasync(log->fd) != 0) return 1;
+    return roll_up(log, record) ? 0 : 1;
+}
+
+SessionTotals session_log_range(const SessionLog* log, int from, int to) {
+    SessionTotals t = {0, 0, 0};
+    if (log->day_count == 0) return t;
+    int lo = from - log->first_day;
+    int hi = to - log->first_day + 1;
+    if (lo < 0) lo = 0;
+    if (hi > log->day_count) hi = log->day_count;
+    if (lo >= hi) return t;
+    t.work_seconds = log->prefix[hi].work_seconds - log->prefix[lo].work_seconds;
+    t.rest_seconds = log->prefix[hi].rest_seconds - log->prefix[lo].rest_seconds;
+    t.work_sessions = log->prefix[hi].work_sessions - log->prefix[lo].work_sessions;
+    return t;
+}
@@ -0,0 +1,51 @@
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arena.h"
+
+// append-only binary log of finished pomodoro sessions, one fixed size
+// record per write(2) after a short header. loading reads it once into
+// per-day prefix sums; from then on appends update the sums in place, so
+// the totals of any day range (a week, a month, the last 30 days) are two
+// lookups and the log is never scanned again.
+typedef struct {
+    int64_t start;     // wall clock, unix seconds
+    uint32_t duration; // seconds actually counted down
+    uint8_t state;     // PomodoroSessionState
+    uint8_t mode;      // PomodoroCycleMode
+    uint8_t completed; // 1 ran out, 0 cut short (reset, mode switch, exit)
+    uint8_t reserved;
+    uint32_t task;     // name hash of a linked task, 0 for none
+    uint32_t padding;
+} SessionRecord;
+
+typedef struct {
+    int64_t work_seconds;
+    int64_t rest_seconds;
+    int64_t work_sessions; // completed ones
+} SessionTotals;
+
+typedef struct {
+    int fd;
+    Arena arena;
+    int first_day;         // day (as in history.h) of prefix[0]
+    int day_count;
+    int prefix_capacity;
+    SessionTotals* prefix; // prefix[i]: every session before first_day + i
+    long record_count;
+} SessionLog;
+
+// reads the log and opens it for appending, dropping a torn last record.
+// a missing file is an empty log; one in a format this build can't read is
+// renamed to path.bad first. returns the records read, -1 on error.
+int session_log_open(SessionLog* log, const char* path);
+void session_log_close(SessionLog* log);
+
+int session_log_append(SessionLog* log, const SessionRecord* record);
+
+// totals of the sessions that started on days [from, to]
+SessionTotals session_log_range(const SessionLog* log, int from, int to);
+
+#endif
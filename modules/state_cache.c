@@ -0,0 +1,175 @@
+#include "state_cache.h"
+#include "journal.h"
+#include "persist.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC 0x43434e5au // "ZNCC"
+#define CACHE_VERSION 3
+#define CACHE_RACY_NS 1000000000LL // a CSV changed this recently may change again unseen
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t csv_size;
+    int64_t csv_mtime_ns;
+    uint64_t csv_inode;
+    uint64_t csv_hash;
+    uint32_t item_size;
+    uint32_t string_bytes;
+    uint32_t head_count;
+    uint32_t item_count;
+    uint32_t extra_bytes;
+    uint32_t csv_settled; // see CacheKey.settled; 0 means check csv_hash
+} CacheHeader;
+
+// header, heads, items, extra, strings: everything up to the extra bytes
+// is 4-aligned at any offset, and the mapping itself is page aligned
+static size_t layout_size(const CacheHeader* h) {
+    return sizeof(CacheHeader) + (size_t)h->head_count * sizeof(CacheHead) +
+           (size_t)h->item_count * h->item_size + h->extra_bytes + h->string_bytes;
+}
+
+static int64_t mtime_ns(const struct stat* st) {
+#ifdef __APPLE__
+    return (int64_t)st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#else
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
+int cache_key_for(const char* csv_path, CacheKey* key) {
+    memset(key, 0, sizeof(*key));
+    struct stat st;
+    if (stat(csv_path, &st) != 0) return 1;
+    key->size = (uint64_t)st.st_size;
+    key->mtime_ns = mtime_ns(&st);
+    key->inode = (uint64_t)st.st_ino;
+
+    // whole seconds: a filesystem (or a copy) without sub-second times
+    if (key->mtime_ns % 1000000000LL == 0) {
+        cache_key_hash(csv_path, key);
+        return 0;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    key->settled = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec - key->mtime_ns >= CACHE_RACY_NS;
+    return 0;
+}
+
+uint64_t cache_key_hash(const char* csv_path, CacheKey* key) {
+    if (key->hash == 0) key->hash = journal_file_hash(csv_path);
+    return key->hash;
+}
+
+void cache_path_for(const char* csv_path, char* out, int out_size) {
+    int len = (int)strlen(csv_path);
+    if (len > 4 && strcmp(csv_path + len - 4, ".csv") == 0) len -= 4;
+    snprintf(out, out_size, "%.*s.cache", len, csv_path);
+}
+
+// the CSV was hashed and still matches, and is old enough now that another
+// change would move its mtime: later opens can go by the stat alone
+static void mark_settled(const char* path) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    uint32_t settled = 1;
+    if (pwrite(fd, &settled, sizeof(settled), offsetof(CacheHeader, csv_settled)) != sizeof(settled)) {
+        // stays unsettled, the next open hashes again
+    }
+    close(fd);
+}
+
+int cache_open(const char* path, const char* csv_path, CacheKey* key, uint32_t item_size,
+               CacheView* view) {
+    memset(view, 0, sizeof(*view));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        return 1;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 1;
+    view->map = map;
+    view->map_size = (size_t)st.st_size;
+
+    const CacheHeader* h = map;
+    if (h->magic != CACHE_MAGIC || h->version != CACHE_VERSION || h->item_size != item_size ||
+        h->csv_size != key->size || h->csv_mtime_ns != key->mtime_ns || h->csv_inode != key->inode ||
+        h->csv_hash == 0 || layout_size(h) != view->map_size ||
+        ((key->hash != 0 || !h->csv_settled) && h->csv_hash != cache_key_hash(csv_path, key))) {
+        cache_close(view);
+        return 1;
+    }
+
+    const char* p = (const char*)map + sizeof(CacheHeader);
+    view->heads = (const CacheHead*)p;
+    view->head_count = h->head_count;
+    p += (size_t)h->head_count * sizeof(CacheHead);
+    view->items = p;
+    view->item_count = h->item_count;
+    p += (size_t)h->item_count * item_size;
+    view->extra = p;
+    view->extra_bytes = h->extra_bytes;
+    p += h->extra_bytes;
+    view->strings = p;
+    view->string_bytes = h->string_bytes;
+
+    // only the head ranges are checked here, string refs are up to the owner
+    for (uint32_t i = 0; i < view->head_count; i++) {
+        const CacheHead* head = &view->heads[i];
+        if (head->first > view->item_count || head->count > view->item_count - head->first) {
+            cache_close(view);
+            return 1;
+        }
+    }
+    if (!h->csv_settled && key->settled) mark_settled(path);
+    key->hash = h->csv_hash;
+    return 0;
+}
+
+void cache_close(CacheView* view) {
+    if (view->map) munmap(view->map, view->map_size);
+    memset(view, 0, sizeof(*view));
+}
+
+int cache_write(const char* path, const CacheKey* key,
+                const CacheHead* heads, uint32_t head_count,
+                const void* items, uint32_t item_count, uint32_t item_size,
+                const void* extra, uint32_t extra_bytes,
+                const char* strings, uint32_t string_bytes) {
+    if (key->hash == 0) return 1; // nothing to check it against later
+    CacheHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = CACHE_MAGIC;
+    h.version = CACHE_VERSION;
+    h.csv_size = key->size;
+    h.csv_mtime_ns = key->mtime_ns;
+    h.csv_inode = key->inode;
+    h.csv_hash = key->hash;
+    h.csv_settled = key->settled;
+    h.item_size = item_size;
+    h.string_bytes = string_bytes;
+    h.head_count = head_count;
+    h.item_count = item_count;
+    h.extra_bytes = extra_bytes;
+
+    PersistFile out;
+    FILE* file = persist_begin(&out, path);
+    if (!file) return 1;
+    fwrite(&h, sizeof(h), 1, file);
+    if (head_count > 0) fwrite(heads, sizeof(CacheHead), head_count, file);
+    if (item_count > 0) fwrite(items, item_size, item_count, file);
+    if (extra_bytes > 0) fwrite(extra, 1, extra_bytes, file);
+    if (string_bytes > 0) fwrite(strings, 1, string_bytes, file);
+    return persist_commit_scratch(&out);
+}
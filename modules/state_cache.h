@@ -0,0 +1,71 @@
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "str_arena.h"
+
+// which CSV a cache was built from. size, mtime and inode catch external
+// edits without reading the file; the content hash is only computed when
+// they can't be trusted, and otherwise comes from the cache itself (the
+// journal is keyed on it).
+typedef struct {
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t inode;
+    uint64_t hash; // 0 until known
+    bool settled;  // stat'ed well after the last change: a later one moves mtime
+} CacheKey;
+
+// a head and the items that belong to it: items[first .. first + count)
+typedef struct {
+    StrRef name;
+    uint32_t first;
+    uint32_t count;
+} CacheHead;
+
+// a cache file mapped read-only. the arrays point straight into the
+// mapping and are only valid until cache_close.
+typedef struct {
+    void* map;
+    size_t map_size;
+    const CacheHead* heads;
+    uint32_t head_count;
+    const void* items; // item_count records of the item size asked for
+    uint32_t item_count;
+    const void* extra; // owner defined bytes, not aligned: copy them out
+    uint32_t extra_bytes;
+    const char* strings; // a StrArena buffer, see str_arena_adopt
+    uint32_t string_bytes;
+} CacheView;
+
+// stats the CSV, and hashes it too when the mtime is too coarse to go by.
+// 1 when the CSV can't be stat'ed (key is zeroed).
+int cache_key_for(const char* csv_path, CacheKey* key);
+// the CSV's content hash, read once; 0 when it can't be read, like
+// journal_file_hash
+uint64_t cache_key_hash(const char* csv_path, CacheKey* key);
+// "data/tasks.csv" -> "data/tasks.cache"
+void cache_path_for(const char* csv_path, char* out, int out_size);
+
+// maps the cache and checks it was built from exactly this CSV with this
+// item layout, filling in key->hash from it when still unknown. size, mtime
+// and inode are enough unless the cache was built from a CSV changed just
+// before (an edit in the same timestamp tick keeps the mtime): then csv_path
+// is hashed once and, if it still matches, the cache marked settled. 0 on
+// success; anything else means parse the CSV.
+int cache_open(const char* path, const char* csv_path, CacheKey* key, uint32_t item_size,
+               CacheView* view);
+void cache_close(CacheView* view);
+
+// writes a fresh cache atomically, items in display order. key->hash must
+// be known (see cache_key_hash). extra carries
+// whatever the items point to and can't hold inline (NULL, 0 for none).
+int cache_write(const char* path, const CacheKey* key,
+                const CacheHead* heads, uint32_t head_count,
+                const void* items, uint32_t item_count, uint32_t item_size,
+                const void* extra, uint32_t extra_bytes,
+                const char* strings, uint32_t string_bytes);
+
+#endif
@@ -0,0 +1,189 @@
+#include "str_arena.h"
+#include <string.h>
+
+#define STR_TABLE_MIN 64
+#define STR_COMPACT_MIN 4096 // not worth a rebuild below this much garbage
+
+static uint32_t hash_bytes(const char* s, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void str_arena_init(StrArena* sa, Arena* arena) {
+    memset(sa, 0, sizeof(*sa));
+    sa->arena = arena;
+}
+
+// room for extra more bytes, plus the "" at offset 0 when it isn't there yet
+static bool ensure_data(StrArena* sa, int extra) {
+    int needed = sa->used + extra + (sa->used == 0 ? 1 : 0);
+    char* data = arena_grow(sa->arena, sa->data, &sa->capacity, needed, 1);
+    if (!data) return false;
+    sa->data = data;
+    if (sa->used == 0) sa->data[sa->used++] = '\0'; // offset 0 is ""
+    return true;
+}
+
+static void table_insert(StrEntry* table, int capacity, StrEntry entry) {
+    int mask = capacity - 1;
+    int i = (int)(entry.hash & (uint32_t)mask);
+    while (table[i].offset != 0) i = (i + 1) & mask;
+    table[i] = entry;
+}
+
+// keeps the load factor under 3/4
+static bool ensure_table(StrArena* sa) {
+    if ((sa->count + 1) * 4 < sa->table_capacity * 3) return true;
+
+    int capacity = sa->table_capacity ? sa->table_capacity * 2 : STR_TABLE_MIN;
+    StrEntry* table = arena_alloc(sa->arena, (size_t)capacity * sizeof(StrEntry));
+    if (!table) return false;
+    memset(table, 0, (size_t)capacity * sizeof(StrEntry));
+    for (int i = 0; i < sa->table_capacity; i++) {
+        if (sa->table[i].offset != 0) table_insert(table, capacity, sa->table[i]);
+    }
+    arena_release(sa->arena, sa->table);
+    sa->table = table;
+    sa->table_capacity = capacity;
+    return true;
+}
+
+// indexes every string of an adopted buffer
+static bool rebuild_table(StrArena* sa) {
+    sa->table_stale = false;
+    for (int offset = 1; offset < sa->used;) {
+        uint32_t len = (uint32_t)strlen(sa->data + offset);
+        if (len > 0) {
+            if (!ensure_table(sa)) return false;
+            StrEntry entry = {(uint32_t)offset, len, hash_bytes(sa->data + offset, len)};
+            table_insert(sa->table, sa->table_capacity, entry);
+            sa->count++;
+        }
+        offset += (int)len + 1;
+    }
+    return true;
+}
+
+static StrRef intern_bytes(StrArena* sa, const char* s, size_t len) {
+    StrRef empty = {0, 0};
+    if (len == 0 || len >= UINT32_MAX) return empty;
+    if (sa->table_stale && !rebuild_table(sa)) return empty;
+
+    uint32_t hash = hash_bytes(s, len);
+    if (sa->table_capacity > 0) {
+        int mask = sa->table_capacity - 1;
+        for (int i = (int)(hash & (uint32_t)mask); sa->table[i].offset != 0; i = (i + 1) & mask) {
+            StrEntry* e = &sa->table[i];
+            if (e->hash == hash && e->length == len && memcmp(sa->data + e->offset, s, len) == 0) {
+                StrRef found = {e->offset, e->length};
+                return found;
+            }
+        }
+    }
+
+    if (!ensure_table(sa) || !ensure_data(sa, (int)len + 1)) return empty;
+    StrRef ref = {(uint32_t)sa->used, (uint32_t)len};
+    memcpy(sa->data + sa->used, s, len);
+    sa->data[sa->used + len] = '\0';
+    sa->used += (int)len + 1;
+
+    StrEntry entry = {ref.offset, ref.length, hash};
+    table_insert(sa->table, sa->table_capacity, entry);
+    sa->count++;
+    return ref;
+}
+
+StrRef str_intern(StrArena* sa, const char* s) {
+    return intern_bytes(sa, s, strlen(s));
+}
+
+StrRef str_intern_n(StrArena* sa, const char* s, size_t len) {
+    return intern_bytes(sa, s, len);
+}
+
+bool str_ref_equals(const StrArena* sa, StrRef ref, const char* s, size_t len) {
+    return ref.length == len && (len == 0 || memcmp(sa->data + ref.offset, s, len) == 0);
+}
+
+const char* str_get(const StrArena* sa, StrRef ref) {
+    if (ref.length == 0 || !sa->data) return "";
+    return sa->data + ref.offset;
+}
+
+void str_release(StrArena* sa, StrRef ref) {
+    if (ref.length > 0) sa->garbage += (int)ref.length + 1;
+}
+
+bool str_ref_valid(const StrArena* sa, StrRef ref) {
+    if (ref.length == 0) return ref.offset == 0;
+    return sa->data && (uint64_t)ref.offset + ref.length < (uint64_t)sa->used &&
+           sa->data[ref.offset + ref.length] == '\0';
+}
+
+const char* str_arena_buffer(const StrArena* sa, uint32_t* bytes) {
+    *bytes = (uint32_t)sa->used;
+    return sa->data;
+}
+
+bool str_arena_adopt(StrArena* sa, const char* data, uint32_t bytes) {
+    if (bytes == 0) return true;
+    if (data[0] != '\0' || data[bytes - 1] != '\0' || bytes > INT32_MAX) return false;
+
+    int capacity = 0;
+    char* copy = arena_grow(sa->arena, NULL, &capacity, (int)bytes, 1);
+    if (!copy) return false;
+    memcpy(copy, data, bytes);
+
+    arena_release(sa->arena, sa->data);
+    arena_release(sa->arena, sa->table);
+    sa->data = copy;
+    sa->capacity = capacity;
+    sa->used = (int)bytes;
+    sa->table = NULL;
+    sa->table_capacity = 0;
+    sa->count = 0;
+    sa->garbage = 0;
+    sa->table_stale = true;
+    return true;
+}
+
+bool str_arena_wants_compaction(const StrArena* sa) {
+    return sa->garbage > STR_COMPACT_MIN && sa->garbage * 2 > sa->used;
+}
+
+bool str_arena_compact_begin(StrArena* sa) {
+    if (sa->old_data) return false;
+    sa->old_data = sa->data;
+    arena_release(sa->arena, sa->table);
+    sa->data = NULL;
+    sa->used = 0;
+    sa->capacity = 0;
+    sa->table = NULL;
+    sa->table_capacity = 0;
+    sa->count = 0;
+    sa->garbage = 0;
+    sa->table_stale = false;
+    return true;
+}
+
+void str_arena_relocate(StrArena* sa, StrRef* ref) {
+    if (ref->length == 0) return;
+    *ref = intern_bytes(sa, sa->old_data + ref->offset, ref->length);
+}
+
+void str_arena_compact_end(StrArena* sa) {
+    arena_release(sa->arena, sa->old_data);
+    sa->old_data = NULL;
+}
+
+size_t str_arena_used(const StrArena* sa) {
+    return (size_t)sa->used;
+}
+
+size_t str_arena_reserved(const StrArena* sa) {
+    return (size_t)sa->capacity + (size_t)sa->table_capacity * sizeof(StrEntry);
+}
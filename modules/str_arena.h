@@ -0,0 +1,67 @@
+#ifndef STR_ARENA_H
+#define STR_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+// a string stored in a StrArena. refs stay valid across growth and are
+// rewritten by compaction; the empty string is {0, 0}.
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} StrRef;
+
+typedef struct {
+    uint32_t offset; // 0 marks an empty bucket, offset 0 is always ""
+    uint32_t length;
+    uint32_t hash;
+} StrEntry;
+
+// interned, variable-length strings packed back to back (each NUL
+// terminated) in one buffer taken from the owner's arena. equal strings are
+// stored once. deleting text only counts it as garbage; the owner rebuilds
+// the buffer in bulk from its live refs once that passes half of it.
+typedef struct {
+    Arena* arena;
+    char* data;
+    int used;
+    int capacity;
+    StrEntry* table; // open addressing over data, for interning
+    int table_capacity;
+    int count;
+    int garbage;     // released bytes, an upper bound as refs can be shared
+    char* old_data;  // the buffer being compacted away
+    bool table_stale; // adopted buffer, intern table not built yet
+} StrArena;
+
+void str_arena_init(StrArena* sa, Arena* arena);
+
+// stores s (or finds the copy already stored). s must not point into sa.
+StrRef str_intern(StrArena* sa, const char* s);
+StrRef str_intern_n(StrArena* sa, const char* s, size_t len);
+// NUL terminated, valid until the next intern or compaction
+const char* str_get(const StrArena* sa, StrRef ref);
+// the owner dropped a ref to this text
+void str_release(StrArena* sa, StrRef ref);
+bool str_ref_equals(const StrArena* sa, StrRef ref, const char* s, size_t len);
+// true when ref names a whole string stored in sa
+bool str_ref_valid(const StrArena* sa, StrRef ref);
+
+// the raw buffer, for saving it as is; refs into it stay meaningful
+const char* str_arena_buffer(const StrArena* sa, uint32_t* bytes);
+// replaces the contents with a buffer saved from str_arena_buffer. the
+// intern table is only rebuilt once something new is stored.
+bool str_arena_adopt(StrArena* sa, const char* data, uint32_t bytes);
+
+// compaction: begin, relocate every live ref the owner holds, end
+bool str_arena_wants_compaction(const StrArena* sa);
+bool str_arena_compact_begin(StrArena* sa);
+void str_arena_relocate(StrArena* sa, StrRef* ref);
+void str_arena_compact_end(StrArena* sa);
+
+size_t str_arena_used(const StrArena* sa);     // bytes of text, garbage included
+size_t str_arena_reserved(const StrArena* sa); // buffer plus intern table
+
+#endif
@@ -2,28 +2,30 @@
 #define STRUCTS_H
 
 #include <stdbool.h> // for bool type in c structs
+#include "arena.h"
+#include "item_store.h"
+#include "history.h"
+#include "undo_log.h"
+#include "text_entry.h"
 
 #define MAX_NAME_LENGTH 48
-#define MAX_TASKS_PER_HEAD 12
-#define MAX_HEADS 8
 
+// names and descriptions are refs into the module's StrArena. streaks and
+// today's state are read off the history, see history.h.
 typedef struct {
     int id;
-    char name[MAX_NAME_LENGTH];
-    int streak;
-    bool done_today;
+    StrRef name;
+    HabitHistory history; // words live in HabitData.arena
 } Task;
 
 typedef struct {
-    int id;
-    char name[MAX_NAME_LENGTH];
-    Task tasks[MAX_TASKS_PER_HEAD];
-    int task_count;
-} HabitHead;
-
-typedef struct {
-    HabitHead heads[MAX_HEADS];
-    int head_count;
+    Arena arena;          // owns every array below
+    ItemStore store;      // the habits (Task) under their heads
+    UndoLog undo;         // inverses of the last edits, in the arena
+    TextEntry entry;      // the add/rename/jump field, while it is open
+    int entry_head;       // where its text goes
+    int entry_task;
+    int today;            // the day marks and streaks are shown for
     int selected_head;
     int selected_task;
     bool edit_mode;
@@ -32,20 +34,17 @@ typedef struct {
 
 typedef struct {
     int id;
-    char description[128];
+    StrRef description;
     bool completed;
 } TaskItem;
 
 typedef struct {
-    int id;
-    char name[MAX_NAME_LENGTH];
-    TaskItem tasks[MAX_TASKS_PER_HEAD];
-    int task_count;
-} TaskHead;
-
-typedef struct {
-    TaskHead heads[MAX_HEADS];
-    int head_count;
+    Arena arena;
+    ItemStore store;
+    UndoLog undo;
+    TextEntry entry;
+    int entry_head;
+    int entry_task;
     int selected_head;
     int selected_task; // -1 if head is selected
     bool edit_mode;
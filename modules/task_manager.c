@@ -1,45 +1,24 @@
 #include "task_manager.h"
 #include "imodule.h"
-#include "../src/minimal_tui.h"
+#include "journal.h"
+#include "csv.h"
+#include "persist.h"
+#include "state_cache.h"
+#include <limits.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 static TaskManagerData task_data;
-
-// helper function to get string input in a popup window
-static bool prompt_for_string(WINDOW* parent_win, const char* prompt, char* buffer, int buffer_size) {
-    int parent_h, parent_w;
-    getmaxyx(parent_win, parent_h, parent_w);
-    int h = 3;
-    int w = strlen(prompt) + 20; // a bit of padding
-    int y = (parent_h - h) / 2;
-    int x = (parent_w - w) / 2;
-
-    WINDOW* win = newwin(h, w, y, x);
-    box(win, 0, 0);
-    mvwprintw(win, 1, 2, "%s", prompt);
-    wrefresh(win);
-
-    echo();
-    curs_set(1);
-    wgetnstr(win, buffer, buffer_size - 1);
-    curs_set(0);
-    noecho();
-
-    delwin(win);
-    touchwin(parent_win); 
-    wnoutrefresh(parent_win);
-
-    return strlen(buffer) > 0;
-}
+static SnapshotJournal task_journal = SNAPSHOT_JOURNAL_INIT(tasks_save);
 
 static void ensure_task_selected() {
-    if (task_data.selected_task != -1 && task_data.head_count > 0 && task_data.heads[task_data.selected_head].task_count > 0) return;
-    if (task_data.head_count == 0) return;
+    if (task_data.selected_task != -1 && task_data.store.head_count > 0 && task_data.store.heads[task_data.selected_head].task_count > 0) return;
+    if (task_data.store.head_count == 0) return;
 
-    for (int i = 0; i < task_data.head_count; i++) {
-        if (task_data.heads[i].task_count > 0) {
+    for (int i = 0; i < task_data.store.head_count; i++) {
+        if (task_data.store.heads[i].task_count > 0) {
             task_data.selected_head = i;
             task_data.selected_task = 0;
             return;
@@ -48,272 +27,690 @@ static void ensure_task_selected() {
 }
 
 
-void tasks_init() {
-    task_data.head_count = 1; // head 0 is for standalone tasks
-    task_data.heads[0].task_count = 0;
-    strcpy(task_data.heads[0].name, "");
+static bool apply_add_head(const char* name);
+
+// empty, without even the standalone head
+static void reset_data(void) {
+    tasks_cleanup();
+    item_store_init(&task_data.store, &task_data.arena, sizeof(TaskItem), offsetof(TaskItem, description));
+    undo_init(&task_data.undo, &task_data.arena);
 
     task_data.selected_head = 0;
     task_data.selected_task = -1;
     task_data.edit_mode = false;
     task_data.move_mode = false;
+    text_entry_cancel(&task_data.entry);
+}
+
+void tasks_init() {
+    reset_data();
+    apply_add_head(""); // head 0 is for standalone tasks
 }
 
 void tasks_cleanup() {
-    // nothing to clean up
+    arena_reset(&task_data.arena);
+    memset(&task_data, 0, sizeof(task_data));
 }
 
-void tasks_module_render(struct IModule* self, WINDOW* win) {
-    werase(win);
-    // box(win, 0, 0);
-    mvwprintw(win, 1, 2, "Tasks %s", task_data.edit_mode ? "[EDIT MODE]" : "");
-
-    int y = 3;
-    for (int h = 0; h < task_data.head_count; h++) {
-        // Don't render a header for standalone tasks (h==0)
-        if (h > 0) {
-            if (h == task_data.selected_head && task_data.selected_task == -1) {
-                wattron(win, A_REVERSE);
-            }
-            mvwprintw(win, y++, 2, "%s:", task_data.heads[h].name);
-            if (h == task_data.selected_head && task_data.selected_task == -1) {
-                wattroff(win, A_REVERSE);
-            }
-        }
+void tasks_string_usage(size_t* used, size_t* reserved) {
+    *used = str_arena_used(&task_data.store.strings);
+    *reserved = str_arena_reserved(&task_data.store.strings);
+}
 
-        for (int t = 0; t < task_data.heads[h].task_count; t++) {
-            bool is_selected = (h == task_data.selected_head && t == task_data.selected_task);
-            TaskItem* task = &task_data.heads[h].tasks[t];
-
-            if (is_selected) wattron(win, A_REVERSE);
-            if (task->completed) wattron(win, A_DIM);
-            
-            int x_offset = (h > 0) ? 4 : 2;
-            mvwprintw(win, y, x_offset, "[%c] %s", task->completed ? 'X' : ' ', task->description);
-
-            if (task->completed) {
-                 int task_len = strlen(task->description);
-                 for (int i = 0; i < task_len; i++) {
-                    mvwaddch(win, y, x_offset + 4 + i, '-');
-                 }
-            }
+// --- Storage ---
+// the heads, their slots and every name live in task_data.store, see
+// item_store.h
 
-            if (is_selected) wattroff(win, A_REVERSE);
-            if (task->completed) wattroff(win, A_DIM);
-            y++;
-        }
-        
-        if (h < task_data.head_count - 1) {
-            y++; 
-        }
+static TaskItem* task_at(int head, int task) {
+    return item_store_at(&task_data.store, head, task);
+}
+
+// only valid until the next string is stored
+static const char* text_of(StrRef ref) {
+    return item_store_text(&task_data.store, ref);
+}
+
+// --- Mutations ---
+// every change to task_data goes through an apply_* helper so replaying the
+// journal does exactly what the ui did. the public tasks_* wrappers apply,
+// append one record and push the inverse for undo.
+
+static bool valid_task(int head, int task) {
+    return item_store_valid(&task_data.store, head, task);
+}
+
+static bool apply_add_head(const char* name) {
+    return item_store_add_head(&task_data.store, name, strlen(name)) != NULL;
+}
+
+static bool apply_add_task(int head_idx, int pos, const char* description, bool completed) {
+    TaskItem* task = item_store_insert(&task_data.store, head_idx, pos, description, strlen(description));
+    if (!task) return false;
+    task->id = task_data.store.heads[head_idx].task_count;
+    task->completed = completed;
+    return true;
+}
+
+static bool apply_delete_head(int head_idx) {
+    return item_store_delete_head(&task_data.store, head_idx, NULL, NULL);
+}
+
+static bool apply_delete_task(int head_idx, int task_idx) {
+    return item_store_delete(&task_data.store, head_idx, task_idx, NULL, NULL);
+}
+
+static bool apply_move_head(int from, int to) {
+    return item_store_move_head(&task_data.store, from, to);
+}
+
+// takes the task out of from_head and inserts it at to_task in to_head
+static bool apply_move_task(int from_head, int from_task, int to_head, int to_task) {
+    return item_store_move(&task_data.store, from_head, from_task, to_head, to_task);
+}
+
+static bool apply_set_completed(int head_idx, int task_idx, bool completed) {
+    if (!valid_task(head_idx, task_idx)) return false;
+    task_at(head_idx, task_idx)->completed = completed;
+    return true;
+}
+
+// task_idx == -1 renames the head itself
+static bool apply_rename(int head_idx, int task_idx, const char* text) {
+    return item_store_rename(&task_data.store, head_idx, task_idx, text);
+}
+
+static const char* num(char* buf, int value) {
+    snprintf(buf, 16, "%d", value);
+    return buf;
+}
+
+// tasks first..last of a head from last to first, each as its completed
+// flag ('0' or '1') and description, then the head's name if with_head;
+// all NUL terminated
+static char* save_tasks(int head, int first, int last, bool with_head) {
+    const char* name = text_of(task_data.store.heads[head].name);
+    size_t size = with_head ? strlen(name) + 1 : 1;
+    for (int t = first; t <= last; t++) size += strlen(text_of(task_at(head, t)->description)) + 2;
+    char* saved = arena_alloc(&task_data.arena, size);
+    if (!saved) return NULL;
+
+    char* p = saved;
+    for (int t = last; t >= first; t--) {
+        const TaskItem* item = task_at(head, t);
+        const char* text = text_of(item->description);
+        size_t len = strlen(text);
+        *p++ = item->completed ? '1' : '0';
+        memcpy(p, text, len + 1);
+        p += len + 1;
     }
+    if (with_head) memcpy(p, name, strlen(name) + 1);
+    else *p = '\0';
+    return saved;
+}
 
-    int max_y = getmaxy(win);
+void tasks_add_head(const char* name) {
+    if (!apply_add_head(name)) return;
+    const char* rec[] = {"AH", name};
+    snapshot_journal_append(&task_journal, 2, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_DELETE_HEAD, task_data.store.head_count - 1, 0, 0, 0, NULL, NULL);
+}
+
+void tasks_add_task(int head, int pos, const char* description) {
+    if (!apply_add_task(head, pos, description, false)) return;
+    char a[16], b[16];
+    const char* rec[] = {"AT", num(a, head), num(b, pos), description};
+    snapshot_journal_append(&task_journal, 4, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_DELETE_ITEM, head, pos, 0, 0, NULL, NULL);
+}
+
+void tasks_delete_head(int head) {
+    if (head < 0 || head >= task_data.store.head_count) return;
+    int count = task_data.store.heads[head].task_count;
+    char* saved = save_tasks(head, 0, count - 1, true);
+    if (!saved || !apply_delete_head(head)) {
+        arena_release(&task_data.arena, saved);
+        return;
+    }
+    char a[16];
+    const char* rec[] = {"DH", num(a, head)};
+    snapshot_journal_append(&task_journal, 2, rec);
+
+    undo_begin(&task_data.undo);
+    const char* p = saved;
+    for (int t = count - 1; t >= 0; t--) {
+        undo_push(&task_data.undo, UNDO_ADD_ITEM, head, t, p[0] == '1', 0, p + 1, NULL);
+        p += strlen(p) + 1;
+    }
+    undo_push_head_restore(&task_data.undo, head, task_data.store.head_count, p);
+    arena_release(&task_data.arena, saved);
+}
+
+void tasks_delete_task(int head, int task) {
+    if (!valid_task(head, task)) return;
+    char* saved = save_tasks(head, task, task, false);
+    if (!saved || !apply_delete_task(head, task)) {
+        arena_release(&task_data.arena, saved);
+        return;
+    }
+    char a[16], b[16];
+    const char* rec[] = {"DT", num(a, head), num(b, task)};
+    snapshot_journal_append(&task_journal, 3, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_ADD_ITEM, head, task, saved[0] == '1', 0, saved + 1, NULL);
+    arena_release(&task_data.arena, saved);
+}
+
+void tasks_move_head(int from, int to) {
+    if (!apply_move_head(from, to)) return;
+    char a[16], b[16];
+    const char* rec[] = {"MH", num(a, from), num(b, to)};
+    snapshot_journal_append(&task_journal, 3, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_MOVE_HEAD, to, from, 0, 0, NULL, NULL);
+}
+
+void tasks_move_task(int from_head, int from_task, int to_head, int to_task) {
+    if (!apply_move_task(from_head, from_task, to_head, to_task)) return;
+    char a[16], b[16], c[16], d[16];
+    const char* rec[] = {"MT", num(a, from_head), num(b, from_task), num(c, to_head), num(d, to_task)};
+    snapshot_journal_append(&task_journal, 5, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_MOVE_ITEM, to_head, to_task, from_head, from_task, NULL, NULL);
+}
+
+void tasks_set_completed(int head, int task, bool completed) {
+    if (!valid_task(head, task)) return;
+    bool was = task_at(head, task)->completed;
+    if (!apply_set_completed(head, task, completed)) return;
+    char a[16], b[16], c[16];
+    const char* rec[] = {"SC", num(a, head), num(b, task), num(c, completed)};
+    snapshot_journal_append(&task_journal, 4, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_SET_ITEM, head, task, was, 0, NULL, NULL);
+}
+
+void tasks_rename(int head, int task, const char* text) {
+    if (head < 0 || head >= task_data.store.head_count || (task != -1 && !valid_task(head, task))) return;
+    StrRef old = task == -1 ? task_data.store.heads[head].name : task_at(head, task)->description;
+    char* saved = undo_save_text(&task_data.undo, text_of(old));
+    if (!saved || !apply_rename(head, task, text)) {
+        arena_release(&task_data.arena, saved);
+        return;
+    }
+    char a[16], b[16];
+    const char* rec[] = {"RN", num(a, head), num(b, task), text};
+    snapshot_journal_append(&task_journal, 4, rec);
+    undo_begin(&task_data.undo);
+    undo_push(&task_data.undo, UNDO_RENAME, head, task, 0, 0, saved, NULL);
+    arena_release(&task_data.arena, saved);
+}
+
+// one journal record, through the same apply_* helpers as the edit itself
+static void replay_record(int argc, char** argv, void* ctx) {
+    (void)ctx;
+    const char* op = argv[0];
+    int a = argc > 1 ? atoi(argv[1]) : 0;
+    int b = argc > 2 ? atoi(argv[2]) : 0;
+
+    if (strcmp(op, "AH") == 0 && argc >= 2) apply_add_head(argv[1]);
+    else if (strcmp(op, "AT") == 0 && argc >= 4) apply_add_task(a, b, argv[3], false);
+    else if (strcmp(op, "DH") == 0 && argc >= 2) apply_delete_head(a);
+    else if (strcmp(op, "DT") == 0 && argc >= 3) apply_delete_task(a, b);
+    else if (strcmp(op, "MH") == 0 && argc >= 3) apply_move_head(a, b);
+    else if (strcmp(op, "MT") == 0 && argc >= 5) apply_move_task(a, b, atoi(argv[3]), atoi(argv[4]));
+    else if (strcmp(op, "SC") == 0 && argc >= 4) apply_set_completed(a, b, atoi(argv[3]) != 0);
+    else if (strcmp(op, "RN") == 0 && argc >= 4) apply_rename(a, b, argv[3]);
+}
+
+// --- Binary cache ---
+// data/tasks.cache holds task_data as parsed from data/tasks.csv, keyed by
+// the CSV's size, mtime and inode. the CSV stays the real format; the cache
+// only lets an unchanged one be loaded without parsing.
+
+static bool load_cache(const char* filename, CacheKey* key) {
+    char path[JOURNAL_PATH_LENGTH];
+    cache_path_for(filename, path, sizeof(path));
+    CacheView view;
+    if (cache_open(path, filename, key, sizeof(TaskItem), &view) != 0) return false;
+
+    reset_data();
+    bool ok = item_store_adopt(&task_data.store, &view);
+    cache_close(&view);
+
+    if (!ok || task_data.store.head_count == 0) {
+        tasks_init();
+        return false;
+    }
+    return true;
+}
+
+static void write_cache(const char* filename, CacheKey* key) {
+    item_store_write_cache(&task_data.store, filename, key, NULL, NULL, NULL, 0);
+}
+
+int tasks_close(void) {
+    return snapshot_journal_close(&task_journal);
+}
+
+bool tasks_is_loaded(void) {
+    return snapshot_journal_is_loaded(&task_journal);
+}
+
+// --- Search ---
+
+int tasks_search(const GramQuery* query, GramHit* hits, int max) {
+    return item_store_search(&task_data.store, query, hits, max);
+}
+
+const char* tasks_hit_text(int doc) {
+    return item_store_hit_text(&task_data.store, doc);
+}
+
+// selects the head in edit mode, its first task otherwise
+static void select_head(int head_idx) {
+    if (task_data.edit_mode) {
+        task_data.selected_head = head_idx;
+        task_data.selected_task = -1;
+    } else if (task_data.store.heads[head_idx].task_count > 0) {
+        task_data.selected_head = head_idx;
+        task_data.selected_task = 0;
+    }
+}
+
+void tasks_reveal(int doc) {
+    if (doc < 0) {
+        int h = item_store_hit_head(&task_data.store, doc);
+        if (h >= 0) select_head(h);
+        return;
+    }
+    item_store_locate(&task_data.store, doc, &task_data.selected_head, &task_data.selected_task);
+}
+
+// --- List view ---
+// the list starts at window row 3: standalone tasks first without a header,
+// then each head's header and tasks, with a blank row between heads
+
+#define LIST_TOP 3
+
+static int head_rows(int head) {
+    int rows = task_data.store.heads[head].task_count;
+    if (head > 0) rows++;                           // header
+    if (head < task_data.store.head_count - 1) rows++;    // gap before the next head
+    return rows;
+}
+
+static bool layout_list(void) {
+    return list_view_layout(&task_data.store.view, task_data.store.head_count, head_rows);
+}
+
+// row of a head (task == -1) or a task within the whole list
+static int list_row(int head, int task) {
+    if (head < 0 || head >= task_data.store.head_count || !layout_list()) return -1;
+    int row = list_view_start(&task_data.store.view, head);
+    if (task == -1) return head > 0 ? row : -1;
+    return row + (head > 0 ? 1 : 0) + task;
+}
+
+// window row of a head or task, -1 when it has no row on screen (the
+// header-less standalone head, or scrolled out of view)
+static int task_row(int head, int task) {
+    int row = list_row(head, task);
+    return row < 0 ? -1 : list_view_screen_row(&task_data.store.view, row, LIST_TOP);
+}
+
+// repaints the rows of the heads from a to b, which a move reshuffled
+// among themselves
+static void invalidate_heads(struct IModule* self, int a, int b) {
+    if (!layout_list()) {
+        imodule_invalidate(self);
+        return;
+    }
+    const ListView* view = &task_data.store.view;
+    int lo = a < b ? a : b;
+    int hi = a < b ? b : a;
+    int top = list_view_start(view, lo) - view->scroll;
+    int bottom = list_view_start(view, hi + 1) - 1 - view->scroll;
+    imodule_invalidate_rows(self, LIST_TOP + top, LIST_TOP + bottom);
+}
+
+static void draw_row(WINDOW* win, int y, int row) {
+    wmove(win, y, 0);
+    wclrtoeol(win);
+
+    int h = list_view_head_at(&task_data.store.view, row);
+    if (h < 0) return;
+    int offset = row - list_view_start(&task_data.store.view, h);
+    if (h > 0) offset--; // header
+    if (offset == -1) {
+        bool is_selected = h == task_data.selected_head && task_data.selected_task == -1;
+        if (is_selected) wattron(win, A_REVERSE);
+        mvwprintw(win, y, 2, "%s:", text_of(task_data.store.heads[h].name));
+        if (is_selected) wattroff(win, A_REVERSE);
+        return;
+    }
+    if (offset >= task_data.store.heads[h].task_count) return; // gap
+
+    bool is_selected = (h == task_data.selected_head && offset == task_data.selected_task);
+    TaskItem* task = task_at(h, offset);
+
+    if (is_selected) wattron(win, A_REVERSE);
+    if (task->completed) wattron(win, A_DIM);
+
+    int x_offset = (h > 0) ? 4 : 2;
+    mvwprintw(win, y, x_offset, "[%c] %s", task->completed ? 'X' : ' ', text_of(task->description));
+
+    if (task->completed) {
+         int task_len = task->description.length;
+         for (int i = 0; i < task_len; i++) {
+            mvwaddch(win, y, x_offset + 4 + i, '-');
+         }
+    }
+
+    if (is_selected) wattroff(win, A_REVERSE);
+    if (task->completed) wattroff(win, A_DIM);
+}
+
+static void draw_help(WINDOW* win, int help_y) {
     if (task_data.edit_mode) {
-        int help_y = max_y - 8;
-        if (help_y < y) help_y = y;
         mvwprintw(win, help_y++, 2, "Edit Mode %s:", task_data.move_mode ? "[MOVING]" : "");
         mvwprintw(win, help_y++, 4, "R+U: New Head");
         mvwprintw(win, help_y++, 4, "R+I: New Task");
         mvwprintw(win, help_y++, 4, "X: Delete Item");
+        mvwprintw(win, help_y++, 4, "N: Rename Item");
+        mvwprintw(win, help_y++, 4, "G: Go to Head");
         mvwprintw(win, help_y++, 4, "S: Toggle Move");
         mvwprintw(win, help_y++, 4, "E+I: Toggle Edit");
         mvwprintw(win, help_y++, 4, "ESC: Exit Edit/Move");
     } else {
-        int help_y = max_y - 5;
-        if (help_y < y) help_y = y;
         mvwprintw(win, help_y++, 2, "Navigation:");
         mvwprintw(win, help_y++, 4, "↑/↓: Move");
         mvwprintw(win, help_y++, 4, "Space: Toggle");
+        mvwprintw(win, help_y++, 4, "G: Go to Head");
         mvwprintw(win, help_y++, 4, "E+I: Edit Mode");
     }
-    
+}
+
+// only the rows inside the viewport are formatted, whatever the list length
+void tasks_module_render(struct IModule* self, WINDOW* win) {
+    int max_y = getmaxy(win);
+    int help_y = max_y - (task_data.edit_mode ? 10 : 6);
+    ListView* view = &task_data.store.view;
+
+    layout_list();
+    bool scrolled = list_view_resize(view, help_y - LIST_TOP);
+    scrolled |= list_view_follow(view, list_row(task_data.selected_head, task_data.selected_task));
+    if (scrolled) imodule_invalidate(self);
+
+    if (self->full_redraw) {
+        werase(win);
+        // box(win, 0, 0);
+        mvwprintw(win, 1, 2, "Tasks %s", task_data.edit_mode ? "[EDIT MODE]" : "");
+    }
+
+    // rows past the end only need clearing when the list just got shorter
+    int total = list_view_total(view);
+    for (int row = view->scroll; row < view->scroll + view->height; row++) {
+        if (row >= total && self->full_redraw) break;
+        int y = LIST_TOP + row - view->scroll;
+        if (imodule_row_dirty(self, y)) draw_row(win, y, row);
+    }
+
+    // the help block only moves when the list changes shape, which is
+    // always a full redraw
+    if (self->full_redraw) draw_help(win, help_y);
+    // the popup goes over whatever rows were just repainted
+    if (task_data.entry.active) text_entry_render(&task_data.entry, win);
     wnoutrefresh(win);
 }
 
-void tasks_module_handle_input(struct IModule* self, int ch, struct MinimalTui* tui) {
+// --- Undo ---
+// an undo replays inverse operations through the wrappers above, so the
+// journal records it like any other edit. the log notes what the replay
+// changed (see UndoTouched), which becomes rows once the group is done.
+
+static void apply_undo(const UndoOp* op, void* ctx) {
+    (void)ctx;
+    const int* a = op->args;
+    switch (op->op) {
+        case UNDO_ADD_HEAD:
+            tasks_add_head(op->text);
+            break;
+        case UNDO_ADD_ITEM:
+            tasks_add_task(a[0], a[1], op->text);
+            if (a[2]) tasks_set_completed(a[0], a[1], true);
+            break;
+        case UNDO_DELETE_HEAD:
+            tasks_delete_head(a[0]);
+            break;
+        case UNDO_DELETE_ITEM:
+            tasks_delete_task(a[0], a[1]);
+            break;
+        case UNDO_MOVE_HEAD:
+            tasks_move_head(a[0], a[1]);
+            break;
+        case UNDO_MOVE_ITEM:
+            tasks_move_task(a[0], a[1], a[2], a[3]);
+            break;
+        case UNDO_SET_ITEM:
+            tasks_set_completed(a[0], a[1], a[2] != 0);
+            break;
+        case UNDO_RENAME:
+            tasks_rename(a[0], a[1], op->text);
+            break;
+    }
+}
+
+// puts the cursor where the replay left it, and repaints from the first
+// row it touched, or just that row when nothing moved
+static void undo_step(struct IModule* self, bool redo) {
+    UndoLog* log = &task_data.undo;
+    int head = task_data.selected_head;
+    int task = task_data.selected_task;
+    bool done = redo ? undo_redo(log, apply_undo, NULL, head, task)
+                     : undo_undo(log, apply_undo, NULL, head, task);
+    if (!done || task_data.store.head_count == 0) return;
+
+    const UndoTouched* touched = &log->touched;
+    task_data.selected_head = touched->head;
+    task_data.selected_task = touched->pos;
+    item_store_clamp(&task_data.store, &task_data.selected_head, &task_data.selected_task);
+    if (!task_data.edit_mode) ensure_task_selected();
+
+    const ListView* view = &task_data.store.view;
+    if (!layout_list()) {
+        imodule_invalidate(self);
+        return;
+    }
+    int top = list_view_start(view, touched->first);
+    if (!touched->shape && valid_task(touched->first, touched->first_pos)) {
+        top = list_row(touched->first, touched->first_pos);
+    }
+    if (top < view->scroll) {
+        imodule_invalidate(self); // rows above the viewport moved
+        return;
+    }
+    int y = LIST_TOP + top - view->scroll;
+    imodule_invalidate_rows(self, y, touched->shape ? INT_MAX : y);
+}
+
+// what the text field is for; where its text goes is fixed when it opens
+enum { ENTRY_ADD_HEAD, ENTRY_ADD_ITEM, ENTRY_RENAME, ENTRY_JUMP };
+
+static void open_entry(struct IModule* self, const char* prompt, int purpose, int head, int task) {
+    text_entry_start(&task_data.entry, prompt, purpose);
+    task_data.entry_head = head;
+    task_data.entry_task = task;
+    imodule_invalidate(self); // the popup covers part of the list
+}
+
+// the field has the keyboard until it is confirmed or cancelled; only then
+// does anything change
+static void handle_entry(struct IModule* self, InputAction action, int key) {
+    TextEntry* entry = &task_data.entry;
+    TextEntryStatus status = text_entry_feed(entry, action, key);
+    if (status == TEXT_ENTRY_TYPING) {
+        imodule_invalidate_rows(self, entry->top, entry->top + TEXT_ENTRY_ROWS - 1);
+        return;
+    }
+    imodule_invalidate(self); // uncovers the list
+    bool done = status == TEXT_ENTRY_DONE;
+    switch (entry->purpose) {
+        case ENTRY_ADD_HEAD:
+            if (done) {
+                tasks_add_head(entry->text);
+                task_data.selected_head = task_data.store.head_count - 1;
+                task_data.selected_task = -1;
+            }
+            task_data.move_mode = false;
+            ensure_task_selected();
+            break;
+        case ENTRY_ADD_ITEM:
+            if (done) {
+                tasks_add_task(task_data.entry_head, task_data.entry_task, entry->text);
+                task_data.selected_head = task_data.entry_head;
+                task_data.selected_task = task_data.entry_task;
+            }
+            task_data.move_mode = false;
+            ensure_task_selected();
+            break;
+        case ENTRY_RENAME:
+            if (done) tasks_rename(task_data.entry_head, task_data.entry_task, entry->text);
+            break;
+        case ENTRY_JUMP:
+            if (done) {
+                int head_idx = item_store_find_head(&task_data.store, entry->text, (size_t)entry->length);
+                if (head_idx >= 0) select_head(head_idx);
+            }
+            break;
+    }
+}
+
+static void handle_action(struct IModule* self, InputAction action) {
+    if (action == ACTION_UNDO || action == ACTION_REDO) {
+        undo_step(self, action == ACTION_REDO);
+        return;
+    }
     if (task_data.edit_mode) {
         if (task_data.move_mode) {
-             if (ch == 's' || ch == 'S' || ch == 27) {
+            int moved_head = task_data.selected_head;
+            if (action == ACTION_MOVE_MODE || action == ACTION_CANCEL) {
+                imodule_invalidate(self); // the help block changes
                 task_data.move_mode = false;
-            } else if (ch == KEY_UP) {
+            } else if (action == ACTION_UP) {
                 if (task_data.selected_task == -1) { // moving a head
                     if (task_data.selected_head > 0) {
-                        TaskHead temp = task_data.heads[task_data.selected_head];
-                        task_data.heads[task_data.selected_head] = task_data.heads[task_data.selected_head - 1];
-                        task_data.heads[task_data.selected_head - 1] = temp;
+                        tasks_move_head(task_data.selected_head, task_data.selected_head - 1);
                         task_data.selected_head--;
                     }
                 } else { // moving a task
                     int head_idx = task_data.selected_head;
                     int task_idx = task_data.selected_task;
-                    TaskHead* current_head = &task_data.heads[head_idx];
+                    ItemHead* current_head = &task_data.store.heads[head_idx];
 
                     if (task_idx > 0) { // move up within the same head
-                        TaskItem temp = current_head->tasks[task_idx];
-                        current_head->tasks[task_idx] = current_head->tasks[task_idx - 1];
-                        current_head->tasks[task_idx - 1] = temp;
+                        tasks_move_task(head_idx, task_idx, head_idx, task_idx - 1);
                         task_data.selected_task--;
                     } else if (task_idx == 0 && head_idx > 0) { // move task to the previous head
-                        TaskHead* prev_head = &task_data.heads[head_idx - 1];
-                        if (prev_head->task_count < MAX_TASKS_PER_HEAD) {
-                            TaskItem task_to_move = current_head->tasks[task_idx];
-                            
-                            prev_head->tasks[prev_head->task_count] = task_to_move;
-                            prev_head->task_count++;
-                            
-                            memmove(&current_head->tasks[0], &current_head->tasks[1], (current_head->task_count - 1) * sizeof(TaskItem));
-                            current_head->task_count--;
-                            
-                            task_data.selected_head--;
-                            task_data.selected_task = prev_head->task_count - 1;
-
-                            if (current_head->task_count == 0) {
-                                task_data.selected_task = -1;
-                            }
+                        ItemHead* prev_head = &task_data.store.heads[head_idx - 1];
+                        tasks_move_task(head_idx, task_idx, head_idx - 1, prev_head->task_count);
+
+                        task_data.selected_head--;
+                        task_data.selected_task = prev_head->task_count - 1;
+
+                        if (current_head->task_count == 0) {
+                            task_data.selected_task = -1;
                         }
                     }
                 }
-            } else if (ch == KEY_DOWN) {
+            } else if (action == ACTION_DOWN) {
                 if (task_data.selected_task == -1) { // moving a head
-                    if (task_data.selected_head < task_data.head_count - 1) {
-                        TaskHead temp = task_data.heads[task_data.selected_head];
-                        task_data.heads[task_data.selected_head] = task_data.heads[task_data.selected_head + 1];
-                        task_data.heads[task_data.selected_head + 1] = temp;
+                    if (task_data.selected_head < task_data.store.head_count - 1) {
+                        tasks_move_head(task_data.selected_head, task_data.selected_head + 1);
                         task_data.selected_head++;
                     }
                 } else { // moving a task
                     int head_idx = task_data.selected_head;
                     int task_idx = task_data.selected_task;
-                    TaskHead* current_head = &task_data.heads[head_idx];
+                    ItemHead* current_head = &task_data.store.heads[head_idx];
 
                     if (task_idx < current_head->task_count - 1) { // move down within the same head
-                        TaskItem temp = current_head->tasks[task_idx];
-                        current_head->tasks[task_idx] = current_head->tasks[task_idx + 1];
-                        current_head->tasks[task_idx + 1] = temp;
+                        tasks_move_task(head_idx, task_idx, head_idx, task_idx + 1);
                         task_data.selected_task++;
-                    } else if (task_idx == current_head->task_count - 1 && head_idx < task_data.head_count - 1) { // move task to the next head
-                        TaskHead* next_head = &task_data.heads[head_idx + 1];
-                        if (next_head->task_count < MAX_TASKS_PER_HEAD) {
-                            TaskItem task_to_move = current_head->tasks[task_idx];
-
-                            memmove(&next_head->tasks[1], &next_head->tasks[0], next_head->task_count * sizeof(TaskItem));
-                            
-                            next_head->tasks[0] = task_to_move;
-                            next_head->task_count++;
-                            
-                            current_head->task_count--;
-                            
-                            task_data.selected_head++;
-                            task_data.selected_task = 0;
-                        }
+                    } else if (task_idx == current_head->task_count - 1 && head_idx < task_data.store.head_count - 1) { // move task to the next head
+                        tasks_move_task(head_idx, task_idx, head_idx + 1, 0);
+
+                        task_data.selected_head++;
+                        task_data.selected_task = 0;
                     }
                 }
             }
+            invalidate_heads(self, moved_head, task_data.selected_head);
             return;
         }
 
-        switch(ch) {
-            case 'E': case 'e': {
-                int next_ch = getch();
-                if (next_ch == 'I' || next_ch == 'i') {
-                    task_data.edit_mode = false;
-                    ensure_task_selected();
-                }
+        switch (action) {
+            case ACTION_EDIT_MODE:
+                task_data.edit_mode = false;
+                ensure_task_selected();
+                imodule_invalidate(self);
                 break;
-            }
-            case 'R': case 'r': {
-                int next_ch = getch();
-                if (next_ch == 'U' || next_ch == 'u') { // new head
-                     if (task_data.head_count < MAX_HEADS) {
-                        char new_head_name[MAX_NAME_LENGTH] = {0};
-                        if (prompt_for_string(tui->wm.panel_win, "Enter head name: ", new_head_name, MAX_NAME_LENGTH)) {
-                            task_data.heads[task_data.head_count].id = task_data.head_count + 1;
-                            strncpy(task_data.heads[task_data.head_count].name, new_head_name, MAX_NAME_LENGTH - 1);
-                            task_data.heads[task_data.head_count].task_count = 0;
-                            task_data.head_count++;
-                            task_data.selected_head = task_data.head_count - 1;
-                            task_data.selected_task = -1;
-                        }
-                    }
-                } else if (next_ch == 'I' || next_ch == 'i') { // new task
-                    int head_idx = task_data.selected_head;
-                    if (head_idx < 0 && task_data.head_count > 0) head_idx = 0;
-                    if (head_idx < 0) break;
-
-                    TaskHead* head = &task_data.heads[head_idx];
-
-                    if (head->task_count < MAX_TASKS_PER_HEAD) {
-                        int insert_pos = (task_data.selected_task == -1) ? 0 : task_data.selected_task + 1;
+            case ACTION_ADD_HEAD:
+                open_entry(self, "Enter head name: ", ENTRY_ADD_HEAD, -1, -1);
+                break;
+            case ACTION_ADD_ITEM: {
+                int head_idx = task_data.selected_head;
+                if (head_idx < 0 && task_data.store.head_count > 0) head_idx = 0;
+                if (head_idx < 0) break;
 
-                        char new_task_desc[128] = {0};
-                        if (prompt_for_string(tui->wm.panel_win, "Enter task description: ", new_task_desc, 128)) {
-                            if (insert_pos < head->task_count) {
-                                memmove(&head->tasks[insert_pos + 1], 
-                                        &head->tasks[insert_pos], 
-                                        (head->task_count - insert_pos) * sizeof(TaskItem));
-                            }
-                            
-                            head->task_count++;
-                            TaskItem* new_task = &head->tasks[insert_pos];
-                            strncpy(new_task->description, new_task_desc, 128 - 1);
-                            new_task->description[128 - 1] = '\0';
-                            new_task->id = head->task_count;
-                            new_task->completed = false;
-
-                            task_data.selected_task = insert_pos;
-                        }
-                    }
-                }
-                task_data.move_mode = false;
-                ensure_task_selected();
+                int insert_pos = (task_data.selected_task == -1) ? 0 : task_data.selected_task + 1;
+                open_entry(self, "Enter task description: ", ENTRY_ADD_ITEM, head_idx, insert_pos);
                 break;
             }
-            case 's': case 'S':
-                if (task_data.head_count > 0) task_data.move_mode = true;
+            case ACTION_JUMP:
+                open_entry(self, "Jump to head: ", ENTRY_JUMP, -1, -1);
+                break;
+            case ACTION_MOVE_MODE:
+                if (task_data.store.head_count > 0) task_data.move_mode = true;
+                imodule_invalidate(self);
                 break;
-            case 'x': case 'X':
+            case ACTION_DELETE:
+                imodule_invalidate(self);
                  if (task_data.selected_task == -1) { // a head is selected
-                    if (task_data.head_count > 0 && task_data.selected_head > 0) {
-                        int head_to_delete = task_data.selected_head;
-                        
-                        if (head_to_delete < task_data.head_count - 1) {
-                            memmove(&task_data.heads[head_to_delete], 
-                                    &task_data.heads[head_to_delete + 1], 
-                                    (task_data.head_count - head_to_delete - 1) * sizeof(TaskHead));
-                        }
-                        task_data.head_count--;
+                    if (task_data.store.head_count > 0 && task_data.selected_head > 0) {
+                        tasks_delete_head(task_data.selected_head);
 
-                        if (task_data.selected_head >= task_data.head_count && task_data.head_count > 0) {
-                            task_data.selected_head = task_data.head_count - 1;
-                        } else if (task_data.head_count == 0) {
+                        if (task_data.selected_head >= task_data.store.head_count && task_data.store.head_count > 0) {
+                            task_data.selected_head = task_data.store.head_count - 1;
+                        } else if (task_data.store.head_count == 0) {
                             task_data.selected_head = 0;
                             task_data.selected_task = -1;
                         }
                     }
                 } else { // a task is selected
                     int head_idx = task_data.selected_head;
-                    if (head_idx >= 0 && task_data.heads[head_idx].task_count > 0) {
-                        int task_to_delete = task_data.selected_task;
+                    if (head_idx >= 0 && task_data.store.heads[head_idx].task_count > 0) {
+                        tasks_delete_task(head_idx, task_data.selected_task);
 
-                        if (task_to_delete < task_data.heads[head_idx].task_count - 1) {
-                            memmove(&task_data.heads[head_idx].tasks[task_to_delete], 
-                                    &task_data.heads[head_idx].tasks[task_to_delete + 1], 
-                                    (task_data.heads[head_idx].task_count - task_to_delete - 1) * sizeof(TaskItem));
+                        if (task_data.selected_task >= task_data.store.heads[head_idx].task_count) {
+                            task_data.selected_task = task_data.store.heads[head_idx].task_count - 1;
                         }
-                        task_data.heads[head_idx].task_count--;
-
-                        if (task_data.selected_task >= task_data.heads[head_idx].task_count) {
-                            task_data.selected_task = task_data.heads[head_idx].task_count - 1;
-                        }
-                         if (task_data.heads[head_idx].task_count == 0) {
+                         if (task_data.store.heads[head_idx].task_count == 0) {
                             task_data.selected_task = -1;
                         }
                     }
                 }
-                tasks_save("data/tasks.csv");
                 break;
-            case KEY_UP:
+            case ACTION_RENAME: {
+                int head_idx = task_data.selected_head;
+                int task_idx = task_data.selected_task;
+                if (head_idx < 0 || head_idx >= task_data.store.head_count) break;
+                if (task_idx == -1 && head_idx == 0) break; // standalone tasks have no header
+                open_entry(self, "Rename to: ", ENTRY_RENAME, head_idx, task_idx);
+                break;
+            }
+            case ACTION_UP:
                  if (task_data.selected_task > 0) {
                     task_data.selected_task--;
                 } else if (task_data.selected_task == 0) {
@@ -322,31 +719,31 @@ void tasks_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                     if (task_data.selected_head > 0) {
                         task_data.selected_head--;
                     } else {
-                        task_data.selected_head = task_data.head_count - 1;
+                        task_data.selected_head = task_data.store.head_count - 1;
                     }
-                    if (task_data.head_count > 0 && task_data.heads[task_data.selected_head].task_count > 0) {
-                        task_data.selected_task = task_data.heads[task_data.selected_head].task_count - 1;
+                    if (task_data.store.head_count > 0 && task_data.store.heads[task_data.selected_head].task_count > 0) {
+                        task_data.selected_task = task_data.store.heads[task_data.selected_head].task_count - 1;
                     } else {
                         task_data.selected_task = -1;
                     }
                 }
                 break;
-            case KEY_DOWN:
+            case ACTION_DOWN:
                 if (task_data.selected_task == -1) { // head is selected
-                    if (task_data.head_count > 0 && task_data.heads[task_data.selected_head].task_count > 0) {
+                    if (task_data.store.head_count > 0 && task_data.store.heads[task_data.selected_head].task_count > 0) {
                         task_data.selected_task = 0;
                     } else {
-                        if (task_data.selected_head < task_data.head_count - 1) {
+                        if (task_data.selected_head < task_data.store.head_count - 1) {
                             task_data.selected_head++;
                         } else {
                             task_data.selected_head = 0; // loop
                         }
                         task_data.selected_task = -1;
                     }
-                } else if (task_data.selected_task < task_data.heads[task_data.selected_head].task_count - 1) {
+                } else if (task_data.selected_task < task_data.store.heads[task_data.selected_head].task_count - 1) {
                     task_data.selected_task++;
                 } else { // last task
-                    if (task_data.selected_head < task_data.head_count - 1) {
+                    if (task_data.selected_head < task_data.store.head_count - 1) {
                         task_data.selected_head++;
                     } else {
                         task_data.selected_head = 0; // loop
@@ -354,64 +751,69 @@ void tasks_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                     task_data.selected_task = -1;
                 }
                 break;
-            case 27: // esc
+            case ACTION_CANCEL:
                 task_data.edit_mode = false;
                 task_data.move_mode = false;
+                imodule_invalidate(self);
+                break;
+            default:
                 break;
         }
     } else {
         // normal mode
         int total_tasks = 0;
-        for (int i = 0; i < task_data.head_count; i++) {
-            total_tasks += task_data.heads[i].task_count;
+        for (int i = 0; i < task_data.store.head_count; i++) {
+            total_tasks += task_data.store.heads[i].task_count;
         }
         if (total_tasks == 0) {
-             if (ch == 'E' || ch == 'e') {
-                int next_ch = getch();
-                if (next_ch == 'I' || next_ch == 'i') task_data.edit_mode = true;
+             if (action == ACTION_EDIT_MODE) {
+                task_data.edit_mode = true;
+                imodule_invalidate(self);
             }
             return;
         }
 
         ensure_task_selected();
         
-        switch (ch) {
-            case 'E': case 'e': {
-                int next_ch = getch();
-                if (next_ch == 'I' || next_ch == 'i') task_data.edit_mode = true;
+        switch (action) {
+            case ACTION_EDIT_MODE:
+                task_data.edit_mode = true;
+                imodule_invalidate(self);
                 break;
-            }
-            case KEY_UP:
+            case ACTION_JUMP:
+                open_entry(self, "Jump to head: ", ENTRY_JUMP, -1, -1);
+                break;
+            case ACTION_UP:
                 if (task_data.selected_task > 0) {
                     task_data.selected_task--;
                 } else { // first task, find prev head with tasks
                     bool found_prev = false;
                     for (int h = task_data.selected_head - 1; h >= 0; h--) {
-                        if (task_data.heads[h].task_count > 0) {
+                        if (task_data.store.heads[h].task_count > 0) {
                             task_data.selected_head = h;
-                            task_data.selected_task = task_data.heads[h].task_count - 1;
+                            task_data.selected_task = task_data.store.heads[h].task_count - 1;
                             found_prev = true;
                             break;
                         }
                     }
                     if (!found_prev) { // loop around
-                         for (int h = task_data.head_count - 1; h >= 0; h--) {
-                            if (task_data.heads[h].task_count > 0) {
+                         for (int h = task_data.store.head_count - 1; h >= 0; h--) {
+                            if (task_data.store.heads[h].task_count > 0) {
                                 task_data.selected_head = h;
-                                task_data.selected_task = task_data.heads[h].task_count - 1;
+                                task_data.selected_task = task_data.store.heads[h].task_count - 1;
                                 break;
                             }
                         }
                     }
                 }
                 break;
-            case KEY_DOWN:
-                if (task_data.selected_task < task_data.heads[task_data.selected_head].task_count - 1) {
+            case ACTION_DOWN:
+                if (task_data.selected_task < task_data.store.heads[task_data.selected_head].task_count - 1) {
                     task_data.selected_task++;
                 } else { // last task, find next head with tasks
                     bool found_next = false;
-                    for (int h = task_data.selected_head + 1; h < task_data.head_count; h++) {
-                        if (task_data.heads[h].task_count > 0) {
+                    for (int h = task_data.selected_head + 1; h < task_data.store.head_count; h++) {
+                        if (task_data.store.heads[h].task_count > 0) {
                             task_data.selected_head = h;
                             task_data.selected_task = 0;
                             found_next = true;
@@ -419,8 +821,8 @@ void tasks_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                         }
                     }
                     if (!found_next) { // loop around
-                        for (int h = 0; h < task_data.head_count; h++) {
-                            if (task_data.heads[h].task_count > 0) {
+                        for (int h = 0; h < task_data.store.head_count; h++) {
+                            if (task_data.store.heads[h].task_count > 0) {
                                 task_data.selected_head = h;
                                 task_data.selected_task = 0;
                                 break;
@@ -429,137 +831,155 @@ void tasks_module_handle_input(struct IModule* self, int ch, struct MinimalTui*
                     }
                 }
                 break;
-            case ' ':
+            case ACTION_TOGGLE:
                 if (task_data.selected_head >= 0 && task_data.selected_task >= 0) {
-                    task_data.heads[task_data.selected_head].tasks[task_data.selected_task].completed = !task_data.heads[task_data.selected_head].tasks[task_data.selected_task].completed;
+                    TaskItem* task = task_at(task_data.selected_head, task_data.selected_task);
+                    tasks_set_completed(task_data.selected_head, task_data.selected_task, !task->completed);
+                    int row = task_row(task_data.selected_head, task_data.selected_task);
+                    imodule_invalidate_rows(self, row, row);
                 }
                 break;
+            default:
+                break;
         }
     }
 }
 
-static int parse_csv_line(char *line, char **fields, int max_fields) {
-    int field_count = 0;
-    char *p = line;
-    
-    while (*p && field_count < max_fields) {
-        char *start;
-        if (*p == '"') {
-            p++; // Skip "
-            start = p;
-            while (*p && *p != '"') {
-                p++;
-            }
-            if (*p == '"') {
-                *p = '\0';
-                p++;
-            }
-        } else {
-            start = p;
-            while (*p && *p != ',') {
-                p++;
-            }
-        }
-        
-        if (*p == ',') {
-            *p = '\0';
-            p++;
+void tasks_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui) {
+    (void)tui;
+    int old_head = task_data.selected_head;
+    int old_task = task_data.selected_task;
+
+    if (task_data.entry.active) {
+        handle_entry(self, action, key);
+    } else {
+        handle_action(self, action);
+    }
+
+    // moving the cursor only repaints the rows it left and landed on, unless
+    // the list has to scroll to keep it in view
+    if (old_head != task_data.selected_head || old_task != task_data.selected_task) {
+        if (list_view_follow(&task_data.store.view, list_row(task_data.selected_head, task_data.selected_task))) {
+            imodule_invalidate(self);
+            return;
         }
-        
-        fields[field_count++] = start;
+        int old_row = task_row(old_head, old_task);
+        int new_row = task_row(task_data.selected_head, task_data.selected_task);
+        imodule_invalidate_rows(self, old_row, old_row);
+        imodule_invalidate_rows(self, new_row, new_row);
     }
-    
-    return field_count;
 }
 
+void tasks_module_leave(struct IModule* self) {
+    (void)self;
+    text_entry_cancel(&task_data.entry);
+    list_view_release(&task_data.store.view);
+}
 
-int tasks_load(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) return 1;
+void tasks_module_idle(struct IModule* self) {
+    (void)self;
+    item_store_drop_search(&task_data.store);
+}
+
+bool tasks_module_takes_text(const struct IModule* self) {
+    (void)self;
+    return task_data.entry.active;
+}
 
-    char line[512];
-    tasks_init(); 
+size_t tasks_module_memory(const struct IModule* self) {
+    (void)self;
+    return task_data.arena.reserved;
+}
 
-    // Skip header
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
+int tasks_load(const char* filename) {
+    CacheKey key;
+    bool have_csv = cache_key_for(filename, &key) == 0;
+    if (have_csv && load_cache(filename, &key)) {
+        snapshot_journal_open(&task_journal, filename, key.hash, replay_record, NULL);
         return 0;
     }
 
-    while (fgets(line, sizeof(line), file)) {
-        line[strcspn(line, "\r\n")] = 0; 
-        if (strlen(line) == 0) continue;
+    tasks_init();
+    CsvReader csv;
+    if (csv_open(&csv, filename) != 0) {
+        // a journal may exist even without a snapshot
+        snapshot_journal_open(&task_journal, filename, cache_key_hash(filename, &key), replay_record, NULL);
+        return 1;
+    }
 
-        char* fields[3];
-        int num_fields = parse_csv_line(line, fields, 3);
+    csv_next(&csv); // header
 
+    int num_fields;
+    while ((num_fields = csv_next(&csv)) >= 0) {
         if (num_fields < 2) continue;
 
-        char* head_name = fields[0];
-        char* description = fields[1];
-        char* completed_str = (num_fields > 2) ? fields[2] : "0";
+        CsvField head_name = csv.fields[0];
+        CsvField description = csv.fields[1];
+        bool completed = num_fields > 2 && csv_field_long(csv.fields[2]) != 0;
 
-        int head_idx = -1;
-        if (strlen(head_name) == 0) {
-            head_idx = 0;
-        } else {
-            for (int i = 1; i < task_data.head_count; i++) {
-                if (strcmp(task_data.heads[i].name, head_name) == 0) {
-                    head_idx = i;
-                    break;
-                }
-            }
-        }
+        int head_idx = head_name.len == 0 ? 0 : item_store_find_head(&task_data.store, head_name.ptr, head_name.len);
 
         if (head_idx == -1) {
-            if (task_data.head_count >= MAX_HEADS) continue;
-            head_idx = task_data.head_count;
-            TaskHead* new_head = &task_data.heads[head_idx];
-            strncpy(new_head->name, head_name, MAX_NAME_LENGTH - 1);
-            new_head->name[MAX_NAME_LENGTH - 1] = '\0';
-            new_head->task_count = 0;
-            task_data.head_count++;
+            if (!item_store_add_head(&task_data.store, head_name.ptr, head_name.len)) continue;
+            head_idx = task_data.store.head_count - 1;
         }
         
-        if (strlen(description) == 0) {
+        if (description.len == 0) {
             continue;
         }
 
-        TaskHead* head = &task_data.heads[head_idx];
-        if (head->task_count < MAX_TASKS_PER_HEAD) {
-            TaskItem* task = &head->tasks[head->task_count];
-            strncpy(task->description, description, 128 - 1);
-            task->description[128 - 1] = '\0';
-            task->completed = atoi(completed_str);
-            head->task_count++;
+        TaskItem* task = item_store_insert(&task_data.store, head_idx, task_data.store.heads[head_idx].task_count,
+                                           description.ptr, description.len);
+        if (task) {
+            task->id = task_data.store.heads[head_idx].task_count;
+            task->completed = completed;
         }
     }
 
-    fclose(file);
+    csv_close(&csv);
+    // before the journal is replayed: the cache mirrors the CSV alone
+    if (have_csv) write_cache(filename, &key);
+    snapshot_journal_open(&task_journal, filename, cache_key_hash(filename, &key), replay_record, NULL);
     return 0;
 }
 
 int tasks_save(const char* filename) {
-    FILE* file = fopen(filename, "w");
+    PersistFile out;
+    FILE* file = persist_begin(&out, filename);
     if (!file) return 1;
 
     fprintf(file, "head_name,description,completed\n");
 
-    for (int h = 0; h < task_data.head_count; h++) {
-        if (task_data.heads[h].task_count == 0) {
+    CsvWriter csv;
+    csv_writer_init(&csv, file);
+    for (int h = 0; h < task_data.store.head_count; h++) {
+        if (task_data.store.heads[h].task_count == 0) {
             if (h > 0) {
-                fprintf(file, "\"%s\",\"\",0\n", task_data.heads[h].name);
+                csv_write_text(&csv, text_of(task_data.store.heads[h].name));
+                csv_write_text(&csv, "");
+                csv_write_long(&csv, 0);
+                csv_end_record(&csv);
             }
         } else {
-            for (int t = 0; t < task_data.heads[h].task_count; t++) {
-                fprintf(file, "\"%s\",\"%s\",%d\n",
-                        task_data.heads[h].name,
-                        task_data.heads[h].tasks[t].description,
-                        (int)task_data.heads[h].tasks[t].completed);
+            for (int t = 0; t < task_data.store.heads[h].task_count; t++) {
+                TaskItem* task = task_at(h, t);
+                csv_write_text(&csv, text_of(task_data.store.heads[h].name));
+                csv_write_text(&csv, text_of(task->description));
+                csv_write_long(&csv, task->completed);
+                csv_end_record(&csv);
             }
         }
     }
 
-    fclose(file);
+    // written to a temp file and renamed, the old snapshot stays intact on failure
+    if (persist_commit(&out) != 0) return 1;
+
+    // the snapshot now holds everything, start a fresh journal on top of it
+    if (snapshot_journal_owns(&task_journal, filename)) {
+        CacheKey key;
+        cache_key_for(filename, &key);
+        journal_reset(&task_journal.journal, cache_key_hash(filename, &key));
+        write_cache(filename, &key);
+    }
     return 0;
 } 
\ No newline at end of file
@@ -2,18 +2,53 @@
 #define TASK_MANAGER_H
 
 #include <ncurses.h>
+#include "imodule.h"
 #include "structs.h"
 
-struct IModule;
 struct MinimalTui;
 
 void tasks_init();
 void tasks_cleanup();
 
 void tasks_module_render(struct IModule* self, WINDOW* win);
-void tasks_module_handle_input(struct IModule* self, int ch, struct MinimalTui* tui);
+void tasks_module_handle_input(struct IModule* self, InputAction action, int key, struct MinimalTui* tui);
+// drops the row layout while the list is hidden
+void tasks_module_leave(struct IModule* self);
+// drops the search index, rebuilt by the next search
+void tasks_module_idle(struct IModule* self);
+size_t tasks_module_memory(const struct IModule* self);
+bool tasks_module_takes_text(const struct IModule* self);
 
+// loads the CSV snapshot and replays data/<name>.journal on top of it
 int tasks_load(const char* filename);
+// writes a full snapshot; for the loaded file this also compacts the journal
 int tasks_save(const char* filename);
+// flushes on exit: compacts if the journal grew large, closes it. does
+// nothing when nothing was loaded
+int tasks_close(void);
+// whether tasks_load ran since the last close
+bool tasks_is_loaded(void);
+
+// text bytes stored (deleted text included until the next compaction)
+// against bytes allocated for them
+void tasks_string_usage(size_t* used, size_t* reserved);
+
+// palette search over task descriptions and head names, best first. a
+// head's hit carries -1 - its id as doc, a task's its slot.
+int tasks_search(const GramQuery* query, GramHit* hits, int max);
+// text of a hit, NULL once the item is gone
+const char* tasks_hit_text(int doc);
+// selects the hit's task or head
+void tasks_reveal(int doc);
+
+// journaled mutations, each costs one appended record
+void tasks_add_head(const char* name);
+void tasks_add_task(int head, int pos, const char* description);
+void tasks_delete_head(int head);
+void tasks_delete_task(int head, int task);
+void tasks_move_head(int from, int to);
+void tasks_move_task(int from_head, int from_task, int to_head, int to_task);
+void tasks_set_completed(int head, int task, bool completed);
+void tasks_rename(int head, int task, const char* text); // task == -1 renames the head
 
 #endif 
\ No newline at end of file
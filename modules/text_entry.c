@@ -0,0 +1,57 @@
+#include "text_entry.h"
+#include <string.h>
+
+#define TEXT_ENTRY_WIDTH 60 // widest the popup gets, the text scrolls inside
+
+void text_entry_start(TextEntry* entry, const char* prompt, int purpose) {
+    entry->active = true;
+    entry->purpose = purpose;
+    entry->prompt = prompt;
+    entry->text[0] = '\0';
+    entry->length = 0;
+}
+
+void text_entry_cancel(TextEntry* entry) {
+    entry->active = false;
+}
+
+TextEntryStatus text_entry_feed(TextEntry* entry, InputAction action, int key) {
+    if (action == ACTION_CONFIRM || action == ACTION_CANCEL) {
+        entry->active = false;
+        return action == ACTION_CONFIRM && entry->length > 0 ? TEXT_ENTRY_DONE : TEXT_ENTRY_CANCELLED;
+    }
+    if (key == KEY_BACKSPACE || key == 127 || key == 8) {
+        // a whole utf-8 sequence at a time
+        while (entry->length > 0 && (entry->text[entry->length - 1] & 0xc0) == 0x80) entry->length--;
+        if (entry->length > 0) entry->length--;
+        entry->text[entry->length] = '\0';
+    } else if (key >= ' ' && key < 256 && key != 127 && entry->length < TEXT_ENTRY_LENGTH - 1) {
+        entry->text[entry->length++] = (char)key;
+        entry->text[entry->length] = '\0';
+    }
+    return TEXT_ENTRY_TYPING;
+}
+
+void text_entry_render(TextEntry* entry, WINDOW* win) {
+    int parent_h, parent_w;
+    getmaxyx(win, parent_h, parent_w);
+    int prompt_len = (int)strlen(entry->prompt);
+    int w = prompt_len + 24;
+    if (w < TEXT_ENTRY_WIDTH) w = TEXT_ENTRY_WIDTH;
+    if (w > parent_w - 2) w = parent_w - 2;
+    int room = w - prompt_len - 5; // borders, padding and the caret
+    if (room < 1 || parent_h < TEXT_ENTRY_ROWS) return;
+    entry->top = (parent_h - TEXT_ENTRY_ROWS) / 2;
+
+    WINDOW* popup = derwin(win, TEXT_ENTRY_ROWS, w, entry->top, (parent_w - w) / 2);
+    if (!popup) return;
+    werase(popup);
+    box(popup, 0, 0);
+    // the end of the text is what is being typed, so that is what shows
+    int shown = entry->length < room ? entry->length : room;
+    mvwprintw(popup, 1, 2, "%s%.*s", entry->prompt, shown, entry->text + entry->length - shown);
+    wattron(popup, A_REVERSE);
+    waddch(popup, ' ');
+    wattroff(popup, A_REVERSE);
+    delwin(popup);
+}
@@ -0,0 +1,38 @@
+#ifndef TEXT_ENTRY_H
+#define TEXT_ENTRY_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+#include "imodule.h"
+
+#define TEXT_ENTRY_LENGTH 512 // bytes, the terminating 0 included
+
+// a one line text field drawn over a module's list. it never waits for
+// input: the module feeds it keys as they arrive (see IModule.takes_text)
+// and acts on the text once the field is confirmed. purpose is the owner's
+// own note of what the text is for.
+typedef struct {
+    bool active;
+    int purpose;
+    const char* prompt;
+    char text[TEXT_ENTRY_LENGTH];
+    int length;
+    int top; // window row of the popup's first line at the last render
+} TextEntry;
+
+typedef enum {
+    TEXT_ENTRY_TYPING,
+    TEXT_ENTRY_DONE,      // confirmed with some text in it
+    TEXT_ENTRY_CANCELLED  // esc, or confirmed empty
+} TextEntryStatus;
+
+#define TEXT_ENTRY_ROWS 3
+
+void text_entry_start(TextEntry* entry, const char* prompt, int purpose);
+void text_entry_cancel(TextEntry* entry);
+// one key: confirm and cancel as actions, anything else as the key typed
+TextEntryStatus text_entry_feed(TextEntry* entry, InputAction action, int key);
+// draws the popup centred in win, over whatever render put there
+void text_entry_render(TextEntry* entry, WINDOW* win);
+
+#endif
@@ -0,0 +1,178 @@
+#include "undo_log.h"
+#include <limits.h>
+#include <string.h>
+
+void undo_init(UndoLog* log, Arena* arena) {
+    memset(log, 0, sizeof(*log));
+    log->arena = arena;
+    log->target = &log->undo;
+}
+
+static char* copy_text(Arena* arena, const char* text) {
+    if (!text) return NULL;
+    size_t len = strlen(text);
+    char* copy = arena_alloc(arena, len + 1);
+    if (copy) memcpy(copy, text, len + 1);
+    return copy;
+}
+
+static void release_ops(Arena* arena, UndoStack* stack, int from) {
+    for (int i = from; i < stack->count; i++) {
+        arena_release(arena, stack->ops[i].text);
+        arena_release(arena, stack->ops[i].detail);
+    }
+    stack->count = from;
+}
+
+static void drop_oldest(Arena* arena, UndoStack* stack) {
+    int end = stack->group_count > 1 ? stack->groups[1] : stack->count;
+    for (int i = 0; i < end; i++) {
+        arena_release(arena, stack->ops[i].text);
+        arena_release(arena, stack->ops[i].detail);
+    }
+    memmove(stack->ops, stack->ops + end, (size_t)(stack->count - end) * sizeof(UndoOp));
+    stack->count -= end;
+    memmove(stack->groups, stack->groups + 1, (size_t)(stack->group_count - 1) * sizeof(int));
+    stack->group_count--;
+    for (int g = 0; g < stack->group_count; g++) stack->groups[g] -= end;
+}
+
+static bool open_group(UndoLog* log, UndoStack* stack) {
+    if (stack->group_count == UNDO_DEPTH) drop_oldest(log->arena, stack);
+    int* groups = arena_grow(log->arena, stack->groups, &stack->group_capacity,
+                             stack->group_count + 1, sizeof(int));
+    if (!groups) return false;
+    stack->groups = groups;
+    stack->groups[stack->group_count++] = stack->count;
+    return true;
+}
+
+// a group nothing was pushed to
+static void close_if_empty(UndoStack* stack) {
+    if (stack->group_count > 0 && stack->groups[stack->group_count - 1] == stack->count) {
+        stack->group_count--;
+    }
+}
+
+void undo_begin(UndoLog* log) {
+    if (!log->arena || log->replaying) return;
+    release_ops(log->arena, &log->redo, 0);
+    log->redo.group_count = 0;
+    close_if_empty(&log->undo);
+    open_group(log, &log->undo);
+}
+
+bool undo_push(UndoLog* log, int op, int a, int b, int c, int d,
+               const char* text, const char* detail) {
+    UndoStack* stack = log->target;
+    if (!log->arena || stack->group_count == 0) return false;
+    UndoOp* ops = arena_grow(log->arena, stack->ops, &stack->capacity, stack->count + 1, sizeof(UndoOp));
+    if (!ops) return false;
+    stack->ops = ops;
+
+    UndoOp* entry = &ops[stack->count];
+    entry->op = op;
+    entry->args[0] = a;
+    entry->args[1] = b;
+    entry->args[2] = c;
+    entry->args[3] = d;
+    entry->text = copy_text(log->arena, text);
+    entry->detail = copy_text(log->arena, detail);
+    if ((text && !entry->text) || (detail && !entry->detail)) {
+        arena_release(log->arena, entry->text);
+        arena_release(log->arena, entry->detail);
+        return false;
+    }
+    stack->count++;
+    return true;
+}
+
+static void touch(UndoTouched* touched, int head, int pos, bool shape) {
+    if (touched->first == INT_MAX) {
+        touched->first = head;
+        touched->first_pos = pos;
+        touched->shape = shape;
+        return;
+    }
+    if (!shape && !touched->shape && head == touched->first && pos == touched->first_pos) return;
+    if (head < touched->first) touched->first = head;
+    touched->shape = true; // more than one row: repaint from the first head down
+}
+
+static void focus(UndoTouched* touched, int head, int pos) {
+    touched->head = head;
+    touched->pos = pos;
+}
+
+// what a list operation just replayed changed, and where it leaves the cursor
+static void note(UndoTouched* touched, const UndoOp* op) {
+    const int* a = op->args;
+    switch (op->op) {
+        case UNDO_ADD_HEAD:
+            touch(touched, a[0], -1, true);
+            focus(touched, a[0], -1);
+            break;
+        case UNDO_DELETE_HEAD:
+            touch(touched, a[0], -1, true);
+            focus(touched, a[0] - 1, -1);
+            break;
+        case UNDO_ADD_ITEM:
+        case UNDO_DELETE_ITEM:
+            touch(touched, a[0], a[1], true);
+            focus(touched, a[0], a[1]);
+            break;
+        case UNDO_MOVE_HEAD:
+            touch(touched, a[0] < a[1] ? a[0] : a[1], -1, true);
+            focus(touched, a[1], -1);
+            break;
+        case UNDO_MOVE_ITEM:
+            touch(touched, a[0] < a[2] ? a[0] : a[2], -1, true);
+            focus(touched, a[2], a[3]);
+            break;
+        case UNDO_RENAME:
+        case UNDO_SET_ITEM:
+            touch(touched, a[0], a[1], false);
+            focus(touched, a[0], a[1]);
+            break;
+    }
+}
+
+static bool replay(UndoLog* log, UndoStack* from, UndoStack* to, UndoApplyFn apply, void* ctx,
+                   int head, int pos) {
+    close_if_empty(from);
+    if (!log->arena || from->group_count == 0) return false;
+    int start = from->groups[--from->group_count];
+
+    log->touched.first = INT_MAX;
+    focus(&log->touched, head, pos);
+    log->replaying = true;
+    log->target = to;
+    bool recording = open_group(log, to);
+    for (int i = from->count - 1; i >= start; i--) {
+        apply(&from->ops[i], ctx);
+        note(&log->touched, &from->ops[i]);
+    }
+    if (recording) close_if_empty(to);
+    log->target = &log->undo;
+    log->replaying = false;
+
+    release_ops(log->arena, from, start);
+    return true;
+}
+
+bool undo_undo(UndoLog* log, UndoApplyFn apply, void* ctx, int head, int pos) {
+    return replay(log, &log->undo, &log->redo, apply, ctx, head, pos);
+}
+
+bool undo_redo(UndoLog* log, UndoApplyFn apply, void* ctx, int head, int pos) {
+    return replay(log, &log->redo, &log->undo, apply, ctx, head, pos);
+}
+
+char* undo_save_text(UndoLog* log, const char* text) {
+    return copy_text(log->arena, text);
+}
+
+void undo_push_head_restore(UndoLog* log, int head, int head_count, const char* name) {
+    if (head < head_count) undo_push(log, UNDO_MOVE_HEAD, head_count, head, 0, 0, NULL, NULL);
+    undo_push(log, UNDO_ADD_HEAD, head_count, 0, 0, 0, name, NULL);
+}
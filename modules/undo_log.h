@@ -0,0 +1,90 @@
+#ifndef UNDO_LOG_H
+#define UNDO_LOG_H
+
+#include <stdbool.h>
+#include "arena.h"
+
+// bounded undo and redo for a module's edits, kept as operations rather
+// than copies of the data. every edit pushes the operation that reverses it,
+// with whatever text that needs (the name of a deleted item, say). an undo
+// replays those through the module's own edit functions, which journal as
+// usual and push their own inverses meanwhile: those become the redo, and
+// a redo's become the undo again.
+//
+// operations come in groups, one per user action; undoing a deleted head
+// is one group that adds the head back and then each of its items.
+#define UNDO_DEPTH 100 // groups kept, the oldest are dropped
+
+typedef struct {
+    int op;       // the owner's code
+    int args[4];
+    char* text;   // copies from the arena, NULL when unused
+    char* detail;
+} UndoOp;
+
+typedef struct {
+    UndoOp* ops;
+    int count;
+    int capacity;
+    int* groups;  // where each group starts in ops
+    int group_count;
+    int group_capacity;
+} UndoStack;
+
+typedef void (*UndoApplyFn)(const UndoOp* op, void* ctx);
+
+// the codes of a list of heads and their items, which both managers are.
+// replaying these the log also notes which rows they changed and where the
+// cursor belongs, so an owner only has to run the edits.
+enum {
+    UNDO_ADD_HEAD,    // where it lands (the end); text: name
+    UNDO_ADD_ITEM,    // head, pos, the owner's; text: the item's, detail: the owner's
+    UNDO_DELETE_HEAD, // head
+    UNDO_DELETE_ITEM, // head, pos
+    UNDO_MOVE_HEAD,   // from, to
+    UNDO_MOVE_ITEM,   // from head, from pos, to head, to pos
+    UNDO_RENAME,      // head, pos (-1 for the head); text: the old name
+    UNDO_SET_ITEM,    // head, pos, the owner's: one item's own state
+};
+
+// what the last undo or redo changed. only the first head is kept; the
+// owner turns that into rows once, however many operations the group held.
+typedef struct {
+    int first;     // lowest head changed, INT_MAX while nothing is
+    int first_pos; // the only row changed, unless shape
+    bool shape;    // rows from the first head down moved
+    int head;      // where the cursor goes afterwards
+    int pos;
+} UndoTouched;
+
+typedef struct {
+    Arena* arena;
+    UndoStack undo;
+    UndoStack redo;
+    UndoStack* target; // where pushes go: the redo while undoing and so on
+    bool replaying;
+    UndoTouched touched;
+} UndoLog;
+
+void undo_init(UndoLog* log, Arena* arena);
+// opens the group for a new user action and forgets the redo. while an
+// undo or redo runs it does nothing, their pushes form one group.
+void undo_begin(UndoLog* log);
+// adds the inverse of what was just done to the open group
+bool undo_push(UndoLog* log, int op, int a, int b, int c, int d,
+               const char* text, const char* detail);
+// replays the newest group through apply, last pushed first. false when
+// there is nothing to undo (or redo); otherwise log->touched says what
+// changed, with the cursor at head, pos unless an operation moved it.
+bool undo_undo(UndoLog* log, UndoApplyFn apply, void* ctx, int head, int pos);
+bool undo_redo(UndoLog* log, UndoApplyFn apply, void* ctx, int head, int pos);
+
+// a copy of text in the log's arena, for an edit that releases the text
+// its inverse needs: taken before the edit, pushed after, then released
+char* undo_save_text(UndoLog* log, const char* text);
+// the inverse of deleting a head, after its items' re-adds were pushed:
+// the head comes back at the end and is moved into place (replay runs the
+// group backwards). head_count as left by the delete.
+void undo_push_head_restore(UndoLog* log, int head, int head_count, const char* name);
+
+#endif
@@ -0,0 +1,65 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  char key[CONFIG_KEY_LENGTH];
+  char value[CONFIG_VALUE_LENGTH];
+} ConfigEntry;
+
+static ConfigEntry entries[CONFIG_MAX_ENTRIES];
+static int entry_count = 0;
+
+static ConfigEntry *find(const char *key) {
+  for (int i = 0; i < entry_count; ++i) {
+    if (strcmp(entries[i].key, key) == 0)
+      return &entries[i];
+  }
+  return NULL;
+}
+
+int config_load(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return 1;
+
+  char line[CONFIG_KEY_LENGTH + CONFIG_VALUE_LENGTH + 2];
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    char *eq = strchr(line, '=');
+    if (!eq || eq == line || line[0] == '#')
+      continue;
+    *eq = '\0';
+    config_set(line, eq + 1);
+  }
+  fclose(f);
+  return 0;
+}
+
+const char *config_get(const char *key) {
+  ConfigEntry *e = find(key);
+  return e ? e->value : NULL;
+}
+
+long config_get_long(const char *key, long fallback) {
+  const char *value = config_get(key);
+  if (!value || !value[0])
+    return fallback;
+  char *end;
+  long n = strtol(value, &end, 10);
+  return *end == '\0' ? n : fallback;
+}
+
+void config_set(const char *key, const char *value) {
+  ConfigEntry *e = find(key);
+  if (!e) {
+    if (entry_count >= CONFIG_MAX_ENTRIES)
+      return;
+    e = &entries[entry_count++];
+    strncpy(e->key, key, CONFIG_KEY_LENGTH - 1);
+    e->key[CONFIG_KEY_LENGTH - 1] = '\0';
+  }
+  strncpy(e->value, value, CONFIG_VALUE_LENGTH - 1);
+  e->value[CONFIG_VALUE_LENGTH - 1] = '\0';
+}
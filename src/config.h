@@ -0,0 +1,24 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define CONFIG_MAX_ENTRIES 32
+#define CONFIG_KEY_LENGTH 64
+#define CONFIG_VALUE_LENGTH 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// key=value store behind data/settings.conf. values run to the end of the
+// line, so they may contain spaces (handy for commands).
+int config_load(const char* path);
+
+const char* config_get(const char* key); // NULL when unset
+long config_get_long(const char* key, long fallback);
+void config_set(const char* key, const char* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
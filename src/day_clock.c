@@ -0,0 +1,66 @@
+#include "day_clock.h"
+#include "../modules/history.h"
+#include "event_loop.h"
+#include <stdint.h>
+#include <time.h>
+
+static struct {
+  int today;
+  int timer;
+  void (*on_change)(int day, void *ctx);
+  void *ctx;
+} day_clock = {.timer = -1};
+
+// nanoseconds from now until the next local midnight. mktime normalises
+// the 32nd of a month and picks the right utc offset across dst changes.
+static uint64_t until_midnight(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  struct tm tm_now;
+  localtime_r(&now.tv_sec, &tm_now);
+  tm_now.tm_mday += 1;
+  tm_now.tm_hour = 0;
+  tm_now.tm_min = 0;
+  tm_now.tm_sec = 0;
+  tm_now.tm_isdst = -1;
+  time_t midnight = mktime(&tm_now);
+  int64_t left = (int64_t)(midnight - now.tv_sec) * (int64_t)NSEC_PER_SEC - now.tv_nsec;
+  return left > 0 ? (uint64_t)left : 0;
+}
+
+static void arm_timer(void);
+
+// the timer runs on the monotonic clock, so a wall clock that was set
+// back can make it fire early: then the date hasn't changed and it is
+// simply armed again
+static void timer_cb(void *ctx) {
+  (void)ctx;
+  day_clock.timer = -1;
+  int day = history_today();
+  if (day != day_clock.today) {
+    day_clock.today = day;
+    if (day_clock.on_change)
+      day_clock.on_change(day, day_clock.ctx);
+  }
+  arm_timer();
+}
+
+static void arm_timer(void) {
+  event_loop_timer_stop(day_clock.timer);
+  // a moment past midnight, so localtime already reports the new date
+  uint64_t due = event_loop_now() + until_midnight() + 10 * NSEC_PER_MSEC;
+  day_clock.timer = event_loop_timer_start(timer_cb, NULL, due, 0);
+}
+
+void day_clock_init(void (*on_change)(int day, void *ctx), void *ctx) {
+  day_clock.on_change = on_change;
+  day_clock.ctx = ctx;
+  day_clock.today = history_today();
+  arm_timer();
+}
+
+void day_clock_cleanup(void) {
+  event_loop_timer_stop(day_clock.timer);
+  day_clock.timer = -1;
+  day_clock.on_change = NULL;
+}
@@ -0,0 +1,19 @@
+#ifndef DAY_CLOCK_H
+#define DAY_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// calls on_change(day) whenever the local date moves on, with day numbered
+// as in history.h. nothing polls: one event loop timer is armed for the
+// next local midnight, and a jump of several days (a suspended laptop, a
+// changed clock) is still a single call with the new day.
+void day_clock_init(void (*on_change)(int day, void* ctx), void* ctx);
+void day_clock_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
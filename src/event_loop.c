@@ -0,0 +1,258 @@
+#include "event_loop.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#endif
+
+// CLOCK_BOOTTIME is CLOCK_MONOTONIC plus the time spent suspended, so a
+// deadline set before closing the lid is still honoured after resume
+#ifdef CLOCK_BOOTTIME
+#define EVENT_CLOCK CLOCK_BOOTTIME
+#else
+#define EVENT_CLOCK CLOCK_MONOTONIC
+#endif
+
+typedef struct {
+  bool active;
+  uint64_t deadline;
+  uint64_t interval;
+  EventTimerFn fn;
+  void *ctx;
+} EventTimer;
+
+static struct {
+  int input_fd;
+  int signal_fd; // signalfd on linux, read end of the self-pipe elsewhere
+  int timer_fd;  // -1 when deadlines are handled through the poll timeout
+  EventTimer timers[EVENT_MAX_TIMERS];
+  EventSignalFn on_child; // SIGCHLD arrived, some child may have exited
+  void *child_ctx;
+} loop = {-1, -1, -1, {{0}}, NULL, NULL};
+
+#ifndef __linux__
+static int wake_pipe[2] = {-1, -1};
+
+// the byte written is the signal number, so the loop can tell them apart
+static void on_signal(int sig) {
+  int saved = errno;
+  char c = (char)sig;
+  if (write(wake_pipe[1], &c, 1) < 0) {
+    // pipe full, a wakeup is already pending
+  }
+  errno = saved;
+}
+#endif
+
+uint64_t event_loop_now(void) {
+  struct timespec ts;
+  clock_gettime(EVENT_CLOCK, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+int event_loop_init(int input_fd) {
+  loop.input_fd = input_fd;
+  memset(loop.timers, 0, sizeof(loop.timers));
+
+#ifdef __linux__
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGWINCH);
+  sigaddset(&mask, SIGCHLD);
+  if (sigprocmask(SIG_BLOCK, &mask, NULL) != 0)
+    return 1;
+  loop.signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  loop.timer_fd = timerfd_create(EVENT_CLOCK, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (loop.signal_fd < 0 || loop.timer_fd < 0)
+    return 1;
+#else
+  if (pipe(wake_pipe) != 0)
+    return 1;
+  for (int i = 0; i < 2; ++i) {
+    fcntl(wake_pipe[i], F_SETFL, fcntl(wake_pipe[i], F_GETFL) | O_NONBLOCK);
+    fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+  }
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  if (sigaction(SIGWINCH, &sa, NULL) != 0 || sigaction(SIGCHLD, &sa, NULL) != 0)
+    return 1;
+  loop.signal_fd = wake_pipe[0];
+#endif
+  return 0;
+}
+
+void event_loop_cleanup(void) {
+#ifdef __linux__
+  if (loop.signal_fd >= 0)
+    close(loop.signal_fd);
+  if (loop.timer_fd >= 0)
+    close(loop.timer_fd);
+#else
+  for (int i = 0; i < 2; ++i) {
+    if (wake_pipe[i] >= 0)
+      close(wake_pipe[i]);
+    wake_pipe[i] = -1;
+  }
+#endif
+  loop.signal_fd = -1;
+  loop.timer_fd = -1;
+}
+
+void event_loop_on_child(EventSignalFn fn, void *ctx) {
+  loop.on_child = fn;
+  loop.child_ctx = ctx;
+}
+
+int event_loop_timer_start(EventTimerFn fn, void *ctx, uint64_t deadline,
+                           uint64_t interval) {
+  for (int i = 0; i < EVENT_MAX_TIMERS; ++i) {
+    EventTimer *t = &loop.timers[i];
+    if (!t->active) {
+      t->active = true;
+      t->deadline = deadline;
+      t->interval = interval;
+      t->fn = fn;
+      t->ctx = ctx;
+      return i;
+    }
+  }
+  return -1;
+}
+
+void event_loop_timer_stop(int id) {
+  if (id >= 0 && id < EVENT_MAX_TIMERS)
+    loop.timers[id].active = false;
+}
+
+bool event_loop_timer_active(int id) {
+  return id >= 0 && id < EVENT_MAX_TIMERS && loop.timers[id].active;
+}
+
+// earliest armed deadline, or 0 when no timer is active
+static uint64_t next_deadline(void) {
+  uint64_t best = 0;
+  for (int i = 0; i < EVENT_MAX_TIMERS; ++i) {
+    if (loop.timers[i].active &&
+        (best == 0 || loop.timers[i].deadline < best))
+      best = loop.timers[i].deadline;
+  }
+  return best;
+}
+
+static int run_due_timers(void) {
+  uint64_t now = event_loop_now();
+  int fired = 0;
+  for (int i = 0; i < EVENT_MAX_TIMERS; ++i) {
+    EventTimer *t = &loop.timers[i];
+    if (!t->active || t->deadline > now)
+      continue;
+    if (t->interval > 0) {
+      // skip missed periods instead of firing a burst after a stall
+      uint64_t missed = (now - t->deadline) / t->interval;
+      t->deadline += (missed + 1) * t->interval;
+    } else {
+      t->active = false;
+    }
+    t->fn(t->ctx);
+    fired = 1;
+  }
+  return fired;
+}
+
+bool event_loop_input_pending(void) {
+  struct pollfd pfd = {loop.input_fd, POLLIN, 0};
+  return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+}
+
+int event_loop_wait(void) {
+  uint64_t deadline = next_deadline();
+  int timeout_ms = -1;
+
+#ifdef __linux__
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  if (deadline) {
+    its.it_value.tv_sec = deadline / NSEC_PER_SEC;
+    its.it_value.tv_nsec = deadline % NSEC_PER_SEC;
+    if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+      its.it_value.tv_nsec = 1; // a zero value would disarm the timer
+  }
+  timerfd_settime(loop.timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+#else
+  if (deadline) {
+    uint64_t now = event_loop_now();
+    // round up so we never wake a hair before the deadline and spin
+    timeout_ms = deadline <= now
+                     ? 0
+                     : (int)((deadline - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC);
+  }
+#endif
+
+  struct pollfd fds[3];
+  int nfds = 0;
+  fds[nfds].fd = loop.input_fd;
+  fds[nfds++].events = POLLIN;
+  fds[nfds].fd = loop.signal_fd;
+  fds[nfds++].events = POLLIN;
+  if (loop.timer_fd >= 0) {
+    fds[nfds].fd = loop.timer_fd;
+    fds[nfds++].events = POLLIN;
+  }
+
+  int events = 0;
+  int n = poll(fds, nfds, timeout_ms);
+  if (n < 0 && errno != EINTR)
+    return 0;
+
+  if (n > 0) {
+    if (fds[0].revents & POLLIN)
+      events |= EVENT_INPUT;
+    if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL))
+      events |= EVENT_HANGUP;
+    if (fds[1].revents & POLLIN) {
+      // drain every queued notification, one resize (or one reap) covers them all
+      bool child = false;
+#ifdef __linux__
+      struct signalfd_siginfo info;
+      while (read(loop.signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        if (info.ssi_signo == SIGCHLD)
+          child = true;
+        else
+          events |= EVENT_RESIZE;
+      }
+#else
+      char buf[128];
+      ssize_t len;
+      while ((len = read(loop.signal_fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < len; ++i) {
+          if (buf[i] == SIGCHLD)
+            child = true;
+          else
+            events |= EVENT_RESIZE;
+        }
+      }
+#endif
+      if (child && loop.on_child)
+        loop.on_child(loop.child_ctx);
+    }
+    if (nfds > 2 && (fds[2].revents & POLLIN)) {
+      uint64_t expirations;
+      if (read(loop.timer_fd, &expirations, sizeof(expirations)) < 0) {
+        // spurious wakeup, due timers are checked below anyway
+      }
+    }
+  }
+
+  if (run_due_timers())
+    events |= EVENT_TIMER;
+  return events;
+}
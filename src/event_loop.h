@@ -0,0 +1,58 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EVENT_MAX_TIMERS 16
+
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_SEC 1000000000ULL
+
+// bits returned by event_loop_wait
+#define EVENT_INPUT  0x1
+#define EVENT_RESIZE 0x2
+#define EVENT_TIMER  0x4
+#define EVENT_HANGUP 0x8
+
+typedef void (*EventTimerFn)(void *ctx);
+typedef void (*EventSignalFn)(void *ctx);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// sets up the wakeup sources (tty fd, SIGWINCH, SIGCHLD, timer). must be
+// called before initscr() so SIGWINCH is blocked before ncurses installs its
+// handler. both signals stay blocked: children that need them unblocked
+// have to reset their mask on spawn.
+int event_loop_init(int input_fd);
+void event_loop_cleanup(void);
+
+// fn runs from event_loop_wait after SIGCHLD, once however many children
+// exited; it is expected to reap with waitpid(..., WNOHANG). NULL to stop.
+void event_loop_on_child(EventSignalFn fn, void *ctx);
+
+// monotonic clock in nanoseconds (counting suspend where the platform can),
+// the time base of every timer deadline
+uint64_t event_loop_now(void);
+
+// arms a timer at an absolute deadline. interval > 0 makes it periodic.
+// returns a timer id, or -1 when all slots are taken.
+int event_loop_timer_start(EventTimerFn fn, void *ctx, uint64_t deadline,
+                           uint64_t interval);
+void event_loop_timer_stop(int id);
+bool event_loop_timer_active(int id);
+
+// true when the input fd has unread bytes right now, never blocks
+bool event_loop_input_pending(void);
+
+// sleeps until input, a resize or the earliest timer deadline. due timers
+// are run before returning. returns a mask of EVENT_* bits.
+int event_loop_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
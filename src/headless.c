@@ -0,0 +1,129 @@
+#include "headless.h"
+#include "event_loop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static struct {
+  SCREEN *screen;
+  FILE *out; // unlinked temp file, emptied after every frame
+  HeadlessStats stats;
+} headless;
+
+SCREEN *headless_init(int rows, int cols, FILE *input) {
+  headless.out = tmpfile();
+  if (!headless.out)
+    return NULL;
+  const char *term = getenv("TERM");
+  headless.screen = newterm(term && term[0] ? term : "xterm", headless.out,
+                            input ? input : stdin);
+  if (!headless.screen) {
+    fclose(headless.out);
+    headless.out = NULL;
+    return NULL;
+  }
+  resize_term(rows, cols);
+  memset(&headless.stats, 0, sizeof(headless.stats));
+  return headless.screen;
+}
+
+void headless_cleanup(void) {
+  if (headless.screen)
+    delscreen(headless.screen);
+  if (headless.out)
+    fclose(headless.out);
+  headless.screen = NULL;
+  headless.out = NULL;
+}
+
+bool headless_active(void) { return headless.screen != NULL; }
+
+// cells where the frame about to be sent differs from what the terminal
+// shows; doupdate's job is exactly these. reading a cell moves the
+// screen's cursor, so both are put back or doupdate would send the move.
+static uint64_t changed_cells(void) {
+  int new_y, new_x, cur_y, cur_x;
+  getyx(newscr, new_y, new_x);
+  getyx(curscr, cur_y, cur_x);
+  uint64_t changed = 0;
+  for (int y = 0; y < LINES; ++y) {
+    for (int x = 0; x < COLS; ++x) {
+      if (mvwinch(newscr, y, x) != mvwinch(curscr, y, x))
+        changed++;
+    }
+  }
+  wmove(newscr, new_y, new_x);
+  wmove(curscr, cur_y, cur_x);
+  return changed;
+}
+
+void headless_update(uint64_t started) {
+  HeadlessStats *s = &headless.stats;
+  uint64_t cells = changed_cells();
+  doupdate();
+  uint64_t elapsed = event_loop_now() - started;
+
+  // ncurses may bypass stdio and write(2) to the fd, so the fd offset is
+  // what counts; the file is emptied again so it never grows
+  fflush(headless.out);
+  int fd = fileno(headless.out);
+  off_t written = lseek(fd, 0, SEEK_CUR);
+  if (written > 0) {
+    if (ftruncate(fd, 0) != 0) {
+      // only the byte count depends on it, and that was taken already
+    }
+    lseek(fd, 0, SEEK_SET);
+    rewind(headless.out);
+  }
+
+  s->frames++;
+  s->last_bytes = written > 0 ? (uint64_t)written : 0;
+  s->last_cells = cells;
+  s->last_render_ns = elapsed;
+  s->bytes += s->last_bytes;
+  s->cells += cells;
+  s->render_ns += elapsed;
+  if (elapsed > s->max_render_ns)
+    s->max_render_ns = elapsed;
+}
+
+const HeadlessStats *headless_stats(void) { return &headless.stats; }
+
+void headless_reset_stats(void) {
+  memset(&headless.stats, 0, sizeof(headless.stats));
+}
+
+// line drawing is stored as the terminal's alternate charset letters
+static char plain(chtype ch) {
+  char c = (char)(ch & A_CHARTEXT);
+  if (!(ch & A_ALTCHARSET))
+    return c;
+  if (c == 'q')
+    return '-';
+  if (c == 'x')
+    return '|';
+  return strchr("lkmjtuvwn", c) ? '+' : c;
+}
+
+int headless_dump(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return 1;
+  char *line = malloc((size_t)COLS + 1);
+  if (!line) {
+    fclose(f);
+    return 1;
+  }
+  for (int y = 0; y < LINES; ++y) {
+    int len = 0;
+    for (int x = 0; x < COLS; ++x) {
+      line[x] = plain(mvwinch(curscr, y, x));
+      if (line[x] != ' ')
+        len = x + 1;
+    }
+    fprintf(f, "%.*s\n", len, line);
+  }
+  free(line);
+  return fclose(f) == 0 ? 0 : 1;
+}
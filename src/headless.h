@@ -0,0 +1,47 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// a terminal with nobody watching: ncurses writes to an anonymous temp file
+// instead of a tty, and every frame is metered on its way out. it catches
+// a module repainting the whole screen, or a change that floods a slow link,
+// without a human looking at the output.
+typedef struct {
+  unsigned long frames;
+  uint64_t bytes;         // everything written to the terminal, escapes included
+  uint64_t cells;         // screen cells doupdate had to change
+  uint64_t render_ns;     // from the start of the frame to the end of doupdate
+  uint64_t max_render_ns;
+  uint64_t last_bytes;
+  uint64_t last_cells;
+  uint64_t last_render_ns;
+} HeadlessStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// newterm on a rows x cols screen, reading keys from input (stdin when
+// NULL). use instead of initscr(); NULL when the terminal can't be set up.
+SCREEN *headless_init(int rows, int cols, FILE *input);
+// after endwin()
+void headless_cleanup(void);
+bool headless_active(void);
+
+// doupdate() for a frame whose rendering began at started (event loop clock)
+void headless_update(uint64_t started);
+const HeadlessStats *headless_stats(void);
+void headless_reset_stats(void);
+
+// the screen as the terminal now shows it, one line of text per row.
+// box and line drawing come out as + - |. returns 0 on success.
+int headless_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
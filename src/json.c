@@ -0,0 +1,229 @@
+#include "json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_MAX_DEPTH 32
+
+void json_init(JsonReader *r, const char *text, size_t len) {
+  r->p = text;
+  r->end = text + len;
+  r->error = false;
+}
+
+static void skip_space(JsonReader *r) {
+  while (r->p < r->end && (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r'))
+    r->p++;
+}
+
+static bool fail(JsonReader *r) {
+  r->error = true;
+  return false;
+}
+
+char json_peek(JsonReader *r) {
+  if (r->error)
+    return 0;
+  skip_space(r);
+  return r->p < r->end ? *r->p : 0;
+}
+
+static bool expect(JsonReader *r, char c) {
+  if (json_peek(r) != c)
+    return fail(r);
+  r->p++;
+  return true;
+}
+
+bool json_begin_object(JsonReader *r) {
+  return expect(r, '{');
+}
+
+bool json_begin_array(JsonReader *r) {
+  return expect(r, '[');
+}
+
+// the separator before the next item, or the closing bracket
+static bool next_item(JsonReader *r, char close) {
+  char c = json_peek(r);
+  if (c == close) {
+    r->p++;
+    return false;
+  }
+  if (c == ',') {
+    r->p++;
+    c = json_peek(r);
+  }
+  if (c == 0 || c == close)
+    return fail(r);
+  return true;
+}
+
+bool json_next_member(JsonReader *r, char *key, size_t key_size) {
+  if (!next_item(r, '}'))
+    return false;
+  return json_read_string(r, key, key_size) && expect(r, ':');
+}
+
+bool json_next_element(JsonReader *r) {
+  return next_item(r, ']');
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// out may be NULL to just step over the string
+bool json_read_string(JsonReader *r, char *out, size_t size) {
+  if (!expect(r, '"'))
+    return false;
+  size_t n = 0;
+  char utf8[4];
+  while (r->p < r->end && *r->p != '"') {
+    int len = 1;
+    utf8[0] = *r->p++;
+    if (utf8[0] == '\\') {
+      if (r->p >= r->end)
+        return fail(r);
+      char e = *r->p++;
+      switch (e) {
+      case 'b': utf8[0] = '\b'; break;
+      case 'f': utf8[0] = '\f'; break;
+      case 'n': utf8[0] = '\n'; break;
+      case 'r': utf8[0] = '\r'; break;
+      case 't': utf8[0] = '\t'; break;
+      case '"': case '\\': case '/': utf8[0] = e; break;
+      case 'u': {
+        if (r->end - r->p < 4)
+          return fail(r);
+        unsigned cp = 0;
+        for (int i = 0; i < 4; i++) {
+          int v = hex_value(r->p[i]);
+          if (v < 0)
+            return fail(r);
+          cp = cp * 16 + (unsigned)v;
+        }
+        r->p += 4;
+        // surrogate pairs aren't worth it for settings; they become '?'
+        if (cp >= 0xd800 && cp <= 0xdfff) {
+          utf8[0] = '?';
+        } else if (cp < 0x80) {
+          utf8[0] = (char)cp;
+        } else if (cp < 0x800) {
+          utf8[0] = (char)(0xc0 | (cp >> 6));
+          utf8[1] = (char)(0x80 | (cp & 0x3f));
+          len = 2;
+        } else {
+          utf8[0] = (char)(0xe0 | (cp >> 12));
+          utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+          utf8[2] = (char)(0x80 | (cp & 0x3f));
+          len = 3;
+        }
+        break;
+      }
+      default:
+        return fail(r);
+      }
+    }
+    for (int i = 0; i < len; i++) {
+      if (out && n + 1 < size)
+        out[n] = utf8[i];
+      n++;
+    }
+  }
+  if (out && size > 0)
+    out[n < size ? n : size - 1] = '\0';
+  return expect(r, '"');
+}
+
+bool json_read_long(JsonReader *r, long *out) {
+  char c = json_peek(r);
+  if (c != '-' && (c < '0' || c > '9'))
+    return fail(r);
+  char buf[32];
+  size_t n = 0;
+  while (r->p < r->end && n + 1 < sizeof(buf) && strchr("+-0123456789.eE", *r->p))
+    buf[n++] = *r->p++;
+  buf[n] = '\0';
+  char *end;
+  double v = strtod(buf, &end);
+  if (*end != '\0')
+    return fail(r);
+  *out = (long)v;
+  return true;
+}
+
+static bool literal(JsonReader *r, const char *word) {
+  size_t len = strlen(word);
+  if ((size_t)(r->end - r->p) < len || memcmp(r->p, word, len) != 0)
+    return fail(r);
+  r->p += len;
+  return true;
+}
+
+bool json_read_bool(JsonReader *r, bool *out) {
+  char c = json_peek(r);
+  *out = c == 't';
+  return c == 't' ? literal(r, "true") : c == 'f' ? literal(r, "false") : fail(r);
+}
+
+static bool skip_value(JsonReader *r, int depth) {
+  if (depth > JSON_MAX_DEPTH)
+    return fail(r);
+  long number;
+  bool flag;
+  switch (json_peek(r)) {
+  case '{':
+    json_begin_object(r);
+    while (json_next_member(r, NULL, 0)) {
+      if (!skip_value(r, depth + 1))
+        return false;
+    }
+    return !r->error;
+  case '[':
+    json_begin_array(r);
+    while (json_next_element(r)) {
+      if (!skip_value(r, depth + 1))
+        return false;
+    }
+    return !r->error;
+  case '"':
+    return json_read_string(r, NULL, 0);
+  case 't': case 'f':
+    return json_read_bool(r, &flag);
+  case 'n':
+    return literal(r, "null");
+  default:
+    return json_read_long(r, &number);
+  }
+}
+
+bool json_skip(JsonReader *r) {
+  return skip_value(r, 0);
+}
+
+char *json_load_file(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+  char *text = NULL;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0)
+    text = malloc((size_t)size + 1);
+  if (text && fread(text, 1, (size_t)size, f) != (size_t)size) {
+    free(text);
+    text = NULL;
+  }
+  fclose(f);
+  if (!text)
+    return NULL;
+  text[size] = '\0';
+  *len = (size_t)size;
+  return text;
+}
@@ -0,0 +1,48 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// just enough JSON to read settings/settings.json: a pull reader over a
+// buffer, no tree and no allocation. callers walk objects and arrays in
+// order and skip what they don't care about. any syntax error sets error
+// and makes every later call fail.
+typedef struct {
+  const char *p;
+  const char *end;
+  bool error;
+} JsonReader;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void json_init(JsonReader *r, const char *text, size_t len);
+
+// the first character of the next value: '{', '[', '"', 't', 'f', 'n',
+// a digit or '-'; 0 at the end or after an error
+char json_peek(JsonReader *r);
+
+// consume '{' or '['
+bool json_begin_object(JsonReader *r);
+bool json_begin_array(JsonReader *r);
+// the next member's key (cut to key_size) and its ':'; false once '}' is
+// consumed. the member's value must be read or skipped before the next call.
+bool json_next_member(JsonReader *r, char *key, size_t key_size);
+// false once ']' is consumed
+bool json_next_element(JsonReader *r);
+
+bool json_read_long(JsonReader *r, long *out);
+bool json_read_bool(JsonReader *r, bool *out);
+bool json_read_string(JsonReader *r, char *out, size_t size);
+bool json_skip(JsonReader *r); // any value, nested ones included
+
+// the whole file, NUL terminated; free() it. NULL when it can't be read.
+char *json_load_file(const char *path, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
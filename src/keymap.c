@@ -0,0 +1,460 @@
+#include "keymap.h"
+#include "event_loop.h"
+#include "json.h"
+#include <ctype.h>
+#include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_BIT 0x8000u // entry is a chord node, not an action
+#define CONTEXT_NAME_LENGTH 32
+
+typedef struct {
+  char context[CONTEXT_NAME_LENGTH]; // module name, "" everywhere
+  InputAction action;
+  int keys[KEYMAP_CHORD_LENGTH + 1]; // 0 terminated
+  bool any_case;                     // letters match either case
+} KeyBinding;
+
+// one step of the trie, flattened into a lookup table over every key code
+typedef struct {
+  uint16_t entry[KEYMAP_KEYS]; // 0 unbound, an InputAction, or NODE_BIT | node
+  uint8_t alone;               // what the keys so far mean if the chord stops here
+  int8_t owner;                // context that may change it in place
+} KeyNode;
+
+// the built-in bindings; settings.json replaces them action by action
+static const KeyBinding defaults[] = {
+    {"", ACTION_UP, {KEY_UP}, false},
+    {"", ACTION_DOWN, {KEY_DOWN}, false},
+    {"", ACTION_LEFT, {KEY_LEFT}, false},
+    {"", ACTION_RIGHT, {KEY_RIGHT}, false},
+    {"", ACTION_CONFIRM, {'\n'}, false},
+    {"", ACTION_CONFIRM, {KEY_ENTER}, false},
+    {"", ACTION_BACK, {'b'}, false},
+    {"", ACTION_EXIT, {'q'}, false},
+    {"", ACTION_CANCEL, {27}, false},
+    {"", ACTION_SEARCH, {'/'}, false},
+    {"", ACTION_PROFILER, {KEY_F(12)}, false},
+
+    {"Tasks", ACTION_EDIT_MODE, {'e', 'i'}, true},
+    {"Tasks", ACTION_ADD_HEAD, {'r', 'u'}, true},
+    {"Tasks", ACTION_ADD_ITEM, {'r', 'i'}, true},
+    {"Tasks", ACTION_JUMP, {'g'}, true},
+    {"Tasks", ACTION_MOVE_MODE, {'s'}, true},
+    {"Tasks", ACTION_DELETE, {'x'}, true},
+    {"Tasks", ACTION_RENAME, {'n'}, true},
+    {"Tasks", ACTION_TOGGLE, {' '}, false},
+    {"Tasks", ACTION_UNDO, {'u'}, false},
+    {"Tasks", ACTION_REDO, {18}, false}, // ctrl-r
+
+    {"Habits", ACTION_EDIT_MODE, {'e', 'i'}, true},
+    {"Habits", ACTION_ADD_HEAD, {'r', 'u'}, true},
+    {"Habits", ACTION_ADD_ITEM, {'r', 'i'}, true},
+    {"Habits", ACTION_JUMP, {'g'}, true},
+    {"Habits", ACTION_MOVE_MODE, {'s'}, true},
+    {"Habits", ACTION_DELETE, {'d'}, true},
+    {"Habits", ACTION_RENAME, {'n'}, true},
+    {"Habits", ACTION_TOGGLE, {' '}, false},
+    {"Habits", ACTION_UNDO, {'u'}, false},
+    {"Habits", ACTION_REDO, {18}, false},
+
+    {"Pomodoro", ACTION_EDIT_WORK, {'i'}, false},
+    {"Pomodoro", ACTION_EDIT_REST, {'o'}, false},
+    {"Pomodoro", ACTION_TOGGLE, {' '}, false},
+    {"Pomodoro", ACTION_RESET, {'r'}, false},
+    {"Pomodoro", ACTION_CYCLE_MODE, {'m'}, false},
+};
+
+// names in settings.json
+static const char *action_names[ACTION_COUNT] = {
+    [ACTION_UP] = "navigate_up",
+    [ACTION_DOWN] = "navigate_down",
+    [ACTION_LEFT] = "navigate_left",
+    [ACTION_RIGHT] = "navigate_right",
+    [ACTION_CONFIRM] = "confirm",
+    [ACTION_BACK] = "back_cancel",
+    [ACTION_EXIT] = "exit_app",
+    [ACTION_CANCEL] = "cancel",
+    [ACTION_SEARCH] = "search",
+    [ACTION_PROFILER] = "profiler",
+    [ACTION_TOGGLE] = "toggle",
+    [ACTION_EDIT_MODE] = "edit_mode",
+    [ACTION_ADD_HEAD] = "add_head",
+    [ACTION_ADD_ITEM] = "add_item",
+    [ACTION_JUMP] = "jump",
+    [ACTION_MOVE_MODE] = "move_mode",
+    [ACTION_DELETE] = "delete",
+    [ACTION_RENAME] = "rename",
+    [ACTION_RESET] = "reset",
+    [ACTION_CYCLE_MODE] = "cycle_mode",
+    [ACTION_EDIT_WORK] = "edit_work",
+    [ACTION_EDIT_REST] = "edit_rest",
+    [ACTION_UNDO] = "undo",
+    [ACTION_REDO] = "redo",
+};
+
+static KeyBinding bindings[KEYMAP_MAX_BINDINGS];
+static int binding_count;
+
+static struct {
+  char name[CONTEXT_NAME_LENGTH];
+  int root;
+} contexts[KEYMAP_MAX_CONTEXTS];
+static int context_count; // 0 until compiled; contexts[0] is the global one
+
+static KeyNode *nodes;
+static int node_count;
+static int node_capacity;
+
+static struct {
+  int pending;  // chord node waiting for its next key, -1 when none
+  int last_key; // the key that got there
+  int timer;
+  uint64_t timeout;
+  KeymapFn fn;
+  void *ctx;
+} chord = {.pending = -1, .timer = -1, .timeout = KEYMAP_CHORD_MS * NSEC_PER_MSEC};
+
+// --- Compiling ---
+
+static int new_node(int owner, int copy_of) {
+  if (node_count == node_capacity) {
+    int capacity = node_capacity ? node_capacity * 2 : 16;
+    KeyNode *grown = realloc(nodes, (size_t)capacity * sizeof(KeyNode));
+    if (!grown)
+      return -1;
+    nodes = grown;
+    node_capacity = capacity;
+  }
+  KeyNode *n = &nodes[node_count];
+  if (copy_of >= 0)
+    *n = nodes[copy_of];
+  else
+    memset(n, 0, sizeof(*n));
+  n->owner = (int8_t)owner;
+  return node_count++;
+}
+
+// the node an entry leads to, copied first when another context owns it
+static int own_child(int node, int key, int owner) {
+  uint16_t e = nodes[node].entry[key];
+  int child;
+  if (e & NODE_BIT) {
+    child = e & ~NODE_BIT;
+    if (nodes[child].owner == owner)
+      return child;
+    child = new_node(owner, child);
+  } else {
+    child = new_node(owner, -1);
+    if (child >= 0)
+      nodes[child].alone = (uint8_t)e; // a shorter binding still works on its own
+  }
+  if (child >= 0)
+    nodes[node].entry[key] = (uint16_t)(NODE_BIT | child);
+  return child;
+}
+
+static void insert(int node, const int *keys, InputAction action, int owner) {
+  for (; keys[0] != 0; keys++) {
+    if (keys[0] < 0 || keys[0] >= KEYMAP_KEYS)
+      return;
+    if (keys[1] == 0) {
+      uint16_t e = nodes[node].entry[keys[0]];
+      if (e & NODE_BIT) {
+        int child = own_child(node, keys[0], owner);
+        if (child >= 0)
+          nodes[child].alone = (uint8_t)action;
+      } else {
+        nodes[node].entry[keys[0]] = (uint16_t)action;
+      }
+      return;
+    }
+    node = own_child(node, keys[0], owner);
+    if (node < 0)
+      return;
+  }
+}
+
+// every mix of upper and lower case letters from position i on
+static void insert_cases(int root, int *keys, int i, InputAction action, int owner) {
+  if (keys[i] == 0) {
+    insert(root, keys, action, owner);
+    return;
+  }
+  int key = keys[i];
+  insert_cases(root, keys, i + 1, action, owner);
+  if (key < 128 && isalpha(key) && toupper(key) != key) {
+    keys[i] = toupper(key);
+    insert_cases(root, keys, i + 1, action, owner);
+    keys[i] = key;
+  }
+}
+
+static int find_context(const char *name) {
+  for (int i = 1; i < context_count; i++) {
+    if (strcmp(contexts[i].name, name) == 0)
+      return i;
+  }
+  return 0;
+}
+
+static void insert_binding(int c, const KeyBinding *b) {
+  int keys[KEYMAP_CHORD_LENGTH + 1];
+  memcpy(keys, b->keys, sizeof(keys));
+  if (b->any_case)
+    insert_cases(contexts[c].root, keys, 0, b->action, c);
+  else
+    insert(contexts[c].root, keys, b->action, c);
+}
+
+static void compile(void) {
+  keymap_cancel();
+  node_count = 0;
+  context_count = 1;
+  contexts[0].name[0] = '\0';
+  contexts[0].root = new_node(0, -1);
+  if (contexts[0].root < 0) {
+    context_count = 0;
+    return;
+  }
+  for (int i = 0; i < binding_count; i++) {
+    if (bindings[i].context[0] == '\0')
+      insert_binding(0, &bindings[i]);
+  }
+  // a module starts from the global table, then its own bindings win
+  for (int i = 0; i < binding_count; i++) {
+    const KeyBinding *b = &bindings[i];
+    if (b->context[0] == '\0')
+      continue;
+    int c = find_context(b->context);
+    if (c == 0) {
+      if (context_count == KEYMAP_MAX_CONTEXTS)
+        continue;
+      int root = new_node(context_count, contexts[0].root);
+      if (root < 0)
+        continue;
+      c = context_count++;
+      memcpy(contexts[c].name, b->context, CONTEXT_NAME_LENGTH);
+      contexts[c].root = root;
+    }
+    insert_binding(c, b);
+  }
+}
+
+static void load_defaults(void) {
+  binding_count = (int)(sizeof(defaults) / sizeof(defaults[0]));
+  memcpy(bindings, defaults, sizeof(defaults));
+}
+
+// --- settings.json ---
+
+static InputAction action_named(const char *name) {
+  for (int a = 1; a < ACTION_COUNT; a++) {
+    if (action_names[a] && strcmp(action_names[a], name) == 0)
+      return (InputAction)a;
+  }
+  return ACTION_NONE;
+}
+
+// a key code, or an array of them for a chord
+static bool read_keys(JsonReader *r, int *keys) {
+  memset(keys, 0, (KEYMAP_CHORD_LENGTH + 1) * sizeof(int));
+  long key;
+  if (json_peek(r) != '[')
+    return json_read_long(r, &key) && (keys[0] = (int)key, true);
+  json_begin_array(r);
+  int n = 0;
+  while (json_next_element(r)) {
+    if (!json_read_long(r, &key))
+      return false;
+    if (n < KEYMAP_CHORD_LENGTH)
+      keys[n++] = (int)key;
+  }
+  return !r->error;
+}
+
+// member "[Module.]action": one sequence, or an array of them
+static bool rebind(JsonReader *r, const char *name) {
+  char context[CONTEXT_NAME_LENGTH] = "";
+  const char *dot = strrchr(name, '.');
+  if (dot) {
+    snprintf(context, sizeof(context), "%.*s", (int)(dot - name), name);
+    name = dot + 1;
+  }
+  InputAction action = action_named(name);
+  if (action == ACTION_NONE)
+    return json_skip(r); // someone else's setting, or a future one
+
+  // the new keys go wherever the old ones were
+  char where[KEYMAP_MAX_CONTEXTS][CONTEXT_NAME_LENGTH];
+  int where_count = 0;
+  if (dot) {
+    snprintf(where[where_count++], CONTEXT_NAME_LENGTH, "%s", context);
+  }
+  int kept = 0;
+  for (int i = 0; i < binding_count; i++) {
+    KeyBinding *b = &bindings[i];
+    if (b->action != action || (dot && strcmp(b->context, context) != 0)) {
+      bindings[kept++] = *b;
+      continue;
+    }
+    bool seen = false;
+    for (int w = 0; w < where_count; w++)
+      seen |= strcmp(where[w], b->context) == 0;
+    if (!seen && where_count < KEYMAP_MAX_CONTEXTS)
+      memcpy(where[where_count++], b->context, CONTEXT_NAME_LENGTH);
+  }
+  binding_count = kept;
+  if (where_count == 0)
+    where[where_count++][0] = '\0';
+
+  int sequences[KEYMAP_CHORD_LENGTH][KEYMAP_CHORD_LENGTH + 1];
+  int count = 0;
+  if (json_peek(r) == '[') {
+    json_begin_array(r);
+    while (json_next_element(r)) {
+      int keys[KEYMAP_CHORD_LENGTH + 1];
+      if (!read_keys(r, keys))
+        return false;
+      if (count < KEYMAP_CHORD_LENGTH)
+        memcpy(sequences[count++], keys, sizeof(keys));
+    }
+    if (r->error)
+      return false;
+  } else if (read_keys(r, sequences[0])) {
+    count = 1;
+  } else {
+    return false;
+  }
+
+  for (int w = 0; w < where_count; w++) {
+    for (int s = 0; s < count && binding_count < KEYMAP_MAX_BINDINGS; s++) {
+      KeyBinding *b = &bindings[binding_count++];
+      memcpy(b->context, where[w], CONTEXT_NAME_LENGTH);
+      b->action = action;
+      memcpy(b->keys, sequences[s], sizeof(b->keys));
+      b->any_case = false;
+    }
+  }
+  return true;
+}
+
+static bool read_settings(JsonReader *r) {
+  char key[64];
+  if (!json_begin_object(r))
+    return false;
+  while (json_next_member(r, key, sizeof(key))) {
+    if (strcmp(key, "keybindings") != 0) {
+      if (!json_skip(r))
+        return false;
+      continue;
+    }
+    if (!json_begin_object(r))
+      return false;
+    char name[64];
+    while (json_next_member(r, name, sizeof(name))) {
+      if (!rebind(r, name))
+        return false;
+    }
+  }
+  return !r->error;
+}
+
+int keymap_load(const char *path) {
+  load_defaults();
+  size_t len;
+  char *text = json_load_file(path, &len);
+  int result = 1;
+  if (text) {
+    JsonReader r;
+    json_init(&r, text, len);
+    result = read_settings(&r) ? 0 : -1;
+    if (result != 0)
+      load_defaults(); // half a file is worse than none
+    free(text);
+  }
+  compile();
+  return result;
+}
+
+void keymap_set_chord_timeout(uint64_t ns) {
+  chord.timeout = ns;
+}
+
+void keymap_set_handler(KeymapFn fn, void *ctx) {
+  chord.fn = fn;
+  chord.ctx = ctx;
+}
+
+// --- Dispatch ---
+
+static void emit(InputAction action, int key) {
+  if (chord.fn)
+    chord.fn(action, key, chord.ctx);
+}
+
+static void chord_timeout_cb(void *ctx) {
+  (void)ctx;
+  chord.timer = -1;
+  int node = chord.pending;
+  chord.pending = -1;
+  if (node >= 0 && nodes[node].alone)
+    emit((InputAction)nodes[node].alone, chord.last_key);
+}
+
+static void step(uint16_t entry, int key) {
+  if (entry & NODE_BIT) {
+    chord.pending = entry & ~NODE_BIT;
+    chord.last_key = key;
+    chord.timer = event_loop_timer_start(chord_timeout_cb, NULL, event_loop_now() + chord.timeout, 0);
+  } else {
+    emit((InputAction)entry, key);
+  }
+}
+
+void keymap_feed(const char *context, int key) {
+  if (context_count == 0) {
+    load_defaults();
+    compile();
+    if (context_count == 0)
+      return;
+  }
+  bool known = key >= 0 && key < KEYMAP_KEYS;
+  if (chord.pending >= 0) {
+    int node = chord.pending;
+    int last_key = chord.last_key;
+    keymap_cancel();
+    uint16_t e = known ? nodes[node].entry[key] : 0;
+    if (e) {
+      step(e, key);
+      return;
+    }
+    // the chord stops short: the keys so far count for what they are,
+    // then this one starts over
+    if (nodes[node].alone)
+      emit((InputAction)nodes[node].alone, last_key);
+  }
+  int root = contexts[context ? find_context(context) : 0].root;
+  uint16_t e = known ? nodes[root].entry[key] : 0;
+  if (e)
+    step(e, key);
+  else
+    emit(ACTION_NONE, key);
+}
+
+void keymap_cancel(void) {
+  event_loop_timer_stop(chord.timer);
+  chord.timer = -1;
+  chord.pending = -1;
+}
+
+void keymap_cleanup(void) {
+  keymap_cancel();
+  free(nodes);
+  nodes = NULL;
+  node_count = 0;
+  node_capacity = 0;
+  context_count = 0;
+}
@@ -0,0 +1,46 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <stdint.h>
+#include "../modules/imodule.h"
+
+#define KEYMAP_KEYS 512          // ncurses key codes end at KEY_MAX (0777)
+#define KEYMAP_CHORD_LENGTH 4
+#define KEYMAP_MAX_BINDINGS 128
+#define KEYMAP_MAX_CONTEXTS 8
+#define KEYMAP_CHORD_MS 1000     // default wait for a chord's next key
+
+typedef void (*KeymapFn)(InputAction action, int key, void *ctx);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// builds the keymap from the built-in bindings plus the "keybindings"
+// object of settings.json. each member names an action and replaces its
+// default keys: "exit_app": 113 is one key, "confirm": [10, 343] gives a
+// choice of keys and "edit_mode": [[101, 105]] is a chord. "Tasks.delete"
+// rebinds an action inside one module only. returns 0 when the file was
+// used, 1 when there is none and -1 when it doesn't parse; the defaults
+// are in effect either way.
+int keymap_load(const char *path);
+void keymap_set_chord_timeout(uint64_t ns);
+// where resolved actions go
+void keymap_set_handler(KeymapFn fn, void *ctx);
+
+// resolves one key in the bindings of context (a module name, NULL for the
+// panel; a module without bindings of its own gets the global ones). keys
+// are looked up in one table per chord step, never searched. a key that
+// starts a chord is held; the chord ends when a key completes it, when a
+// key doesn't continue it (that key then counts on its own) or when an
+// event loop timer runs out, so nothing ever blocks waiting for input.
+void keymap_feed(const char *context, int key);
+// drops a half typed chord
+void keymap_cancel(void);
+void keymap_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,93 +1,197 @@
 #include <ncurses.h>
 #include <locale.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
-#include <time.h>
 #include <string.h>
+#include <unistd.h>
 #include "../modules/habit_manager.h"
+#include "../modules/persist.h"
 #include "../modules/task_manager.h"
+#include "config.h"
+#include "event_loop.h"
+#include "headless.h"
+#include "keymap.h"
 #include "minimal_tui.h"
+#include "profiler.h"
 
 #define SETTINGS_FILE "data/settings.conf"
+#define SETTINGS_JSON "settings/settings.json"
+
+// SIGWINCH arrives through the event loop, so ncurses never sees it and we
+// have to pick up the new size ourselves
+static void handle_resize(MinimalTui* tui) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        // resize_term rather than resizeterm, which would also queue a KEY_RESIZE
+        resize_term(ws.ws_row, ws.ws_col);
+        clearok(curscr, TRUE);
+    }
+    minimal_tui_resize(tui);
+    werase(stdscr);
+    wnoutrefresh(stdscr);
+}
+
+static void print_save_stats(const char* label, const PersistStats* s) {
+    if (s->count == 0) return;
+    fprintf(stderr, "%s: %lu, avg %.2f ms, max %.2f ms\n", label, s->count,
+            s->total_ns / 1e6 / s->count, s->max_ns / 1e6);
+}
+
+static void print_headless_stats(const HeadlessStats* s) {
+    if (s->frames == 0) return;
+    fprintf(stderr, "headless: %lu frames, %llu bytes (%.0f per frame), %llu cells changed (%.0f per frame), "
+            "render avg %.3f ms, max %.3f ms\n",
+            s->frames, (unsigned long long)s->bytes, (double)s->bytes / s->frames,
+            (unsigned long long)s->cells, (double)s->cells / s->frames,
+            s->render_ns / 1e6 / s->frames, s->max_render_ns / 1e6);
+}
 
 int main() {
     setlocale(LC_ALL, "");
-    initscr();
+    if (event_loop_init(STDIN_FILENO) != 0) {
+        fprintf(stderr, "Error setting up the event loop.\n");
+        return 1;
+    }
+
+    // ZINC_HEADLESS=ROWSxCOLS: keys come from stdin (a file or a pipe), the
+    // frames go nowhere but are metered, and the run ends with the input
+    int rows, cols;
+    const char* headless = getenv("ZINC_HEADLESS");
+    bool is_headless = headless && sscanf(headless, "%dx%d", &rows, &cols) == 2 && rows > 0 && cols > 0;
+    if (is_headless) {
+        if (!headless_init(rows, cols, NULL)) {
+            fprintf(stderr, "Error setting up the headless terminal.\n");
+            return 1;
+        }
+    } else {
+        initscr();
+    }
     cbreak();
     noecho();
     keypad(stdscr, TRUE);
     curs_set(0);
-    timeout(100);
 
     mkdir("data", 0755);
 
-    if (habits_load("data/habits.csv") != 0) {
-        habits_init();
-    }
-    if (tasks_load("data/tasks.csv") != 0) {
-        tasks_init();
-    }
+    config_load(SETTINGS_FILE);
+    persist_set_policy(persist_parse_policy(config_get("fsync_policy")));
+    // a missing or broken settings.json leaves the built-in keys
+    keymap_load(SETTINGS_JSON);
+    keymap_set_chord_timeout((uint64_t)config_get_long("chord_timeout_ms", KEYMAP_CHORD_MS) * NSEC_PER_MSEC);
 
-    // handle daily updates
-    time_t now = time(NULL);
-    struct tm *tm_now = localtime(&now);
-    char today_str[11];
-    strftime(today_str, sizeof(today_str), "%Y-%m-%d", tm_now);
-
-    char last_update_str[11] = {0};
-    FILE* f = fopen(SETTINGS_FILE, "r");
-    if (f) {
-        char line[256];
-        while (fgets(line, sizeof(line), f)) {
-            char key[64];
-            char value[128];
-            if (sscanf(line, "%63[^=]=%127s", key, value) == 2) {
-                if (strcmp(key, "last_update") == 0) {
-                    strncpy(last_update_str, value, sizeof(last_update_str) - 1);
-                    break;
-                }
-            }
-        }
-        fclose(f);
-    }
+    // modules load their data when first opened, or right after the first
+    // frame unless preload_modules=0; disabled ones never do
+    minimal_tui_load_activity(SETTINGS_JSON);
 
-    if (strcmp(today_str, last_update_str) != 0) {
-        habits_daily_update();
-        habits_save("data/habits.csv");
-        tasks_save("data/tasks.csv");
-
-        FILE* f_write = fopen(SETTINGS_FILE, "w");
-        if (f_write) {
-            fprintf(f_write, "last_update=%s\n", today_str);
-            fclose(f_write);
-        }
-    }
+    // no daily reset: a new day is just an unmarked bit in every habit's history
 
     MinimalTui tui;
     minimal_tui_init(&tui);
+    tui.preload = config_get_long("preload_modules", 1) != 0;
+    long budget_kb = config_get_long("memory_budget_kb", 0);
+    tui.memory_budget = budget_kb > 0 ? (size_t)budget_kb * 1024 : 0;
+
+    minimal_tui_render(&tui);
 
     int ch;
     while (minimal_tui_is_running(&tui)) {
-        ch = getch();
+        // sleeps until a key, a resize or a timer is due; nothing runs while idle
+        int events = event_loop_wait();
+        uint64_t woke = event_loop_now();
+        profiler_wakeup(woke);
+        bool input_ended = false;
+
+        if (events & EVENT_RESIZE) {
+            handle_resize(&tui);
+        }
+        if (events & EVENT_INPUT) {
+            // the tty is readable, so getch won't block; keep going while more
+            // keys are already waiting so a burst costs a single render.
+            // headless runs take one key per frame, that is what they measure.
+            // a chord's next key is just another wakeup, nothing waits for it.
+            timeout(0);
+            do {
+                ch = getch();
+                if (ch == ERR) {
+                    input_ended = is_headless; // readable yet empty: end of the script
+                    break;
+                }
 
-        if (ch == KEY_RESIZE) {
-            minimal_tui_resize(&tui);
-        } else if (ch != ERR) {
-            minimal_tui_handle_input(&tui, ch);
+                if (ch == KEY_RESIZE) {
+                    minimal_tui_resize(&tui);
+                } else {
+                    minimal_tui_handle_input(&tui, ch);
+                }
+            } while (!is_headless && minimal_tui_is_running(&tui) && event_loop_input_pending());
         }
 
+        // a no-op unless something was invalidated. keys that changed
+        // nothing on screen have no latency to speak of
+        unsigned long frames = tui.frames_rendered;
         minimal_tui_render(&tui);
+        if ((events & EVENT_INPUT) && tui.frames_rendered != frames) {
+            profiler_record(PROFILE_INPUT_LATENCY, event_loop_now() - woke);
+        }
+
+        // only once the keys still buffered have been handled and drawn; a
+        // pipe reports the hangup while a headless script is still in it
+        bool drained = !is_headless || !event_loop_input_pending();
+        if (((events & EVENT_HANGUP) && drained) || input_ended) {
+            break;
+        }
     }
 
+    const char* dump = getenv("ZINC_SCREEN_DUMP");
+    if (is_headless && dump && headless_dump(dump) != 0) {
+        fprintf(stderr, "Error writing the screen dump.\n");
+    }
     minimal_tui_cleanup(&tui);
     endwin();
+    if (is_headless) {
+        print_headless_stats(headless_stats());
+        headless_cleanup();
+    }
+    event_loop_cleanup();
 
-    if (habits_save("data/habits.csv") != 0) {
+    // the final saves honour the on-exit fsync policy
+    persist_set_exiting(true);
+    if (habits_close() != 0) {
         fprintf(stderr, "Error saving habits.\n");
     }
-    if (tasks_save("data/tasks.csv") != 0) {
+    if (tasks_close() != 0) {
         fprintf(stderr, "Error saving tasks.\n");
     }
 
+    if (getenv("ZINC_STATS")) {
+        fprintf(stderr, "frames rendered: %lu, skipped: %lu\n",
+                tui.frames_rendered, tui.frames_skipped);
+        print_save_stats("snapshot saves", persist_stats(PERSIST_STAT_SNAPSHOT));
+        print_save_stats("journal appends", persist_stats(PERSIST_STAT_JOURNAL));
+        fprintf(stderr, "fsync policy: %s\n", persist_policy_name(persist_policy()));
+        size_t used, reserved;
+        habits_string_usage(&used, &reserved);
+        fprintf(stderr, "habit strings: %zu bytes used, %zu reserved\n", used, reserved);
+        tasks_string_usage(&used, &reserved);
+        fprintf(stderr, "task strings: %zu bytes used, %zu reserved\n", used, reserved);
+        for (int i = 0; i < tui.module_count; ++i) {
+            IModule* mod = tui.modules[i];
+            if (mod->memory_usage) {
+                fprintf(stderr, "%s memory: %zu bytes\n", mod->name, mod->memory_usage(mod));
+            }
+        }
+    }
+
+    // after the final saves, so they are in it
+    const char* profile = getenv("ZINC_PROFILE");
+    if (profile && profiler_dump(profile) != 0) {
+        fprintf(stderr, "Error writing the profile.\n");
+    }
+
+    habits_cleanup();
+    tasks_cleanup();
+    keymap_cleanup();
+
     return 0;
 }
@@ -2,27 +2,167 @@
 #include "../modules/habit_manager.h" // needed for habit functions
 #include "../modules/task_manager.h"
 #include "../modules/pomodoro_manager.h"
+#include "../modules/analytics.h"
+#include "day_clock.h"
+#include "event_loop.h"
+#include "headless.h"
+#include "json.h"
+#include "keymap.h"
+#include "notify.h"
+#include "palette.h"
+#include "profiler.h"
 #include <ncurses.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 // forward declarations for placeholder module functions
 void placeholder_render(IModule *self, WINDOW *win);
-void placeholder_handle_input(IModule *self, int ch, MinimalTui *tui);
+void placeholder_handle_input(IModule *self, InputAction action, int key, MinimalTui *tui);
 
 // module definitions
-static IModule module_habits = {"Habits", habits_module_render, habits_module_handle_input, NULL};
-static IModule module_tasks = {"Tasks", tasks_module_render, tasks_module_handle_input, NULL};
-static IModule module_pomodoro = {"Pomodoro", pomodoro_module_render, pomodoro_module_handle_input, NULL};
-static IModule module_settings = {"Settings", placeholder_render, placeholder_handle_input, NULL};
-
-static IModule *all_modules[] = {
-    &module_habits, &module_tasks, &module_pomodoro,
-    &module_settings,
+static IModule module_habits = {
+    .name = "Habits",
+    .render = habits_module_render,
+    .handle_input = habits_module_handle_input,
+    .on_leave = habits_module_leave,
+    .on_idle = habits_module_idle,
+    .memory_usage = habits_module_memory,
+    .takes_text = habits_module_takes_text,
 };
-static const int NUM_MODULES_IMPL =
-    sizeof(all_modules) / sizeof(all_modules[0]);
+static IModule module_tasks = {
+    .name = "Tasks",
+    .render = tasks_module_render,
+    .handle_input = tasks_module_handle_input,
+    .on_leave = tasks_module_leave,
+    .on_idle = tasks_module_idle,
+    .memory_usage = tasks_module_memory,
+    .takes_text = tasks_module_takes_text,
+};
+static IModule module_pomodoro = {
+    .name = "Pomodoro",
+    .render = pomodoro_module_render,
+    .handle_input = pomodoro_module_handle_input,
+    .tick = pomodoro_module_tick,
+    .memory_usage = pomodoro_module_memory, // the session log, analytics included
+};
+// analytics owns no memory: it renders straight from the pomodoro session
+// log, which loads and unloads with pomodoro and is counted there
+static IModule module_analytics = {
+    .name = "Time Analytics",
+    .render = analytics_module_render,
+    .handle_input = analytics_module_handle_input,
+};
+static IModule module_settings = {
+    .name = "Settings",
+    .render = placeholder_render,
+    .handle_input = placeholder_handle_input,
+};
+
+#define HABITS_FILE "data/habits.csv"
+#define MODULE_IDLE_NS (60 * NSEC_PER_SEC) // quiet time before on_idle
+#define TASKS_FILE "data/tasks.csv"
+
+// a missing snapshot just means starting empty (plus whatever the journal
+// recorded since)
+static void activate_habits(void) {
+  if (!habits_is_loaded())
+    habits_load(HABITS_FILE);
+}
+
+static void activate_tasks(void) {
+  if (!tasks_is_loaded())
+    tasks_load(TASKS_FILE);
+}
+
+// the analytics read the pomodoro's session log, so they share this
+static void activate_pomodoro(void) {
+  if (!pomodoro_is_active())
+    pomodoro_init();
+}
+
+// every edit is in the journal by now, so all that close might still write
+// is a compacted snapshot. if that fails the data stays where it is.
+static void deactivate_habits(void) {
+  if (habits_is_loaded() && habits_close() == 0)
+    habits_cleanup();
+}
+
+static void deactivate_tasks(void) {
+  if (tasks_is_loaded() && tasks_close() == 0)
+    tasks_cleanup();
+}
+
+typedef struct {
+  IModule *module;
+  void (*activate)(void);   // loads its data, once; NULL when it has none
+  void (*deactivate)(void); // unloads it again; NULL when it can't be
+  bool disabled;            // by module_activity
+} ModuleEntry;
+
+// the pomodoro stays: its session log is small and unloading it would cut
+// a paused session short
+static ModuleEntry registry[] = {
+    {&module_habits, activate_habits, deactivate_habits, false},
+    {&module_tasks, activate_tasks, deactivate_tasks, false},
+    {&module_pomodoro, activate_pomodoro, NULL, false},
+    {&module_analytics, activate_pomodoro, NULL, false},
+    {&module_settings, NULL, NULL, false},
+};
+static const int REGISTRY_SIZE = sizeof(registry) / sizeof(registry[0]);
+
+static ModuleEntry *registry_find(const char *name) {
+  for (int i = 0; i < REGISTRY_SIZE; ++i) {
+    if (strcmp(registry[i].module->name, name) == 0)
+      return &registry[i];
+  }
+  return NULL;
+}
+
+// names the file has that aren't modules here (yet) are ignored
+static bool read_activity(JsonReader *r) {
+  char key[64];
+  if (!json_begin_object(r))
+    return false;
+  while (json_next_member(r, key, sizeof(key))) {
+    if (strcmp(key, "module_activity") != 0) {
+      if (!json_skip(r))
+        return false;
+      continue;
+    }
+    if (!json_begin_object(r))
+      return false;
+    char name[64];
+    while (json_next_member(r, name, sizeof(name))) {
+      ModuleEntry *entry = registry_find(name);
+      bool enabled;
+      if (!entry || (json_peek(r) != 't' && json_peek(r) != 'f')) {
+        if (!json_skip(r))
+          return false;
+      } else if (json_read_bool(r, &enabled)) {
+        entry->disabled = !enabled;
+      }
+    }
+  }
+  return !r->error;
+}
+
+int minimal_tui_load_activity(const char *path) {
+  size_t len;
+  char *text = json_load_file(path, &len);
+  if (!text)
+    return 1;
+  JsonReader r;
+  json_init(&r, text, len);
+  int result = read_activity(&r) ? 0 : -1;
+  if (result != 0) {
+    for (int i = 0; i < REGISTRY_SIZE; ++i)
+      registry[i].disabled = false;
+  }
+  free(text);
+  return result;
+}
 
 static void wm_init(WindowManager *wm, int rows, int cols) {
   wm->rows = rows;
@@ -38,15 +178,174 @@ static void wm_cleanup(WindowManager *wm) {
     delwin(wm->status_win);
 }
 
-static void draw_panel(WindowManager *wm, int selected) {
+static void sync_tick_timer(MinimalTui *tui);
+static void dispatch_action(InputAction action, int key, void *ctx);
+
+static void tick_cb(void *ctx) {
+  MinimalTui *tui = ctx;
+  tui->tick_timer = -1;
+  long logged = pomodoro_session_log()->record_count;
+  sync_tick_timer(tui);
+  if (pomodoro_session_log()->record_count != logged)
+    imodule_invalidate(&module_analytics);
+  tui->status_dirty = true;
+}
+
+// ticks every module that has a tick and sets one one-shot wakeup for the
+// earliest deadline they return, whatever screen is up
+static void sync_tick_timer(MinimalTui *tui) {
+  event_loop_timer_stop(tui->tick_timer);
+  tui->tick_timer = -1;
+  uint64_t now = event_loop_now();
+  uint64_t earliest = 0;
+  for (int i = 0; i < tui->module_count; ++i) {
+    IModule *mod = tui->modules[i];
+    if (!mod->tick)
+      continue;
+    mod->next_tick = mod->tick(mod, now);
+    if (mod->next_tick && (!earliest || mod->next_tick < earliest))
+      earliest = mod->next_tick;
+  }
+  if (earliest)
+    tui->tick_timer = event_loop_timer_start(tick_cb, tui, earliest, 0);
+}
+
+static void idle_cb(void *ctx) {
+  MinimalTui *tui = ctx;
+  tui->idle_timer = -1;
+  for (int i = 0; i < tui->module_count; ++i) {
+    IModule *mod = tui->modules[i];
+    if (mod->on_idle)
+      mod->on_idle(mod);
+  }
+}
+
+// every key pushes the idle hooks back
+static void restart_idle_timer(MinimalTui *tui) {
+  event_loop_timer_stop(tui->idle_timer);
+  tui->idle_timer = event_loop_timer_start(idle_cb, tui, event_loop_now() + MODULE_IDLE_NS, 0);
+}
+
+static void status_changed_cb(void *ctx) {
+  ((MinimalTui *)ctx)->status_dirty = true;
+}
+
+// the panel is already up by the time this runs; it loads one module per
+// wakeup so a key pressed meanwhile waits for one load at most
+static void preload_cb(void *ctx) {
+  MinimalTui *tui = ctx;
+  tui->preload_timer = -1;
+  if (tui->preload_next >= tui->module_count)
+    return;
+  minimal_tui_activate(tui, tui->preload_next++);
+  tui->status_dirty = true; // a restored pomodoro shows up in the status bar
+  sync_tick_timer(tui);
+  if (tui->preload_next < tui->module_count)
+    tui->preload_timer = event_loop_timer_start(preload_cb, tui, event_loop_now(), 0);
+}
+
+// the overlay's own refresh is one of the wakeups it counts
+static void toggle_profiler(MinimalTui *tui) {
+  tui->profiler_overlay = !tui->profiler_overlay;
+  event_loop_timer_stop(tui->profiler_timer);
+  tui->profiler_timer = -1;
+  if (tui->profiler_overlay)
+    tui->profiler_timer = event_loop_timer_start(status_changed_cb, tui,
+                                                 event_loop_now() + NSEC_PER_SEC, NSEC_PER_SEC);
+  tui->status_dirty = true;
+}
+
+// local midnight passed (maybe several of them). no module stores anything
+// per day beyond the habit histories, so nothing is saved here; only the
+// views that show "today" are repainted.
+static void day_changed_cb(int day, void *ctx) {
+  (void)ctx;
+  if (habits_set_today(day))
+    imodule_invalidate(&module_habits);
+  imodule_invalidate(&module_analytics); // "today" and "this week" moved
+}
+
+// --- Memory ---
+
+static size_t window_cells(WINDOW *win) {
+  return win ? (size_t)getmaxy(win) * (size_t)getmaxx(win) : 0;
+}
+
+// an estimate: a chtype per cell of our windows and of the screens curses
+// diffs frames against. ncurses' own per-line bookkeeping isn't visible from
+// here, so the status bar marks the total with "~".
+static size_t windows_memory(const WindowManager *wm) {
+  size_t cells = window_cells(wm->panel_win) + window_cells(wm->status_win) +
+                 window_cells(stdscr) + window_cells(curscr) + window_cells(newscr);
+  return cells * sizeof(chtype);
+}
+
+size_t minimal_tui_memory_usage(const MinimalTui *tui) {
+  size_t total = windows_memory(&tui->wm);
+  for (int i = 0; i < tui->module_count; ++i) {
+    const IModule *mod = tui->modules[i];
+    if (mod->memory_usage)
+      total += mod->memory_usage(mod);
+  }
+  return total;
+}
+
+static size_t entry_memory(const ModuleEntry *entry) {
+  const IModule *mod = entry->module;
+  return mod->memory_usage ? mod->memory_usage(mod) : 0;
+}
+
+// runs once each time the budget is crossed, never under an open palette:
+// its searches use the caches and its results point into the modules.
+// caches go first, from every module but the one on screen. if that isn't
+// enough, modules that aren't on screen are unloaded, biggest first, and
+// load again when opened. whatever is left over stays over budget until
+// usage drops below it again, rather than shedding on every frame.
+static size_t enforce_budget(MinimalTui *tui) {
+  IModule *shown = tui->state == UI_MODULE ? tui->active_module : NULL;
+  for (int i = 0; i < tui->module_count; ++i) {
+    IModule *mod = tui->modules[i];
+    if (mod->on_idle && mod != shown)
+      mod->on_idle(mod);
+  }
+  size_t total = minimal_tui_memory_usage(tui);
+  while (total > tui->memory_budget) {
+    ModuleEntry *biggest = NULL;
+    for (int i = 0; i < REGISTRY_SIZE; ++i) {
+      ModuleEntry *entry = &registry[i];
+      if (entry->disabled || !entry->deactivate || entry->module == tui->active_module)
+        continue;
+      if (entry_memory(entry) > 0 && (!biggest || entry_memory(entry) > entry_memory(biggest)))
+        biggest = entry;
+    }
+    if (!biggest)
+      break;
+    biggest->deactivate();
+    size_t after = minimal_tui_memory_usage(tui);
+    if (after >= total)
+      break; // its close failed, it stays loaded
+    total = after;
+  }
+  return total;
+}
+
+// "512K", "1.4M"
+static void format_bytes(char *buf, size_t size, size_t bytes) {
+  if (bytes < 1024 * 1024)
+    snprintf(buf, size, "%zuK", (bytes + 1023) / 1024);
+  else
+    snprintf(buf, size, "%.1fM", bytes / (1024.0 * 1024.0));
+}
+
+static void draw_panel(WindowManager *wm, IModule **modules, int count, int selected) {
   werase(wm->panel_win);
   mvwprintw(wm->panel_win, 1, 2, "Select a module:");
 
-  for (int i = 0; i < NUM_MODULES_IMPL; ++i) {
+  for (int i = 0; i < count; ++i) {
     if (i == selected) {
       wattron(wm->panel_win, A_REVERSE);
     }
-    mvwprintw(wm->panel_win, 3 + i, 4, "%s", all_modules[i]->name);
+    mvwprintw(wm->panel_win, 3 + i, 4, "%s", modules[i]->name);
     if (i == selected) {
       wattroff(wm->panel_win, A_REVERSE);
     }
@@ -54,10 +353,84 @@ static void draw_panel(WindowManager *wm, int selected) {
   wnoutrefresh(wm->panel_win);
 }
 
-static void draw_status(WindowManager *wm, const char *message) {
-  werase(wm->status_win);
-  mvwprintw(wm->status_win, 0, 1, "%s", message);
-  wnoutrefresh(wm->status_win);
+static void draw_status(MinimalTui *tui, const char *message) {
+  // the status line only changes with the ui state or the pomodoro clock
+  if (!tui->dirty && !tui->status_dirty && tui->status_msg == message)
+    return;
+  werase(tui->wm.status_win);
+  const char *text = message;
+  char profile[256];
+  if (tui->profiler_overlay) {
+    size_t width = tui->wm.cols > 2 ? (size_t)tui->wm.cols - 2 : 1;
+    IModule *mod = tui->state == UI_MODULE ? tui->active_module : NULL;
+    profiler_overlay_text(profile, width < sizeof(profile) ? width : sizeof(profile), mod);
+    text = profile;
+  }
+  const char *flash = notify_flash_text();
+  if (flash) {
+    wattron(tui->wm.status_win, A_REVERSE | A_BOLD);
+    mvwprintw(tui->wm.status_win, 0, 1, " %s ", flash);
+    wattroff(tui->wm.status_win, A_REVERSE | A_BOLD);
+  } else {
+    mvwprintw(tui->wm.status_win, 0, 1, "%s", text);
+  }
+
+  // memory in use (against the budget, when there is one), then the pomodoro
+  char right[96], used[16], budget[16], pomo[32];
+  format_bytes(used, sizeof(used), tui->memory_shown);
+  int n = snprintf(right, sizeof(right), "mem ~%s", used);
+  if (tui->memory_budget) {
+    format_bytes(budget, sizeof(budget), tui->memory_budget);
+    n += snprintf(right + n, sizeof(right) - (size_t)n, "/%s%s", budget,
+                  tui->over_budget ? " over budget" : "");
+  }
+  if (pomodoro_status_text(pomo, sizeof(pomo)))
+    snprintf(right + n, sizeof(right) - (size_t)n, "  %s", pomo);
+  int x = tui->wm.cols - (int)strlen(right) - 1;
+  if (x > (int)strlen(text) + 2)
+    mvwprintw(tui->wm.status_win, 0, x, "%s", right);
+  wnoutrefresh(tui->wm.status_win);
+  tui->status_msg = message;
+  tui->status_dirty = false;
+}
+
+void imodule_invalidate(IModule *self) {
+  self->dirty = true;
+  self->full_redraw = true;
+}
+
+void imodule_invalidate_rows(IModule *self, int top, int bottom) {
+  if (top > bottom || bottom < 0)
+    return;
+  if (!self->dirty) {
+    self->dirty = true;
+    self->full_redraw = false;
+    self->dirty_top = top;
+    self->dirty_bottom = bottom;
+    return;
+  }
+  if (top < self->dirty_top)
+    self->dirty_top = top;
+  if (bottom > self->dirty_bottom)
+    self->dirty_bottom = bottom;
+}
+
+bool imodule_row_dirty(const IModule *self, int y) {
+  return self->full_redraw || (y >= self->dirty_top && y <= self->dirty_bottom);
+}
+
+void minimal_tui_invalidate(MinimalTui *tui) {
+  tui->dirty = true;
+  if (tui->active_module)
+    imodule_invalidate(tui->active_module);
+}
+
+// the module on screen goes off it
+static void leave_module(MinimalTui *tui) {
+  IModule *mod = tui->active_module;
+  tui->active_module = NULL;
+  if (mod && mod->on_leave)
+    mod->on_leave(mod);
 }
 
 void minimal_tui_init(MinimalTui *tui) {
@@ -68,17 +441,55 @@ void minimal_tui_init(MinimalTui *tui) {
   tui->selected = 0;
   tui->running = true;
   tui->active_module = NULL;
-  tui->last_tick = time(NULL);
+  tui->tick_timer = -1;
+  tui->dirty = true;
+  tui->status_dirty = false;
+  tui->status_msg = NULL;
+  tui->profiler_overlay = false;
+  tui->profiler_timer = -1;
+  tui->frames_rendered = 0;
+  tui->frames_skipped = 0;
+
+  tui->idle_timer = -1;
+  tui->memory_budget = 0;
+  tui->memory_shown = 0;
+  tui->over_budget = false;
+  tui->preload = true;
+  tui->preload_timer = -1;
+  tui->preload_next = 0;
 
-  for (int i = 0; i < NUM_MODULES_IMPL; ++i) {
-    tui->modules[i] = all_modules[i];
+  // disabled modules never make it in, so nothing of theirs gets loaded.
+  // the rest load on first use or in the warm-up after the first frame
+  tui->module_count = 0;
+  for (int i = 0; i < NUM_MODULES; ++i)
+    tui->modules[i] = NULL;
+  for (int i = 0; i < REGISTRY_SIZE && tui->module_count < NUM_MODULES; ++i) {
+    if (!registry[i].disabled)
+      tui->modules[tui->module_count++] = registry[i].module;
   }
-  // Data for modules is handled statically within the modules themselves
-  
-  pomodoro_init();
+
+  keymap_set_handler(dispatch_action, tui);
+  notify_init(status_changed_cb, tui);
+  day_clock_init(day_changed_cb, tui);
+  restart_idle_timer(tui);
 }
 
 void minimal_tui_cleanup(MinimalTui *tui) {
+  palette_close(tui);
+  leave_module(tui);
+  pomodoro_cleanup();
+  event_loop_timer_stop(tui->tick_timer);
+  tui->tick_timer = -1;
+  event_loop_timer_stop(tui->profiler_timer);
+  tui->profiler_timer = -1;
+  event_loop_timer_stop(tui->preload_timer);
+  tui->preload_timer = -1;
+  event_loop_timer_stop(tui->idle_timer);
+  tui->idle_timer = -1;
+  keymap_cancel();
+  keymap_set_handler(NULL, NULL);
+  notify_cleanup();
+  day_clock_cleanup();
   wm_cleanup(&tui->wm);
   // No need to free module data as it's static
 }
@@ -88,15 +499,13 @@ void minimal_tui_resize(MinimalTui *tui) {
   getmaxyx(stdscr, rows, cols);
   wm_cleanup(&tui->wm);
   wm_init(&tui->wm, rows, cols);
+  minimal_tui_invalidate(tui); // fresh windows start out blank
 }
 
 void minimal_tui_render(MinimalTui *tui) {
-  time_t current_time = time(NULL);
-  
-  // only update pomodoro if it's active
-  if (tui->active_module == &module_pomodoro && current_time != tui->last_tick) {
-    pomodoro_module_tick(tui->active_module);
-    tui->last_tick = current_time;
+  if (tui->state == UI_EXIT) {
+    tui->running = false;
+    return;
   }
 
   int rows, cols;
@@ -108,6 +517,31 @@ void minimal_tui_render(MinimalTui *tui) {
     werase(stdscr);
   }
 
+  // loads, searches and edits all move the numbers, so this is where they
+  // are checked; reading them is a handful of counters
+  size_t memory = minimal_tui_memory_usage(tui);
+  bool over = tui->memory_budget && memory > tui->memory_budget;
+  if (over && !tui->over_budget && !palette_is_open()) {
+    memory = enforce_budget(tui);
+    tui->over_budget = memory > tui->memory_budget;
+    tui->status_dirty = true;
+  } else if (!over && tui->over_budget) {
+    tui->over_budget = false;
+    tui->status_dirty = true;
+  }
+  if (memory != tui->memory_shown) {
+    tui->memory_shown = memory;
+    tui->status_dirty = true;
+  }
+
+  IModule *mod = tui->state == UI_MODULE ? tui->active_module : NULL;
+  if (!tui->dirty && !tui->status_dirty && !(mod && mod->dirty) &&
+      !palette_is_dirty()) {
+    tui->frames_skipped++;
+    return;
+  }
+  uint64_t started = event_loop_now();
+
   if (tui->wm.cols < 60 || tui->wm.rows < 20) {
     werase(stdscr);
     const char *msg1 = "terminal too small!";
@@ -120,56 +554,139 @@ void minimal_tui_render(MinimalTui *tui) {
       mvprintw(y1, x1, "%s", msg1);
     if (y2 >= 0 && x2 >= 0 && y2 < tui->wm.rows)
       mvprintw(y2, x2, "%s", msg2);
+    wnoutrefresh(stdscr);
+    // whatever gets drawn once the terminal is big enough must start over
+    tui->status_msg = NULL;
+    tui->status_dirty = false;
+    if (mod)
+      imodule_invalidate(mod);
   } else {
     switch (tui->state) {
     case UI_PANEL:
-      draw_panel(&tui->wm, tui->selected);
-      draw_status(&tui->wm, "panel: arrows to move, enter to select, q to quit");
+      draw_panel(&tui->wm, tui->modules, tui->module_count, tui->selected);
+      draw_status(tui, "panel: arrows to move, enter to select, q to quit");
       break;
     case UI_MODULE:
-      if (tui->active_module && tui->active_module->render) {
-        tui->active_module->render(tui->active_module, tui->wm.panel_win);
+      if (mod && mod->render) {
+        if (tui->dirty)
+          imodule_invalidate(mod);
+        uint64_t render_started = event_loop_now();
+        mod->render(mod, tui->wm.panel_win);
+        profiler_module_render(mod, event_loop_now() - render_started);
+        mod->dirty = false;
+        mod->full_redraw = false;
       }
-      draw_status(&tui->wm, "module: b to back, q to quit");
+      draw_status(tui, "module: b to back, q to quit");
       break;
-    case UI_SETTINGS:
+    default:
       break;
-    case UI_EXIT:
-      tui->running = false;
-      return;
     }
+    if (palette_is_open())
+      palette_render(tui);
   }
-  doupdate();
-  refresh();
+  tui->dirty = false;
+  tui->frames_rendered++;
+  if (tui->frames_rendered == 1 && tui->preload)
+    tui->preload_timer = event_loop_timer_start(preload_cb, tui, event_loop_now(), 0);
+  if (headless_active())
+    headless_update(started); // meters the frame on its way out
+  else
+    doupdate();
+  profiler_record(PROFILE_FRAME, event_loop_now() - started);
 }
 
-void minimal_tui_handle_input(MinimalTui *tui, int ch) {
+void minimal_tui_activate(MinimalTui *tui, int index) {
+  if (index < 0 || index >= tui->module_count)
+    return;
+  for (int i = 0; i < REGISTRY_SIZE; ++i) {
+    if (registry[i].module == tui->modules[index] && registry[i].activate)
+      registry[i].activate();
+  }
+}
+
+void minimal_tui_open_module(MinimalTui *tui, int index) {
+  minimal_tui_activate(tui, index);
+  IModule *mod = tui->modules[index];
+  if (mod != tui->active_module) {
+    leave_module(tui);
+    tui->active_module = mod;
+  }
+  tui->selected = index;
+  tui->state = UI_MODULE;
+  minimal_tui_invalidate(tui);
+}
+
+// everything but typing (in the palette or a module's text field) arrives
+// here already resolved
+static void dispatch_action(InputAction action, int key, void *ctx) {
+  MinimalTui *tui = ctx;
+  if (action == ACTION_PROFILER) {
+    toggle_profiler(tui);
+    return;
+  }
+  if (action == ACTION_SEARCH && (tui->state == UI_PANEL || tui->state == UI_MODULE)) {
+    palette_open(tui);
+    return;
+  }
+
   switch (tui->state) {
   case UI_PANEL:
-    if (ch == KEY_UP)
-      tui->selected = (tui->selected - 1 + NUM_MODULES_IMPL) % NUM_MODULES_IMPL;
-    else if (ch == KEY_DOWN)
-      tui->selected = (tui->selected + 1) % NUM_MODULES_IMPL;
-    else if (ch == '\n' || ch == KEY_ENTER) {
-      tui->state = UI_MODULE;
-      tui->active_module = tui->modules[tui->selected];
-    } else if (ch == 'q')
+    if (tui->module_count == 0) {
+      if (action == ACTION_EXIT)
+        tui->state = UI_EXIT; // everything switched off in settings.json
+    } else if (action == ACTION_UP) {
+      tui->selected = (tui->selected - 1 + tui->module_count) % tui->module_count;
+      tui->dirty = true;
+    } else if (action == ACTION_DOWN) {
+      tui->selected = (tui->selected + 1) % tui->module_count;
+      tui->dirty = true;
+    } else if (action == ACTION_CONFIRM) {
+      minimal_tui_open_module(tui, tui->selected);
+    } else if (action == ACTION_EXIT)
       tui->state = UI_EXIT;
     break;
   case UI_MODULE:
-    if (ch == 'b') {
+    if (action == ACTION_BACK) {
       tui->state = UI_PANEL;
-      tui->active_module = NULL;
-    } else if (ch == 'q') {
+      leave_module(tui);
+      minimal_tui_invalidate(tui);
+    } else if (action == ACTION_EXIT) {
         tui->state = UI_EXIT;
     }
     else if (tui->active_module && tui->active_module->handle_input) {
-      tui->active_module->handle_input(tui->active_module, ch, tui);
+      IModule *mod = tui->active_module;
+      uint64_t input_started = event_loop_now();
+      mod->handle_input(mod, action, key, tui);
+      profiler_module_input(mod, event_loop_now() - input_started);
     }
     break;
   default:
     break;
   }
+  if (tui->active_module == &module_pomodoro)
+    tui->status_dirty = true; // start/pause/reset show up in the status bar
+  sync_tick_timer(tui);
+}
+
+void minimal_tui_handle_input(MinimalTui *tui, int ch) {
+  restart_idle_timer(tui);
+  if (palette_is_open()) {
+    palette_handle_key(tui, ch); // a query is text, not bindings
+    sync_tick_timer(tui);
+    return;
+  }
+  IModule *mod = tui->state == UI_MODULE ? tui->active_module : NULL;
+  if (mod && mod->takes_text && mod->takes_text(mod)) {
+    // typed text: a bound letter is a letter here, and no chord waits
+    InputAction action = ACTION_NONE;
+    if (ch == '\n' || ch == '\r' || ch == KEY_ENTER)
+      action = ACTION_CONFIRM;
+    else if (ch == 27)
+      action = ACTION_CANCEL;
+    dispatch_action(action, ch, tui);
+    return;
+  }
+  keymap_feed(mod ? mod->name : NULL, ch);
 }
 
 bool minimal_tui_is_running(const MinimalTui *tui) { return tui->running; }
@@ -180,8 +697,9 @@ void placeholder_render(IModule *self, WINDOW *win) {
   wnoutrefresh(win);
 }
 
-void placeholder_handle_input(IModule *self, int ch, MinimalTui *tui) {
+void placeholder_handle_input(IModule *self, InputAction action, int key, MinimalTui *tui) {
   (void)self;
-  (void)ch;
+  (void)action;
+  (void)key;
   (void)tui;
 }
\ No newline at end of file
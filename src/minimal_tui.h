@@ -3,6 +3,7 @@
 
 #include <ncurses.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <time.h>
 #include "../modules/imodule.h"
 
@@ -27,21 +28,50 @@ typedef struct MinimalTui {
     UiState state;
     int selected;
     bool running;
-    IModule* modules[NUM_MODULES];
+    IModule* modules[NUM_MODULES]; // the enabled ones, in panel order
+    int module_count;
     IModule* active_module;
-    time_t last_tick;
+    int tick_timer; // event loop timer for the modules' next tick, -1 when idle
+    int idle_timer; // runs the modules' on_idle after a quiet minute
+
+    bool dirty;              // panel/status need a repaint
+    bool status_dirty;       // only the status line changed
+    const char* status_msg;  // what status_win currently shows
+    bool profiler_overlay;   // status_win shows the profiler's numbers instead
+    int profiler_timer;      // refreshes them once a second while shown
+    unsigned long frames_rendered;
+    unsigned long frames_skipped;
+    size_t memory_budget;    // bytes; over it modules shed caches, 0 for none
+    size_t memory_shown;     // what the status line says is in use
+    bool over_budget;        // shedding ran and wasn't enough; it waits until usage drops below
+    bool preload;            // load enabled modules' data after the first frame
+    int preload_timer;
+    int preload_next;        // modules[] index the next wakeup activates
 } MinimalTui;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// reads the "module_activity" object of settings.json: "Tasks": false
+// leaves the module off the panel and never loads its data. modules it
+// doesn't name are enabled. call before minimal_tui_init; returns 0 when
+// the file was used, 1 when there is none and -1 when it doesn't parse
+// (everything stays enabled then).
+int minimal_tui_load_activity(const char* path);
 void minimal_tui_init(MinimalTui* tui);
 void minimal_tui_cleanup(MinimalTui* tui);
 void minimal_tui_resize(MinimalTui* tui);
 void minimal_tui_render(MinimalTui* tui);
+void minimal_tui_invalidate(MinimalTui* tui);
 void minimal_tui_handle_input(MinimalTui* tui, int ch);
+// loads what modules[index] needs, once
+void minimal_tui_activate(MinimalTui* tui, int index);
+// switches to modules[index], as choosing it on the panel does
+void minimal_tui_open_module(MinimalTui* tui, int index);
 bool minimal_tui_is_running(const MinimalTui* tui);
+// what the modules and the windows hold, in bytes
+size_t minimal_tui_memory_usage(const MinimalTui* tui);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,170 @@
+#include "notify.h"
+#include "config.h"
+#include "event_loop.h"
+#include <fcntl.h>
+#include <ncurses.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+typedef struct {
+  NotifyStepKind kind;
+  uint64_t due;
+} NotifyStep;
+
+static struct {
+  NotifyStep steps[NOTIFY_MAX_STEPS];
+  int step_count;
+  int timer;
+  bool flashing;
+  char text[NOTIFY_TEXT_LENGTH];
+  pid_t hooks[NOTIFY_MAX_HOOKS]; // spawned hook commands not reaped yet
+  void (*on_change)(void *ctx);
+  void *ctx;
+} notify = {.timer = -1};
+
+static void arm_timer(void);
+
+// a hook may outlive the alert by far; it is reaped when its SIGCHLD comes
+// through the event loop rather than left a zombie holding its slot
+static void reap_hooks(void *ctx) {
+  (void)ctx;
+  for (int i = 0; i < NOTIFY_MAX_HOOKS; ++i) {
+    if (notify.hooks[i] > 0 && waitpid(notify.hooks[i], NULL, WNOHANG) != 0)
+      notify.hooks[i] = 0;
+  }
+}
+
+// runs the hook through the shell with output discarded; never waits for it
+static void spawn_hook(void) {
+  const char *cmd = config_get("alert_hook");
+  if (!cmd || !cmd[0])
+    return;
+
+  int slot = -1;
+  for (int i = 0; i < NOTIFY_MAX_HOOKS; ++i) {
+    if (notify.hooks[i] == 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0)
+    return; // previous hooks still running, don't pile up more
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+  // the event loop blocks SIGWINCH and SIGCHLD; the hook starts with nothing blocked
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t mask;
+  sigemptyset(&mask);
+  posix_spawnattr_setsigmask(&attr, &mask);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+  setenv("ZINC_ALERT", notify.text, 1);
+  char *argv[] = {"sh", "-c", (char *)cmd, NULL};
+  pid_t pid;
+  if (posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ) == 0)
+    notify.hooks[slot] = pid;
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+}
+
+static void run_step(NotifyStepKind kind) {
+  switch (kind) {
+  case NOTIFY_BELL:
+    beep(); // queues a BEL on the terminal, doesn't wait for it
+    break;
+  case NOTIFY_FLASH_ON:
+  case NOTIFY_FLASH_OFF:
+    notify.flashing = kind == NOTIFY_FLASH_ON;
+    if (notify.on_change)
+      notify.on_change(notify.ctx);
+    break;
+  case NOTIFY_HOOK:
+    spawn_hook();
+    break;
+  }
+}
+
+static void timer_cb(void *ctx) {
+  (void)ctx;
+  notify.timer = -1;
+  uint64_t now = event_loop_now();
+  // steps may be queued out of order, run every due one and compact
+  int kept = 0;
+  for (int i = 0; i < notify.step_count; ++i) {
+    if (notify.steps[i].due <= now)
+      run_step(notify.steps[i].kind);
+    else
+      notify.steps[kept++] = notify.steps[i];
+  }
+  notify.step_count = kept;
+  arm_timer();
+}
+
+static void arm_timer(void) {
+  event_loop_timer_stop(notify.timer);
+  notify.timer = -1;
+  if (notify.step_count == 0)
+    return;
+  uint64_t due = notify.steps[0].due;
+  for (int i = 1; i < notify.step_count; ++i) {
+    if (notify.steps[i].due < due)
+      due = notify.steps[i].due;
+  }
+  notify.timer = event_loop_timer_start(timer_cb, NULL, due, 0);
+}
+
+void notify_init(void (*on_change)(void *ctx), void *ctx) {
+  notify.on_change = on_change;
+  notify.ctx = ctx;
+  notify.step_count = 0;
+  notify.flashing = false;
+  notify.timer = -1;
+  event_loop_on_child(reap_hooks, NULL);
+}
+
+void notify_cleanup(void) {
+  event_loop_timer_stop(notify.timer);
+  notify.timer = -1;
+  notify.step_count = 0;
+  event_loop_on_child(NULL, NULL);
+  reap_hooks(NULL);
+}
+
+void notify_push_step(NotifyStepKind kind, unsigned delay_ms) {
+  if (notify.step_count >= NOTIFY_MAX_STEPS)
+    return;
+  NotifyStep *step = &notify.steps[notify.step_count++];
+  step->kind = kind;
+  step->due = event_loop_now() + (uint64_t)delay_ms * NSEC_PER_MSEC;
+  arm_timer();
+}
+
+void notify_alert(const char *message) {
+  strncpy(notify.text, message, NOTIFY_TEXT_LENGTH - 1);
+  notify.text[NOTIFY_TEXT_LENGTH - 1] = '\0';
+
+  // three bells 300 ms apart, like the old inline beep()/napms() loop
+  notify_push_step(NOTIFY_FLASH_ON, 0);
+  notify_push_step(NOTIFY_HOOK, 0);
+  notify_push_step(NOTIFY_BELL, 0);
+  notify_push_step(NOTIFY_BELL, 300);
+  notify_push_step(NOTIFY_BELL, 600);
+  notify_push_step(NOTIFY_FLASH_OFF, 3000);
+}
+
+const char *notify_flash_text(void) {
+  return notify.flashing ? notify.text : NULL;
+}
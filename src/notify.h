@@ -0,0 +1,38 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdbool.h>
+
+#define NOTIFY_MAX_STEPS 16
+#define NOTIFY_MAX_HOOKS 4
+#define NOTIFY_TEXT_LENGTH 64
+
+typedef enum {
+    NOTIFY_BELL,
+    NOTIFY_FLASH_ON,
+    NOTIFY_FLASH_OFF,
+    NOTIFY_HOOK
+} NotifyStepKind;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// on_change runs whenever the status bar flash appears or goes away
+void notify_init(void (*on_change)(void* ctx), void* ctx);
+void notify_cleanup(void);
+
+// queues a timed alert sequence (bells, a status bar flash and the
+// alert_hook command from settings.conf) and returns immediately. each step
+// is fired by an event loop timer, input keeps flowing in between.
+void notify_alert(const char* message);
+void notify_push_step(NotifyStepKind kind, unsigned delay_ms);
+
+// text to flash in the status bar, NULL when no flash is showing
+const char* notify_flash_text(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,227 @@
+#include "palette.h"
+#include "../modules/gram_index.h"
+#include "../modules/habit_manager.h"
+#include "../modules/task_manager.h"
+#include "event_loop.h"
+#include "minimal_tui.h"
+#include <ncurses.h>
+#include <string.h>
+
+#define PALETTE_WIDTH 70
+
+// searchable module data; hits reveal into the module of the same name
+typedef struct {
+  const char *module;
+  int (*search)(const GramQuery *query, GramHit *hits, int max);
+  const char *(*text)(int doc);
+  void (*reveal)(int doc);
+} PaletteSource;
+
+static const PaletteSource sources[] = {
+    {"Habits", habits_search, habits_hit_text, habits_reveal},
+    {"Tasks", tasks_search, tasks_hit_text, tasks_reveal},
+};
+#define NUM_SOURCES (int)(sizeof(sources) / sizeof(sources[0]))
+
+typedef struct {
+  int source; // index into sources, -1 for a module itself
+  int doc;    // the module's index for a module
+  int score;
+} PaletteEntry;
+
+static struct {
+  bool open;
+  bool dirty;
+  WINDOW *win;
+  char query[GRAM_QUERY_LENGTH];
+  int length;
+  PaletteEntry results[PALETTE_RESULTS];
+  int result_count;
+  int selected;
+  uint64_t search_ns; // what the last keystroke's search took
+} palette;
+
+// keeps results best first; equal scores stay in arrival order
+static void add_result(PaletteEntry entry) {
+  int i = palette.result_count;
+  if (i == PALETTE_RESULTS) {
+    if (palette.results[i - 1].score >= entry.score)
+      return;
+    i--;
+  } else {
+    palette.result_count++;
+  }
+  while (i > 0 && palette.results[i - 1].score < entry.score) {
+    palette.results[i] = palette.results[i - 1];
+    i--;
+  }
+  palette.results[i] = entry;
+}
+
+static int module_index(MinimalTui *tui, const char *name);
+
+static void search(MinimalTui *tui) {
+  uint64_t started = event_loop_now();
+  palette.result_count = 0;
+  palette.selected = 0;
+
+  GramQuery query;
+  gram_query_parse(&query, palette.query);
+  for (int i = 0; i < NUM_MODULES && tui->modules[i]; ++i) {
+    const char *name = tui->modules[i]->name;
+    // an empty query lists the modules
+    int score = query.word_count == 0 ? 0 : gram_query_match(&query, name, strlen(name));
+    if (score >= 0) {
+      PaletteEntry entry = {-1, i, score};
+      add_result(entry);
+    }
+  }
+
+  if (query.word_count > 0) {
+    GramHit hits[PALETTE_RESULTS];
+    for (int s = 0; s < NUM_SOURCES; ++s) {
+      if (module_index(tui, sources[s].module) < 0)
+        continue; // switched off in settings.json
+      int n = sources[s].search(&query, hits, PALETTE_RESULTS);
+      for (int i = 0; i < n; ++i) {
+        PaletteEntry entry = {s, hits[i].doc, hits[i].score};
+        add_result(entry);
+      }
+    }
+  }
+
+  palette.search_ns = event_loop_now() - started;
+  palette.dirty = true;
+}
+
+static int module_index(MinimalTui *tui, const char *name) {
+  for (int i = 0; i < NUM_MODULES && tui->modules[i]; ++i) {
+    if (strcmp(tui->modules[i]->name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static void activate(MinimalTui *tui, const PaletteEntry *entry) {
+  if (entry->source < 0) {
+    minimal_tui_open_module(tui, entry->doc);
+    return;
+  }
+  const PaletteSource *source = &sources[entry->source];
+  int index = module_index(tui, source->module);
+  if (index < 0)
+    return;
+  source->reveal(entry->doc);
+  minimal_tui_open_module(tui, index);
+}
+
+void palette_open(MinimalTui *tui) {
+  // the sources search their module's data, so it has to be there
+  for (int s = 0; s < NUM_SOURCES; ++s)
+    minimal_tui_activate(tui, module_index(tui, sources[s].module));
+  palette.open = true;
+  palette.query[0] = '\0';
+  palette.length = 0;
+  search(tui);
+}
+
+void palette_close(MinimalTui *tui) {
+  if (!palette.open)
+    return;
+  palette.open = false;
+  if (palette.win) {
+    delwin(palette.win);
+    palette.win = NULL;
+  }
+  minimal_tui_invalidate(tui); // uncover what was underneath
+}
+
+bool palette_is_open(void) { return palette.open; }
+
+bool palette_is_dirty(void) { return palette.open && palette.dirty; }
+
+void palette_handle_key(MinimalTui *tui, int ch) {
+  if (ch == 27) { // esc
+    palette_close(tui);
+  } else if (ch == '\n' || ch == KEY_ENTER) {
+    PaletteEntry entry = palette.results[palette.selected];
+    bool chosen = palette.result_count > 0;
+    palette_close(tui);
+    if (chosen)
+      activate(tui, &entry);
+  } else if (ch == KEY_UP) {
+    if (palette.selected > 0)
+      palette.selected--;
+    palette.dirty = true;
+  } else if (ch == KEY_DOWN) {
+    if (palette.selected < palette.result_count - 1)
+      palette.selected++;
+    palette.dirty = true;
+  } else if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
+    if (palette.length > 0) {
+      palette.query[--palette.length] = '\0';
+      search(tui);
+    }
+  } else if (ch >= ' ' && ch < 256 && palette.length < GRAM_QUERY_LENGTH - 1) {
+    palette.query[palette.length++] = (char)ch;
+    palette.query[palette.length] = '\0';
+    search(tui);
+  }
+}
+
+void palette_render(MinimalTui *tui) {
+  int width = tui->wm.cols - 4 < PALETTE_WIDTH ? tui->wm.cols - 4 : PALETTE_WIDTH;
+  int height = PALETTE_RESULTS + 4; // border, query, results, footer
+  int y = 2;
+  int x = (tui->wm.cols - width) / 2;
+
+  int cur_h = 0, cur_w = 0;
+  if (palette.win)
+    getmaxyx(palette.win, cur_h, cur_w);
+  if (!palette.win || cur_h != height || cur_w != width) {
+    if (palette.win)
+      delwin(palette.win);
+    palette.win = newwin(height, width, y, x);
+  } else {
+    mvwin(palette.win, y, x);
+  }
+  if (!palette.win)
+    return;
+
+  WINDOW *win = palette.win;
+  werase(win);
+  box(win, 0, 0);
+  mvwprintw(win, 1, 2, "/ %.*s", width - 6, palette.query);
+
+  for (int i = 0; i < palette.result_count; ++i) {
+    const PaletteEntry *entry = &palette.results[i];
+    const char *label, *text;
+    bool head = false;
+    if (entry->source < 0) {
+      label = "Module";
+      text = tui->modules[entry->doc]->name;
+    } else {
+      label = sources[entry->source].module;
+      text = sources[entry->source].text(entry->doc);
+      head = entry->doc < 0;
+    }
+    if (!text)
+      continue;
+
+    if (i == palette.selected)
+      wattron(win, A_REVERSE);
+    mvwprintw(win, 2 + i, 2, "%-7s ", label);
+    waddnstr(win, text, width - 14);
+    if (head)
+      waddch(win, ':');
+    if (i == palette.selected)
+      wattroff(win, A_REVERSE);
+  }
+
+  mvwprintw(win, height - 1, 2, " %.2f ms ", palette.search_ns / 1e6);
+
+  // the layers below may have repainted over the overlay this frame
+  touchwin(win);
+  wnoutrefresh(win);
+  palette.dirty = false;
+}
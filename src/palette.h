@@ -0,0 +1,30 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdbool.h>
+
+#define PALETTE_RESULTS 10
+
+struct MinimalTui;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the '/' palette: an overlay that searches module names, tasks, habits and
+// their heads as the query is typed, and jumps to the chosen one
+void palette_open(struct MinimalTui* tui);
+void palette_close(struct MinimalTui* tui);
+bool palette_is_open(void);
+// true when the overlay has to be drawn again
+bool palette_is_dirty(void);
+// takes every key while open
+void palette_handle_key(struct MinimalTui* tui, int ch);
+// draws the overlay on top of whatever the frame drew below it
+void palette_render(struct MinimalTui* tui);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
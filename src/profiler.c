@@ -0,0 +1,126 @@
+#include "profiler.h"
+#include "../modules/persist.h"
+#include "event_loop.h"
+#include <stdio.h>
+#include <time.h>
+
+#define MAX_IDLE_SECONDS 3600 // zeros recorded for one quiet stretch, at most
+
+typedef struct {
+  const IModule *mod;
+  HdrHist render;
+  HdrHist input;
+} ModuleProfile;
+
+static HdrHist histograms[PROFILE_COUNT];
+static ModuleProfile modules[PROFILER_MAX_MODULES];
+static int module_count;
+
+static struct {
+  uint64_t second; // of the wakeups being counted
+  uint32_t count;
+  uint32_t last_rate; // wakeups in the last whole second
+} wakeups = {.second = UINT64_MAX};
+
+void profiler_record(ProfileKind kind, uint64_t value) {
+  hdr_record(&histograms[kind], value);
+}
+
+void profiler_wakeup(uint64_t now) {
+  uint64_t second = now / NSEC_PER_SEC;
+  if (second != wakeups.second) {
+    if (wakeups.second != UINT64_MAX) {
+      hdr_record(&histograms[PROFILE_WAKEUPS], wakeups.count);
+      // an idle loop is the point, so silent seconds belong in the numbers
+      uint64_t idle = second - wakeups.second - 1;
+      if (idle > MAX_IDLE_SECONDS)
+        idle = MAX_IDLE_SECONDS;
+      hdr_record_n(&histograms[PROFILE_WAKEUPS], 0, (uint32_t)idle);
+      wakeups.last_rate = idle > 0 ? 0 : wakeups.count;
+    }
+    wakeups.second = second;
+    wakeups.count = 0;
+  }
+  wakeups.count++;
+}
+
+static ModuleProfile *profile_of(const IModule *mod) {
+  for (int i = 0; i < module_count; i++) {
+    if (modules[i].mod == mod)
+      return &modules[i];
+  }
+  if (module_count == PROFILER_MAX_MODULES)
+    return NULL;
+  modules[module_count].mod = mod;
+  return &modules[module_count++];
+}
+
+void profiler_module_render(const IModule *mod, uint64_t ns) {
+  ModuleProfile *p = profile_of(mod);
+  if (p)
+    hdr_record(&p->render, ns);
+}
+
+void profiler_module_input(const IModule *mod, uint64_t ns) {
+  ModuleProfile *p = profile_of(mod);
+  if (p)
+    hdr_record(&p->input, ns);
+}
+
+const HdrHist *profiler_histogram(ProfileKind kind) {
+  return &histograms[kind];
+}
+
+// --- Output ---
+
+static size_t put_pair(char *out, size_t size, size_t pos, const char *label, const HdrHist *h) {
+  if (pos >= size || h->count == 0)
+    return pos;
+  int n = snprintf(out + pos, size - pos, " %s %.2f/%.2f", label,
+                   hdr_value_at(h, 50) / 1e6, hdr_value_at(h, 99) / 1e6);
+  return n > 0 ? pos + (size_t)n : pos;
+}
+
+void profiler_overlay_text(char *out, size_t size, const IModule *mod) {
+  if (size == 0)
+    return;
+  int n = snprintf(out, size, "p50/p99 ms:");
+  size_t pos = n > 0 ? (size_t)n : 0;
+  pos = put_pair(out, size, pos, "key", &histograms[PROFILE_INPUT_LATENCY]);
+  pos = put_pair(out, size, pos, "frame", &histograms[PROFILE_FRAME]);
+  ModuleProfile *p = mod ? profile_of(mod) : NULL;
+  if (p) {
+    pos = put_pair(out, size, pos, mod->name, &p->render);
+    pos = put_pair(out, size, pos, "+in", &p->input);
+  }
+  pos = put_pair(out, size, pos, "save", persist_histogram(PERSIST_STAT_JOURNAL));
+  if (pos < size)
+    snprintf(out + pos, size - pos, "  %u wakeups/s", wakeups.last_rate);
+}
+
+static void write_section(FILE *f, const char *title, const HdrHist *h, double scale) {
+  if (h->count == 0)
+    return;
+  fprintf(f, "\n## %s\n", title);
+  hdr_write(h, f, scale);
+}
+
+int profiler_dump(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return 1;
+  fprintf(f, "# zinc profile, %ld; values in ms unless noted\n", (long)time(NULL));
+  write_section(f, "input latency", &histograms[PROFILE_INPUT_LATENCY], 1e6);
+  write_section(f, "frame", &histograms[PROFILE_FRAME], 1e6);
+  write_section(f, "wakeups per second (count)", &histograms[PROFILE_WAKEUPS], 1.0);
+  char title[64];
+  for (int i = 0; i < module_count; i++) {
+    snprintf(title, sizeof(title), "%s render", modules[i].mod->name);
+    write_section(f, title, &modules[i].render, 1e6);
+    snprintf(title, sizeof(title), "%s input", modules[i].mod->name);
+    write_section(f, title, &modules[i].input, 1e6);
+  }
+  write_section(f, "snapshot saves", persist_histogram(PERSIST_STAT_SNAPSHOT), 1e6);
+  write_section(f, "journal appends", persist_histogram(PERSIST_STAT_JOURNAL), 1e6);
+  return fclose(f) == 0 ? 0 : 1;
+}
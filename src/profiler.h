@@ -0,0 +1,42 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../modules/hdr_hist.h"
+#include "../modules/imodule.h"
+
+#define PROFILER_MAX_MODULES 8
+
+// what the main loop and the frame pipeline report, in ns unless noted
+typedef enum {
+  PROFILE_INPUT_LATENCY, // key readable -> frame presented
+  PROFILE_FRAME,         // one minimal_tui_render that drew something
+  PROFILE_WAKEUPS,       // event loop wakeups per second (a count)
+  PROFILE_COUNT
+} ProfileKind;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// always on: every call is a clock read and a histogram increment
+void profiler_record(ProfileKind kind, uint64_t value);
+// one event loop wakeup at now; whole seconds without one count as zero
+void profiler_wakeup(uint64_t now);
+// time spent in a module's render or handle_input
+void profiler_module_render(const IModule *mod, uint64_t ns);
+void profiler_module_input(const IModule *mod, uint64_t ns);
+
+const HdrHist *profiler_histogram(ProfileKind kind);
+
+// one status line of p50/p99s, with the module's own numbers when given
+void profiler_overlay_text(char *out, size_t size, const IModule *mod);
+// every histogram, saves included, in .hgrm layout; 0 on success
+int profiler_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif